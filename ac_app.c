@@ -1,112 +1,731 @@
 #include <furi.h>
 #include <furi_hal_infrared.h>
+#include <furi_hal_rtc.h>
 #include <gui/gui.h>
 #include <input/input.h>
+#include <storage/storage.h>
+#include <stdatomic.h>
+#include "ac_ir_signals.h"
+#include "ac_journal.h"
+#include "ac_model.h"
+#include "ac_schedule.h"
+#include "ac_units.h"
+#include "event_trace.h"
+#include "infrared_fanout.h"
 #include "infrared_signal.h"
+#include "infrared_sequencer.h"
+#include "infrared_tx_worker.h"
 
-// Global variables.
+// Global constants.
 static const char* ac_on_text = "The A/C should be on.";
 static const char* ac_off_text = "The A/C should be off.";
-static bool ac_is_on = false;
 static const uint32_t one_hour_interval = 3600000; // 1 hour in milliseconds
 static const uint32_t three_hour_interval = 10800000; // 3 hours in milliseconds
-static uint32_t next_signal_interval = one_hour_interval;
-static uint32_t remaining_time = one_hour_interval; // Initial remaining time in milliseconds
 
-// Infrared signals to be used.
-static const uint32_t ir_address_1 = 0x00006F98; // The A/C itself
-static const uint32_t ir_command_1 = 0x0000E619; // Power button
-static const uint32_t ir_command_2 = 0x0000F708; // Mode button
+// Schedule file, used instead of the default 1 hour on, 3 hours off cycle when present.
+#define AC_SCHEDULE_PATH APP_DATA_PATH("schedule.txt")
 
-// Timers. Putting them here to avoid NULL pointer dereferences.
-static FuriTimer* signal_timer = NULL;
-static FuriTimer* countdown_timer = NULL;
+// Units file, used instead of the single default unit when present.
+#define AC_UNITS_PATH APP_DATA_PATH("units.txt")
+#define AC_UNIT_DEFAULT_GAP_MS (100U)
+// Time to listen for a verified unit to echo a frame once it has been sent.
+#define AC_UNIT_LISTEN_MS (150U)
+
+// State journal, resumed from at startup so that a restart neither sends anything nor loses the schedule phase.
+#define AC_JOURNAL_PATH APP_DATA_PATH("state.journal")
+
+// Event trace file, appended to when the app is idle for a while and when it exits,
+// and rotated into trace.bin.old once it reaches EVENT_TRACE_FILE_MAX_SIZE.
+#define AC_TRACE_PATH APP_DATA_PATH("trace.bin")
+#define AC_TRACE_DUMP_INTERVAL_MS (60000U)
+
+// Thread flag set by the timer thread once it has run every callback posted before.
+#define AC_APP_FLAG_TIMER_SYNC (1U << 0)
+
+// Event trace producers, one per thread recording events.
+typedef enum {
+    AcTraceProducerTx,
+    AcTraceProducerTimer,
+    AcTraceProducerGui,
+    AcTraceProducerCount,
+} AcTraceProducer;
+
+// Timers whose lateness is traced.
+typedef enum {
+    AcTraceTimerCountdown,
+} AcTraceTimer;
+
+// Schedule actions, besides the button names.
+static const char* ac_action_on = "on";
+static const char* ac_action_off = "off";
+
+// Signal of Ac.ir sent for each button, resolved at build time.
+static const AcIrSignal ac_button_signals[AcModelButtonCount] = {
+    [AcModelButtonPower] = AcIrSignalPower,
+    [AcModelButtonMode] = AcIrSignalMode,
+    [AcModelButtonFanSpeed] = AcIrSignalFanSpeed,
+    [AcModelButtonLowerTemp] = AcIrSignalLowerTemp,
+};
+
+// State machine of the A/C, as far as it is known: it powers on in its first mode, and Mode
+// steps through at least three modes. How many modes there are, and anything about the fan
+// speeds and setpoints, is not, so those are not tracked.
+static const AcModelSpec ac_model_spec = {
+    .mode = {.count = 3, .is_exact = false, .power_on = 0},
+    .fan_speed = {.count = 0, .is_exact = false, .power_on = AC_MODEL_ANY},
+    .temperature = {.count = 0, .is_exact = false, .power_on = AC_MODEL_ANY},
+};
+
+// State a unit is assumed to be in before the app first drives it.
+static const AcModelState ac_model_initial_state = {
+    .is_on = false,
+    .mode = AC_MODEL_UNKNOWN,
+    .fan_speed = AC_MODEL_UNKNOWN,
+    .temperature = AC_MODEL_UNKNOWN,
+};
+
+// States the "on" and "off" actions bring the units to: on in the third mode, or off.
+static const AcModelState ac_model_on_state = {
+    .is_on = true,
+    .mode = 2,
+    .fan_speed = AC_MODEL_ANY,
+    .temperature = AC_MODEL_ANY,
+};
+static const AcModelState ac_model_off_state = {
+    .is_on = false,
+    .mode = AC_MODEL_ANY,
+    .fan_speed = AC_MODEL_ANY,
+    .temperature = AC_MODEL_ANY,
+};
+
+// Most buttons pressed on one unit for one action, and the delay between two presses,
+// which should hopefully prevent weird states from occurring.
+#define AC_APP_PRESSES_MAX (8U)
+#define AC_APP_PRESS_DELAY_MS (1000U)
+
+// What the screen shows, published by the timer thread for the GUI thread.
+// The sequence is odd while a writer is updating the fields; readers retry until they see
+// the same even sequence before and after reading them.
+typedef struct {
+    atomic_uint sequence;
+    atomic_uint on_count;
+    atomic_uint unit_count;
+    atomic_uint remaining_minutes;
+} AcAppSnapshot;
+
+// Everything but the snapshot, the render text and what is set up before the schedule starts is
+// only touched on the timer thread: input and transmit completions are posted to it with
+// furi_timer_pending_callback(), so that checking and changing the states never race.
+typedef struct {
+    // Units, the state each one is tracked to be in and the model planning the presses between states.
+    AcUnit units[AC_UNITS_MAX];
+    size_t unit_count;
+    AcModelState unit_states[AC_UNITS_MAX];
+    AcModel* model;
+
+    // Signal table, one row per unit, built once at startup. Units at the address in Ac.ir use
+    // its signals as they are, in flash; the others get pre-encoded copies at their address.
+    const InfraredSignal* signals[AC_UNITS_MAX][AcModelButtonCount];
+    InfraredSignal* signal_copies[AC_UNITS_MAX][AcModelButtonCount];
+
+    // Fan-out in progress, if running: the unit and the button of each step, when it started
+    // and how long it should take.
+    bool is_fanout_running;
+    size_t fanout_step_units[INFRARED_SEQUENCER_MAX_STEPS];
+    AcModelButton fanout_step_buttons[INFRARED_SEQUENCER_MAX_STEPS];
+    size_t fanout_step_count;
+    size_t fanout_unit_count;
+    uint32_t fanout_start_tick;
+    uint32_t fanout_planned_ms;
+    uint32_t fanout_unconfirmed;
+
+    // Countdown timer, with the tick it is due at, and the schedule.
+    FuriTimer* countdown_timer;
+    uint32_t countdown_deadline;
+    AcSchedule* schedule;
+
+    // Journal of the unit states and the schedule phase.
+    AcJournal* journal;
+
+    // Transmit worker, owning the IR hardware, and the sequencer that feeds it.
+    InfraredTxWorker* tx_worker;
+    InfraredSequencer* sequencer;
+
+    // Hot-path event trace.
+    EventTrace* trace;
+
+    // Displayed state.
+    AcAppSnapshot snapshot;
+
+    // Text last drawn by the render callback and the snapshot sequence it was formatted from.
+    // Only ever touched on the GUI thread.
+    unsigned render_sequence;
+    char render_state_text[32];
+    char render_countdown_text[32];
+
+    FuriMessageQueue* event_queue;
+    ViewPort* view_port;
+    Gui* gui;
+} AcApp;
+
+// Function to get the time left until the next signal, in milliseconds.
+static uint32_t ac_app_get_remaining_time(AcApp* app) {
+    uint32_t deadline;
+    if(!ac_schedule_get_next(app->schedule, &deadline)) {
+        return 0;
+    }
+
+    const int32_t remaining_ticks = (int32_t)(deadline - furi_get_tick());
+    if(remaining_ticks <= 0) {
+        return 0;
+    }
+    return (uint64_t)remaining_ticks * 1000 / furi_kernel_get_tick_frequency();
+}
+
+// Function to get the number of minutes displayed, rounded up so that a full interval shows as such.
+static uint32_t ac_app_get_remaining_minutes(uint32_t remaining_time) {
+    return (remaining_time + 59999) / 60000;
+}
+
+// Function to schedule the countdown update for when the displayed minute changes.
+static void ac_app_schedule_countdown(AcApp* app, uint32_t remaining_time) {
+    furi_timer_stop(app->countdown_timer);
+
+    // The last change, to zero, happens when the next event is due and redraws anyway.
+    if(ac_app_get_remaining_minutes(remaining_time) > 1) {
+        const uint32_t ticks = furi_ms_to_ticks((remaining_time - 1) % 60000 + 1);
+        app->countdown_deadline = furi_get_tick() + ticks;
+        furi_timer_start(app->countdown_timer, ticks);
+    }
+}
+
+// Function to count the units that should be on.
+static size_t ac_app_get_on_count(AcApp* app) {
+    size_t on_count = 0;
+    for(size_t i = 0; i < app->unit_count; ++i) {
+        on_count += app->unit_states[i].is_on;
+    }
+    return on_count;
+}
+
+// Function to publish what the screen should show, redrawing only if it changed.
+static void ac_app_publish(AcApp* app) {
+    AcAppSnapshot* snapshot = &app->snapshot;
+    const unsigned on_count = ac_app_get_on_count(app);
+    const unsigned unit_count = app->unit_count;
+    const unsigned remaining_minutes =
+        ac_app_get_remaining_minutes(ac_app_get_remaining_time(app));
+
+    const bool is_changed =
+        atomic_load_explicit(&snapshot->on_count, memory_order_relaxed) != on_count ||
+        atomic_load_explicit(&snapshot->unit_count, memory_order_relaxed) != unit_count ||
+        atomic_load_explicit(&snapshot->remaining_minutes, memory_order_relaxed) !=
+            remaining_minutes;
+
+    if(is_changed) {
+        const unsigned sequence = atomic_load_explicit(&snapshot->sequence, memory_order_relaxed);
+        atomic_store_explicit(&snapshot->sequence, sequence + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+
+        atomic_store_explicit(&snapshot->on_count, on_count, memory_order_relaxed);
+        atomic_store_explicit(&snapshot->unit_count, unit_count, memory_order_relaxed);
+        atomic_store_explicit(&snapshot->remaining_minutes, remaining_minutes, memory_order_relaxed);
+
+        atomic_store_explicit(&snapshot->sequence, sequence + 2, memory_order_release);
+
+        view_port_update(app->view_port);
+    }
+}
+
+// Function to read a consistent copy of what the screen should show, returning its sequence.
+static unsigned ac_app_read_snapshot(
+    const AcAppSnapshot* snapshot,
+    unsigned* on_count,
+    unsigned* unit_count,
+    unsigned* remaining_minutes) {
+    unsigned sequence;
+    do {
+        sequence = atomic_load_explicit(&snapshot->sequence, memory_order_acquire);
+        *on_count = atomic_load_explicit(&snapshot->on_count, memory_order_relaxed);
+        *unit_count = atomic_load_explicit(&snapshot->unit_count, memory_order_relaxed);
+        *remaining_minutes =
+            atomic_load_explicit(&snapshot->remaining_minutes, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+    } while((sequence & 1) ||
+            sequence != atomic_load_explicit(&snapshot->sequence, memory_order_relaxed));
+    return sequence;
+}
 
 // Function to handle GUI events.
 static void ac_app_render_callback(Canvas* canvas, void* ctx) {
-    UNUSED(ctx);
+    AcApp* app = ctx;
+    const uint32_t start_cycles = event_trace_get_cycles();
+
+    // Format the text again only if the state changed since it was last drawn.
+    unsigned on_count, unit_count, remaining_minutes;
+    const unsigned sequence =
+        ac_app_read_snapshot(&app->snapshot, &on_count, &unit_count, &remaining_minutes);
+    if(sequence != app->render_sequence) {
+        if(unit_count == 1) {
+            strlcpy(
+                app->render_state_text,
+                on_count ? ac_on_text : ac_off_text,
+                sizeof(app->render_state_text));
+        } else {
+            snprintf(
+                app->render_state_text,
+                sizeof(app->render_state_text),
+                "A/Cs on: %u of %u",
+                on_count,
+                unit_count);
+        }
+
+        if(remaining_minutes == 1) {
+            snprintf(
+                app->render_countdown_text,
+                sizeof(app->render_countdown_text),
+                "Next signal in 1 min.");
+        } else {
+            snprintf(
+                app->render_countdown_text,
+                sizeof(app->render_countdown_text),
+                "Next signal in %u mins.",
+                remaining_minutes);
+        }
+
+        app->render_sequence = sequence;
+    }
+
+    // Display the text on-screen.
     canvas_clear(canvas);
     canvas_set_font(canvas, FontPrimary);
+    canvas_draw_str_aligned(canvas, 64, 32, AlignCenter, AlignCenter, app->render_state_text);
+    canvas_draw_str_aligned(canvas, 64, 48, AlignCenter, AlignCenter, app->render_countdown_text);
 
-    // Display the appropriate text.
-    canvas_draw_str_aligned(
-        canvas, 64, 32, AlignCenter, AlignCenter, ac_is_on ? ac_on_text : ac_off_text);
+    event_trace_record(
+        app->trace,
+        AcTraceProducerGui,
+        EventTraceTypeRender,
+        0,
+        event_trace_cycles_to_us(event_trace_get_cycles() - start_cycles));
+}
 
-    // Calculate the remaining minutes.
-    uint32_t remaining_minutes = remaining_time / 60000;
-    char countdown_text[32];
-    if(remaining_minutes == 1) {
-        snprintf(countdown_text, sizeof(countdown_text), "Next signal in 1 min.");
-    } else {
-        snprintf(
-            countdown_text, sizeof(countdown_text), "Next signal in %lu mins.", remaining_minutes);
+// Function to load the units, from the units file if there is one.
+static void ac_app_units_load(AcApp* app) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    app->unit_count = storage_file_exists(storage, AC_UNITS_PATH) ?
+                          ac_units_load(storage, AC_UNITS_PATH, app->units, AC_UNITS_MAX) :
+                          0;
+    furi_record_close(RECORD_STORAGE);
+
+    if(app->unit_count > 0) {
+        FURI_LOG_I("ac_app", "Loaded %zu units.", app->unit_count);
+        return;
     }
 
-    // Display the countdown text on-screen.
-    canvas_draw_str_aligned(canvas, 64, 48, AlignCenter, AlignCenter, countdown_text);
+    // Default: the one A/C this app was written for.
+    strlcpy(app->units[0].name, "A/C", sizeof(app->units[0].name));
+    app->units[0].address =
+        infrared_signal_get_message(ac_ir_signal_get(AcIrSignalPower))->address;
+    app->units[0].gap_ms = AC_UNIT_DEFAULT_GAP_MS;
+    app->units[0].is_verified = false;
+    app->unit_count = 1;
 }
 
-// Function to send the infrared signal.
-static void send_ir_signal(uint32_t address, uint32_t command) {
-    InfraredSignal* signal = infrared_signal_alloc();
-    InfraredMessage message = {
-        .protocol = InfraredProtocolNECext,
-        .address = address,
-        .command = command,
-    };
-    infrared_signal_set_message(signal, &message);
-    infrared_signal_transmit(signal);
-    infrared_signal_free(signal);
+// Function to build the signal table.
+static void ac_signals_alloc(AcApp* app) {
+    for(size_t unit = 0; unit < app->unit_count; ++unit) {
+        for(size_t i = 0; i < AcModelButtonCount; ++i) {
+            const InfraredSignal* signal = ac_ir_signal_get(ac_button_signals[i]);
+            app->signals[unit][i] = signal;
+            app->signal_copies[unit][i] = NULL;
+
+            // Raw signals cannot be readdressed and are sent as they are.
+            if(infrared_signal_is_raw(signal)) continue;
+
+            InfraredMessage message = *infrared_signal_get_message(signal);
+            if(message.address == app->units[unit].address) continue;
+
+            message.address = app->units[unit].address;
+            InfraredSignal* copy = infrared_signal_alloc();
+            infrared_signal_set_message(copy, &message);
+            // Encode once here rather than on every transmission.
+            infrared_signal_encode(copy);
+            app->signals[unit][i] = copy;
+            app->signal_copies[unit][i] = copy;
+        }
+    }
+}
+
+// Function to release the signal table.
+static void ac_signals_free(AcApp* app) {
+    for(size_t unit = 0; unit < app->unit_count; ++unit) {
+        for(size_t i = 0; i < AcModelButtonCount; ++i) {
+            if(app->signal_copies[unit][i]) {
+                infrared_signal_free(app->signal_copies[unit][i]);
+            }
+            app->signals[unit][i] = NULL;
+            app->signal_copies[unit][i] = NULL;
+        }
+    }
+}
+
+// Function to send the same sequence to several units at once, interleaving their frames.
+// The steps of each target are presses of the buttons in the same row of target_buttons.
+static void ac_app_start_fanout(
+    AcApp* app,
+    const InfraredFanoutTarget* targets,
+    const size_t* target_units,
+    const AcModelButton (*target_buttons)[AC_APP_PRESSES_MAX],
+    size_t target_count,
+    InfraredTxPriority priority,
+    InfraredSequencerCallback callback) {
+    InfraredSequenceStep steps[INFRARED_SEQUENCER_MAX_STEPS];
+    size_t step_targets[INFRARED_SEQUENCER_MAX_STEPS];
+    const size_t step_count = infrared_fanout_plan(
+        targets, target_count, steps, COUNT_OF(steps), step_targets, &app->fanout_planned_ms);
+    if(step_count == 0) {
+        FURI_LOG_E("ac_app", "Too many frames to send to %zu units at once.", target_count);
+        return;
+    }
+
+    // The planner keeps the order of each target's steps, so they map back to its presses in turn.
+    size_t press_counts[AC_UNITS_MAX] = {0};
+    for(size_t i = 0; i < step_count; ++i) {
+        const size_t target = step_targets[i];
+        app->fanout_step_units[i] = target_units[target];
+        app->fanout_step_buttons[i] = target_buttons[target][press_counts[target]++];
+    }
+    app->fanout_step_count = step_count;
+
+    InfraredTxWorkerStats stats;
+    infrared_tx_worker_get_stats(app->tx_worker, &stats);
+
+    app->fanout_unit_count = target_count;
+    app->fanout_start_tick = furi_get_tick();
+    app->fanout_unconfirmed = stats.unconfirmed;
+    app->is_fanout_running = true;
+    if(!infrared_sequencer_start(app->sequencer, steps, step_count, priority, callback, app)) {
+        app->is_fanout_running = false;
+    }
+}
+
+// Function to log how long the fan-out that just completed took.
+static void ac_app_report_fanout(AcApp* app) {
+    const uint32_t elapsed_ms = (uint64_t)(furi_get_tick() - app->fanout_start_tick) * 1000 /
+                                furi_kernel_get_tick_frequency();
     FURI_LOG_I(
-        "ir_tx",
-        "Started infrared transmission: address=0x%08lX, command=0x%08lX",
-        address,
-        command);
+        "ac_app",
+        "Fan-out to %zu units took %lu ms, planned %lu ms.",
+        app->fanout_unit_count,
+        elapsed_ms,
+        app->fanout_planned_ms);
+
+    InfraredTxWorkerStats stats;
+    infrared_tx_worker_get_stats(app->tx_worker, &stats);
+    if(stats.unconfirmed != app->fanout_unconfirmed) {
+        FURI_LOG_W(
+            "ac_app",
+            "%lu frames were never heard back.",
+            stats.unconfirmed - app->fanout_unconfirmed);
+    }
 }
 
-// Function to actually send signals and update text based on the current state.
-static void send_signals_and_update_text(void* ctx) {
-    ViewPort* view_port = (ViewPort*)ctx;
+// Timer thread callback run once the fan-out has been sent: each unit is now in the state its
+// presses that went through took it to. A unit's presses are applied in order up to the first one
+// that was not sent or not heard back, as the presses after it were planned from a state it may
+// not be in.
+static void ac_app_fanout_sent(void* ctx, uint32_t arg) {
+    AcApp* app = ctx;
+    const InfraredSequenceStatus status = arg;
+    ac_app_report_fanout(app);
 
-    if(ac_is_on) {
-        // Send signal to turn off the A/C and update the text.
-        send_ir_signal(ir_address_1, ir_command_1);
-        ac_is_on = false;
-        next_signal_interval = three_hour_interval;
-        FURI_LOG_I("ac_app", "The A/C should be off.");
-    } else {
-        // Send "The A/C should be on." signals.
-        send_ir_signal(ir_address_1, ir_command_1);
-        furi_delay_ms(1000); // Delay. Should hopefully prevent weird states from occurring.
-        send_ir_signal(ir_address_1, ir_command_2);
-        furi_delay_ms(1000); // Delay.
-        send_ir_signal(ir_address_1, ir_command_2);
-        ac_is_on = true;
-        next_signal_interval = one_hour_interval;
-        FURI_LOG_I("ac_app", "The A/C should be on.");
+    AcModelState states[AC_UNITS_MAX];
+    bool is_pressed[AC_UNITS_MAX] = {false};
+    bool is_stopped[AC_UNITS_MAX] = {false};
+    memcpy(states, app->unit_states, sizeof(states));
+
+    for(size_t i = 0; i < app->fanout_step_count; ++i) {
+        const size_t unit = app->fanout_step_units[i];
+        if(is_stopped[unit]) continue;
+
+        if(infrared_sequencer_is_step_done(app->sequencer, i)) {
+            ac_model_press(app->model, &states[unit], app->fanout_step_buttons[i]);
+            is_pressed[unit] = true;
+        } else {
+            FURI_LOG_W(
+                "ac_app",
+                "%s: a press did not go through, stopping there.",
+                app->units[unit].name);
+            is_stopped[unit] = true;
+        }
+    }
+
+    if(status == InfraredSequenceStatusIncomplete) {
+        FURI_LOG_W("ac_app", "The fan-out did not go through in full.");
     }
 
+    for(size_t i = 0; i < app->unit_count; ++i) {
+        if(!is_pressed[i]) continue;
+
+        const AcModelState* state = &states[i];
+        if(state->is_on != app->unit_states[i].is_on) {
+            ac_journal_set_unit(app->journal, i, state->is_on);
+        }
+        const uint32_t settings = ac_model_pack_settings(state);
+        if(settings != ac_model_pack_settings(&app->unit_states[i])) {
+            ac_journal_set_unit_settings(app->journal, i, settings);
+        }
+
+        app->unit_states[i] = *state;
+
+        // Only the mode is tracked, see ac_model_spec.
+        char mode_text[4] = "?";
+        if(state->mode != AC_MODEL_UNKNOWN) {
+            snprintf(mode_text, sizeof(mode_text), "%u", state->mode);
+        }
+        FURI_LOG_I(
+            "ac_app",
+            "%s: %s (mode %s)",
+            app->units[i].name,
+            state->is_on ? ac_on_text : ac_off_text,
+            mode_text);
+    }
+    app->is_fanout_running = false;
+
     // Update the text on the screen.
-    view_port_update(view_port);
+    ac_app_publish(app);
+}
 
-    // Schedule the next signal based on the current state.
-    furi_timer_stop(signal_timer);
-    furi_timer_start(signal_timer, next_signal_interval);
-    remaining_time = next_signal_interval;
+// Sequencer callback, on the transmit worker or the timer thread: the states are updated on the latter.
+static void ac_app_fanout_sent_callback(InfraredSequenceStatus status, void* ctx) {
+    furi_timer_pending_callback(ac_app_fanout_sent, ctx, status);
 }
 
-// Timer callback to update the countdown displayed on-screen.
-static void update_countdown(void* ctx) {
-    ViewPort* view_port = (ViewPort*)ctx;
+// Function to send each unit its presses, in order: unit_buttons[i] holds button_counts[i] of them.
+static void ac_app_send_presses(
+    AcApp* app,
+    const AcModelButton (*unit_buttons)[AC_APP_PRESSES_MAX],
+    const size_t* button_counts,
+    InfraredTxPriority priority) {
+    InfraredSequenceStep unit_steps[AC_UNITS_MAX][AC_APP_PRESSES_MAX];
+    InfraredFanoutTarget targets[AC_UNITS_MAX];
+    size_t target_units[AC_UNITS_MAX];
+    AcModelButton target_buttons[AC_UNITS_MAX][AC_APP_PRESSES_MAX];
+    size_t target_count = 0;
+
+    for(size_t i = 0; i < app->unit_count; ++i) {
+        const size_t button_count = button_counts[i];
+
+        // Units already there get nothing, which matters as the power button toggles.
+        if(button_count == 0) continue;
 
-    if(remaining_time >= 60000) {
-        remaining_time -= 60000; // Decrease by 1 minute at a time.
+        for(size_t j = 0; j < button_count; ++j) {
+            // Every button of this remote steps a setting, so an unheard press is never sent
+            // again: the steps are not repeatable, and a retry count only has them listened for.
+            unit_steps[i][j] = (InfraredSequenceStep){
+                .signal = app->signals[i][unit_buttons[i][j]],
+                .delay_ms = j + 1 < button_count ? AC_APP_PRESS_DELAY_MS : 0,
+                .retries = app->units[i].is_verified ? 1U : 0U,
+                .is_repeatable = false,
+            };
+            target_buttons[target_count][j] = unit_buttons[i][j];
+        }
+
+        target_units[target_count] = i;
+        targets[target_count++] =
+            (InfraredFanoutTarget){unit_steps[i], button_count, app->units[i].gap_ms};
+    }
+
+    if(target_count == 0) {
+        FURI_LOG_I("ac_app", "Every A/C is already in that state.");
+        return;
+    }
+
+    ac_app_start_fanout(
+        app,
+        targets,
+        target_units,
+        target_buttons,
+        target_count,
+        priority,
+        ac_app_fanout_sent_callback);
+}
+
+// Function to send the fewest presses that take each unit from the state it is tracked in to its target.
+static void ac_app_send_states(
+    AcApp* app,
+    const AcModelState* target_states,
+    InfraredTxPriority priority) {
+    // The fan-out state belongs to the sequence in progress until its completion is handled.
+    if(app->is_fanout_running) {
+        FURI_LOG_W("ac_app", "Signals are still being sent, skipping.");
+        return;
+    }
+
+    AcModelButton unit_buttons[AC_UNITS_MAX][AC_APP_PRESSES_MAX];
+    size_t button_counts[AC_UNITS_MAX] = {0};
+
+    for(size_t i = 0; i < app->unit_count; ++i) {
+        if(!ac_model_plan(
+               app->model,
+               &app->unit_states[i],
+               &target_states[i],
+               unit_buttons[i],
+               AC_APP_PRESSES_MAX,
+               &button_counts[i])) {
+            FURI_LOG_W("ac_app", "%s: the target state is out of reach.", app->units[i].name);
+            button_counts[i] = 0;
+        }
+    }
+
+    ac_app_send_presses(app, unit_buttons, button_counts, priority);
+}
+
+// Function to turn every unit on or off.
+static void ac_app_set_state(AcApp* app, bool on, InfraredTxPriority priority) {
+    AcModelState target_states[AC_UNITS_MAX];
+    for(size_t i = 0; i < app->unit_count; ++i) {
+        target_states[i] = on ? ac_model_on_state : ac_model_off_state;
+    }
+    ac_app_send_states(app, target_states, priority);
+}
+
+// Function to run a schedule action: "on", "off" or the name of a button.
+static void ac_app_run_action(AcApp* app, const char* action) {
+    if(strcmp(action, ac_action_on) == 0 || strcmp(action, ac_action_off) == 0) {
+        ac_app_set_state(app, strcmp(action, ac_action_on) == 0, InfraredTxPriorityScheduled);
+        return;
+    }
+
+    for(size_t button = 0; button < AcModelButtonCount; ++button) {
+        if(strcmp(action, ac_ir_signal_names[ac_button_signals[button]]) == 0) {
+            if(app->is_fanout_running) {
+                FURI_LOG_W("ac_app", "Signals are still being sent, skipping.");
+                return;
+            }
+
+            // The button is pressed as such, even when the model does not track what it
+            // changes, but units that ignore it, such as those that are off, are skipped.
+            AcModelButton unit_buttons[AC_UNITS_MAX][AC_APP_PRESSES_MAX];
+            size_t button_counts[AC_UNITS_MAX];
+            for(size_t i = 0; i < app->unit_count; ++i) {
+                unit_buttons[i][0] = button;
+                button_counts[i] = ac_model_is_ignored(&app->unit_states[i], button) ? 0 : 1;
+            }
+            ac_app_send_presses(app, unit_buttons, button_counts, InfraredTxPriorityScheduled);
+            return;
+        }
+    }
+
+    FURI_LOG_W("ac_app", "Unknown action: %s", action);
+}
+
+// Function to count down to the next event and record when it is due.
+static void ac_app_start_countdown(AcApp* app) {
+    const uint32_t remaining_time = ac_app_get_remaining_time(app);
+    ac_journal_set_deadline(
+        app->journal, furi_hal_rtc_get_timestamp() + (remaining_time + 999) / 1000);
+    ac_app_schedule_countdown(app, remaining_time);
+}
+
+// Schedule callback to send the signals of the event that is due.
+static void send_signals_and_update_text(const AcScheduleEvent* event, void* ctx) {
+    AcApp* app = ctx;
+
+    ac_app_run_action(app, event->action);
+
+    // Update the text on the screen and count down to the next event.
+    ac_app_publish(app);
+    ac_app_start_countdown(app);
+}
+
+// Function to set up the schedule, from the schedule file if there is one.
+static void ac_app_schedule_load(AcApp* app) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    const bool is_loaded = storage_file_exists(storage, AC_SCHEDULE_PATH) &&
+                           ac_schedule_load(app->schedule, storage, AC_SCHEDULE_PATH);
+    furi_record_close(RECORD_STORAGE);
+
+    if(is_loaded) {
+        FURI_LOG_I(
+            "ac_app", "Loaded %zu scheduled events.", ac_schedule_get_count(app->schedule));
+        return;
+    }
+
+    // Default: on for 1 hour, then off for 3 hours.
+    AcScheduleEvent event = {
+        .type = AcScheduleEventTypeCycle,
+        .period = (one_hour_interval + three_hour_interval) / 1000,
+        .offset = 0,
+    };
+    strlcpy(event.action, ac_action_on, sizeof(event.action));
+    ac_schedule_add(app->schedule, &event);
+
+    event.offset = one_hour_interval / 1000;
+    strlcpy(event.action, ac_action_off, sizeof(event.action));
+    ac_schedule_add(app->schedule, &event);
+}
+
+// Timer thread callback to start the schedule, from where the journal left it if it is for the same units.
+static void ac_app_start(void* ctx, uint32_t arg) {
+    UNUSED(arg);
+    AcApp* app = ctx;
+    const uint32_t now = furi_hal_rtc_get_timestamp();
+    AcJournalState state;
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    const bool is_resumed = ac_journal_load(app->journal, storage, &state) &&
+                            state.unit_count == app->unit_count && state.anchor <= now;
+    furi_record_close(RECORD_STORAGE);
+
+    if(is_resumed) {
+        // The units are left as they are: only the events still to come send anything.
+        for(size_t i = 0; i < app->unit_count; ++i) {
+            app->unit_states[i] = ac_model_initial_state;
+            app->unit_states[i].is_on = state.unit_is_on[i];
+            ac_model_unpack_settings(app->model, state.unit_settings[i], &app->unit_states[i]);
+        }
+        FURI_LOG_I(
+            "ac_app",
+            "Resumed %lu s into the schedule, %zu of %zu units on.",
+            now - state.anchor,
+            ac_app_get_on_count(app),
+            app->unit_count);
+        if(state.deadline != 0 && state.deadline < now) {
+            FURI_LOG_W("ac_app", "Events due while the app was closed were skipped.");
+        }
     } else {
-        remaining_time = 0;
+        memset(&state, 0, sizeof(state));
+        state.anchor = now;
+        state.unit_count = app->unit_count;
+        for(size_t i = 0; i < app->unit_count; ++i) {
+            app->unit_states[i] = ac_model_initial_state;
+            state.unit_settings[i] = ac_model_pack_settings(&ac_model_initial_state);
+        }
     }
 
+    ac_journal_start(app->journal, &state);
+    ac_schedule_start(app->schedule, state.anchor);
+
+    ac_app_publish(app);
+    ac_app_start_countdown(app);
+}
+
+// Timer callback to update the countdown displayed on-screen.
+static void update_countdown(void* ctx) {
+    AcApp* app = ctx;
+    const int32_t lateness = (int32_t)(furi_get_tick() - app->countdown_deadline);
+    event_trace_record(
+        app->trace,
+        AcTraceProducerTimer,
+        EventTraceTypeTimerFire,
+        AcTraceTimerCountdown,
+        MAX(lateness, 0));
+    const uint32_t remaining_time = ac_app_get_remaining_time(app);
+
     // Log the remaining time.
-    uint32_t remaining_minutes = remaining_time / 60000;
+    uint32_t remaining_minutes = ac_app_get_remaining_minutes(remaining_time);
     if(remaining_minutes == 1) {
         FURI_LOG_I("countdown", "Time remaining until next signal: 1 minute");
     } else {
@@ -115,11 +734,60 @@ static void update_countdown(void* ctx) {
     }
 
     // Update the text on the screen.
-    view_port_update(view_port);
+    ac_app_publish(app);
 
-    // Schedule the next countdown update in one minute.
-    furi_timer_stop(countdown_timer);
-    furi_timer_start(countdown_timer, 60000);
+    // Schedule the next countdown update for the next minute change.
+    ac_app_schedule_countdown(app, remaining_time);
+}
+
+// Timer thread callback to toggle every unit on the press of OK.
+static void ac_app_toggle(void* ctx, uint32_t arg) {
+    UNUSED(arg);
+    AcApp* app = ctx;
+
+    if(app->is_fanout_running) {
+        FURI_LOG_I("ac_app", "Signals are already being sent.");
+        return;
+    }
+
+    FURI_LOG_I("ac_app", "Toggling the A/C now.");
+    // Turn everything off once every unit is on, otherwise turn the rest on.
+    const bool on = ac_app_get_on_count(app) < app->unit_count;
+    ac_app_set_state(app, on, InfraredTxPriorityUser);
+}
+
+// Timer thread callback to stop everything that could send or change the states.
+static void ac_app_stop(void* ctx, uint32_t arg) {
+    UNUSED(arg);
+    AcApp* app = ctx;
+
+    ac_schedule_stop(app->schedule);
+    infrared_sequencer_stop(app->sequencer);
+    furi_timer_stop(app->countdown_timer);
+}
+
+// Timer thread callback to wake up the thread waiting in ac_app_sync_timer_thread().
+static void ac_app_timer_thread_synced(void* ctx, uint32_t arg) {
+    UNUSED(arg);
+    furi_thread_flags_set(ctx, AC_APP_FLAG_TIMER_SYNC);
+}
+
+// Function to wait until the timer thread has run every callback posted so far.
+static void ac_app_sync_timer_thread(void) {
+    furi_thread_flags_clear(AC_APP_FLAG_TIMER_SYNC);
+    furi_timer_pending_callback(ac_app_timer_thread_synced, furi_thread_get_current_id(), 0);
+    furi_thread_flags_wait(AC_APP_FLAG_TIMER_SYNC, FuriFlagWaitAny, FuriWaitForever);
+}
+
+// Function to append the events recorded so far to the trace file.
+static void ac_app_dump_trace(AcApp* app) {
+    if(event_trace_is_empty(app->trace)) return;
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    if(!event_trace_dump(app->trace, storage, AC_TRACE_PATH)) {
+        FURI_LOG_W("ac_app", "Failed to write the event trace");
+    }
+    furi_record_close(RECORD_STORAGE);
 }
 
 // Handle input.
@@ -132,58 +800,130 @@ static void ac_app_input_callback(InputEvent* input_event, void* ctx) {
         FuriMessageQueue* event_queue = (FuriMessageQueue*)ctx;
         InputEvent exit_event = {.type = InputTypeShort, .key = InputKeyBack};
         furi_message_queue_put(event_queue, &exit_event, FuriWaitForever);
+    } else if(input_event->key == InputKeyOk && input_event->type == InputTypeShort) {
+        // You pressed OK, so we're toggling the A/C right now.
+        FuriMessageQueue* event_queue = (FuriMessageQueue*)ctx;
+        furi_message_queue_put(event_queue, input_event, FuriWaitForever);
     }
 }
 
-int32_t ac_app_app(void* p) { // The actual sequence of events.
-    UNUSED(p);
+// Function to create the app and everything it runs on, ready to start the schedule.
+static AcApp* ac_app_alloc(void) {
+    AcApp* app = malloc(sizeof(AcApp));
+    memset(app, 0, sizeof(AcApp));
 
-    FuriMessageQueue* event_queue = furi_message_queue_alloc(8, sizeof(InputEvent));
-    FURI_LOG_I("ac_app", "The app started.");
+    app->event_queue = furi_message_queue_alloc(8, sizeof(InputEvent));
+
+    // Build the signal table and the model before anything can send.
+    ac_app_units_load(app);
+    ac_signals_alloc(app);
+    app->model = ac_model_alloc(&ac_model_spec);
+    app->journal = ac_journal_alloc(AC_JOURNAL_PATH);
+
+    // Initialize the trace, the transmit worker, the sequencer, the timer and the schedule.
+    app->trace = event_trace_alloc(AcTraceProducerCount);
+    app->tx_worker = infrared_tx_worker_alloc();
+    infrared_tx_worker_set_trace(app->tx_worker, app->trace, AcTraceProducerTx);
+    for(size_t i = 0; i < app->unit_count; ++i) {
+        if(app->units[i].is_verified) {
+            infrared_tx_worker_set_verification(app->tx_worker, AC_UNIT_LISTEN_MS);
+            break;
+        }
+    }
+    infrared_tx_worker_start(app->tx_worker);
+    app->sequencer = infrared_sequencer_alloc(app->tx_worker);
+    app->countdown_timer = furi_timer_alloc(update_countdown, FuriTimerTypeOnce, app);
+    app->schedule = ac_schedule_alloc(send_signals_and_update_text, app);
+    ac_app_schedule_load(app);
+
+    // Nothing is drawn before the schedule starts, so the snapshot can be set up directly.
+    // The odd render sequence makes the first render format whatever it reads.
+    atomic_init(&app->snapshot.unit_count, app->unit_count);
+    app->render_sequence = 1;
 
     // Creating and configuring a ViewPort.
-    ViewPort* view_port = view_port_alloc();
-    view_port_draw_callback_set(view_port, ac_app_render_callback, view_port);
-    view_port_input_callback_set(view_port, ac_app_input_callback, event_queue);
+    app->view_port = view_port_alloc();
+    view_port_draw_callback_set(app->view_port, ac_app_render_callback, app);
+    view_port_input_callback_set(app->view_port, ac_app_input_callback, app->event_queue);
 
     // Get the default GUI instance and add the ViewPort to it.
-    Gui* gui = furi_record_open(RECORD_GUI);
-    gui_add_view_port(gui, view_port, GuiLayerFullscreen);
+    app->gui = furi_record_open(RECORD_GUI);
+    gui_add_view_port(app->gui, app->view_port, GuiLayerFullscreen);
 
-    // Initialize the timers
-    signal_timer = furi_timer_alloc(send_signals_and_update_text, FuriTimerTypeOnce, view_port);
-    countdown_timer = furi_timer_alloc(update_countdown, FuriTimerTypeOnce, view_port);
+    return app;
+}
+
+// Function to stop and delete everything the app runs on.
+static void ac_app_free(AcApp* app) {
+    // Stop everything that could still call back into the app first, on the thread they run on.
+    furi_timer_pending_callback(ac_app_stop, app, 0);
+    ac_app_sync_timer_thread();
 
-    // Start sending signals.
-    send_signals_and_update_text(view_port);
+    InfraredTxWorkerStats stats;
+    infrared_tx_worker_get_stats(app->tx_worker, &stats);
+    FURI_LOG_I(
+        "ir_tx",
+        "Sent %lu signals, max queue depth %zu, max wait %lu ms, %lu resent, %lu unconfirmed",
+        stats.sent,
+        stats.max_queue_depth,
+        stats.max_wait_ms,
+        stats.resent,
+        stats.unconfirmed);
+    infrared_tx_worker_stop(app->tx_worker);
+
+    // Let a fan-out completion posted before the worker stopped run while everything it uses is there.
+    ac_app_sync_timer_thread();
+    furi_timer_free(app->countdown_timer);
+
+    infrared_sequencer_free(app->sequencer);
+    infrared_tx_worker_free(app->tx_worker);
+    ac_schedule_free(app->schedule);
+
+    // Nothing can change the state any more: write out what is left.
+    ac_journal_free(app->journal);
+
+    gui_remove_view_port(app->gui, app->view_port);
+    view_port_free(app->view_port);
+    furi_record_close(RECORD_GUI);
 
-    // Schedule the first countdown update in 1 minute.
-    furi_timer_start(countdown_timer, 60000);
+    ac_app_dump_trace(app);
+    event_trace_free(app->trace);
+    ac_model_free(app->model);
+    ac_signals_free(app);
+    furi_message_queue_free(app->event_queue);
+
+    free(app);
+}
+
+int32_t ac_app_app(void* p) { // The actual sequence of events.
+    UNUSED(p);
+
+    AcApp* app = ac_app_alloc();
+    FURI_LOG_I("ac_app", "The app started.");
+
+    // Start sending signals and counting down to the first one.
+    furi_timer_pending_callback(ac_app_start, app, 0);
 
     // Run the input event loop so the app doesn't stop until we say so.
+    // The trace is written out whenever no input comes for a while.
     InputEvent event;
+    const uint32_t trace_dump_ticks = furi_ms_to_ticks(AC_TRACE_DUMP_INTERVAL_MS);
     while(true) {
-        if(furi_message_queue_get(event_queue, &event, FuriWaitForever) == FuriStatusOk) {
+        const FuriStatus status =
+            furi_message_queue_get(app->event_queue, &event, trace_dump_ticks);
+        if(status == FuriStatusErrorTimeout) {
+            ac_app_dump_trace(app);
+        } else if(status == FuriStatusOk) {
             if(event.key == InputKeyBack) {
                 FURI_LOG_I("ac_app", "Closing the application!");
                 break;
+            } else if(event.key == InputKeyOk) {
+                furi_timer_pending_callback(ac_app_toggle, app, 0);
             }
         }
     }
 
-    // Cleanup.
-    if(signal_timer) {
-        furi_timer_stop(signal_timer);
-        furi_timer_free(signal_timer);
-    }
-    if(countdown_timer) {
-        furi_timer_stop(countdown_timer);
-        furi_timer_free(countdown_timer);
-    }
-    gui_remove_view_port(gui, view_port);
-    view_port_free(view_port);
-    furi_record_close(RECORD_GUI);
-    furi_message_queue_free(event_queue);
+    ac_app_free(app);
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,373 @@
+#include "ac_journal.h"
+
+#include <furi.h>
+#include <furi_hal_rtc.h>
+
+#define TAG "AcJournal"
+
+#define AC_JOURNAL_MAGIC (0x4C4E524AUL) // "JRNL"
+#define AC_JOURNAL_VERSION (1U)
+#define AC_JOURNAL_TEMP_SUFFIX ".tmp"
+
+// State changes waiting to be written, any more are covered by a compaction instead.
+#define AC_JOURNAL_PENDING_MAX (16U)
+// Number of records past which the journal is rewritten as the current state.
+#define AC_JOURNAL_COMPACT_THRESHOLD (64U)
+// Header, anchor, deadline and two records per unit.
+#define AC_JOURNAL_SNAPSHOT_MAX (3U + 2 * AC_UNITS_MAX)
+
+#define AC_JOURNAL_THREAD_STACK_SIZE (2048U)
+
+typedef enum {
+    AcJournalRecordTypeHeader, /**< First record of the file: unit is the version, value the magic. */
+    AcJournalRecordTypeAnchor, /**< Schedule anchor: unit is the unit count, value the anchor. */
+    AcJournalRecordTypeDeadline, /**< Next event: value is its RTC timestamp. */
+    AcJournalRecordTypeUnit, /**< Unit state: value is 1 if the unit is on, 0 otherwise. */
+    AcJournalRecordTypeSettings, /**< Unit settings: value is as packed by the app. */
+} AcJournalRecordType;
+
+typedef struct {
+    uint8_t type;
+    uint8_t unit;
+    uint16_t check; /**< Fletcher-16 of the record, computed with this field set to 0. */
+    uint32_t timestamp; /**< RTC timestamp the record was made at. */
+    uint32_t value;
+} AcJournalRecord;
+
+typedef enum {
+    AcJournalFlagWrite = (1 << 0),
+    AcJournalFlagExit = (1 << 1),
+    AcJournalFlagAll = AcJournalFlagWrite | AcJournalFlagExit,
+} AcJournalFlag;
+
+struct AcJournal {
+    FuriString* path;
+    FuriString* temp_path;
+
+    FuriThread* thread;
+    bool is_running;
+
+    // Shared with the writer thread, under the mutex.
+    FuriMutex* mutex;
+    AcJournalState state;
+    AcJournalRecord pending[AC_JOURNAL_PENDING_MAX];
+    size_t pending_count;
+    bool needs_compaction;
+
+    // Only used by the writer thread.
+    File* file;
+    size_t record_count;
+};
+
+static uint16_t ac_journal_get_check(const AcJournalRecord* record) {
+    AcJournalRecord copy = *record;
+    copy.check = 0;
+
+    const uint8_t* data = (const uint8_t*)&copy;
+    uint16_t sum1 = 0, sum2 = 0;
+    for(size_t i = 0; i < sizeof(copy); ++i) {
+        sum1 = (sum1 + data[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+    return (sum2 << 8) | sum1;
+}
+
+static AcJournalRecord
+    ac_journal_make_record(AcJournalRecordType type, size_t unit, uint32_t value) {
+    AcJournalRecord record = {
+        .type = type,
+        .unit = unit,
+        .check = 0,
+        .timestamp = furi_hal_rtc_get_timestamp(),
+        .value = value,
+    };
+    record.check = ac_journal_get_check(&record);
+    return record;
+}
+
+// Apply a record read back from the file to a state, false if it does not belong in one.
+static bool ac_journal_apply(AcJournalState* state, const AcJournalRecord* record) {
+    switch(record->type) {
+    case AcJournalRecordTypeAnchor:
+        if(record->unit > AC_UNITS_MAX) return false;
+        state->anchor = record->value;
+        state->unit_count = record->unit;
+        return true;
+    case AcJournalRecordTypeDeadline:
+        state->deadline = record->value;
+        return true;
+    case AcJournalRecordTypeUnit:
+        if(record->unit >= state->unit_count) return false;
+        state->unit_is_on[record->unit] = record->value != 0;
+        return true;
+    case AcJournalRecordTypeSettings:
+        if(record->unit >= state->unit_count) return false;
+        state->unit_settings[record->unit] = record->value;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Build the records that make up a journal holding the given state only.
+static size_t ac_journal_make_snapshot(const AcJournalState* state, AcJournalRecord* records) {
+    size_t count = 0;
+    records[count++] =
+        ac_journal_make_record(AcJournalRecordTypeHeader, AC_JOURNAL_VERSION, AC_JOURNAL_MAGIC);
+    records[count++] =
+        ac_journal_make_record(AcJournalRecordTypeAnchor, state->unit_count, state->anchor);
+    records[count++] = ac_journal_make_record(AcJournalRecordTypeDeadline, 0, state->deadline);
+    for(size_t i = 0; i < state->unit_count; ++i) {
+        records[count++] =
+            ac_journal_make_record(AcJournalRecordTypeUnit, i, state->unit_is_on[i]);
+        if(state->unit_settings[i] != 0) {
+            records[count++] =
+                ac_journal_make_record(AcJournalRecordTypeSettings, i, state->unit_settings[i]);
+        }
+    }
+    return count;
+}
+
+static bool ac_journal_write_records(File* file, const AcJournalRecord* records, size_t count) {
+    const size_t size = count * sizeof(AcJournalRecord);
+    return storage_file_write(file, records, size) == size && storage_file_sync(file);
+}
+
+// Rewrite the journal as the given records: write them to a temporary file, then replace the journal with it.
+static bool ac_journal_compact(
+    AcJournal* journal,
+    Storage* storage,
+    const AcJournalRecord* records,
+    size_t count) {
+    const char* path = furi_string_get_cstr(journal->path);
+    const char* temp_path = furi_string_get_cstr(journal->temp_path);
+    bool success = false;
+
+    storage_file_close(journal->file);
+
+    do {
+        if(!storage_file_open(journal->file, temp_path, FSAM_WRITE, FSOM_CREATE_ALWAYS)) break;
+        const bool is_written = ac_journal_write_records(journal->file, records, count);
+        storage_file_close(journal->file);
+        if(!is_written) break;
+
+        // Loading falls back to the temporary file if this is interrupted between the two steps.
+        if(!storage_simply_remove(storage, path)) break;
+        if(storage_common_rename(storage, temp_path, path) != FSE_OK) break;
+
+        if(!storage_file_open(journal->file, path, FSAM_WRITE, FSOM_OPEN_APPEND)) break;
+        journal->record_count = count;
+        success = true;
+    } while(false);
+
+    if(!success) {
+        FURI_LOG_E(TAG, "Failed to compact %s", path);
+    }
+
+    return success;
+}
+
+// Write the pending state changes, or the whole state when the journal needs compacting.
+static void ac_journal_flush(AcJournal* journal, Storage* storage) {
+    AcJournalRecord records[MAX(AC_JOURNAL_PENDING_MAX, AC_JOURNAL_SNAPSHOT_MAX)];
+    size_t count;
+
+    furi_check(furi_mutex_acquire(journal->mutex, FuriWaitForever) == FuriStatusOk);
+    const bool is_compacting =
+        journal->needs_compaction ||
+        journal->record_count + journal->pending_count > AC_JOURNAL_COMPACT_THRESHOLD;
+    if(is_compacting) {
+        // The state already includes every pending change.
+        count = ac_journal_make_snapshot(&journal->state, records);
+    } else {
+        count = journal->pending_count;
+        memcpy(records, journal->pending, count * sizeof(AcJournalRecord));
+    }
+    journal->pending_count = 0;
+    journal->needs_compaction = false;
+    furi_mutex_release(journal->mutex);
+
+    bool success;
+    if(is_compacting) {
+        success = ac_journal_compact(journal, storage, records, count);
+    } else {
+        success = count == 0 || ac_journal_write_records(journal->file, records, count);
+        journal->record_count += count;
+    }
+
+    if(!success) {
+        // Write the whole state again at the next change.
+        furi_check(furi_mutex_acquire(journal->mutex, FuriWaitForever) == FuriStatusOk);
+        journal->needs_compaction = true;
+        furi_mutex_release(journal->mutex);
+    }
+}
+
+static int32_t ac_journal_thread(void* context) {
+    AcJournal* journal = context;
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    journal->file = storage_file_alloc(storage);
+
+    for(;;) {
+        const uint32_t flags =
+            furi_thread_flags_wait(AcJournalFlagAll, FuriFlagWaitAny, FuriWaitForever);
+        if(flags & FuriFlagError) continue;
+
+        ac_journal_flush(journal, storage);
+        if(flags & AcJournalFlagExit) break;
+    }
+
+    storage_file_close(journal->file);
+    storage_file_free(journal->file);
+    journal->file = NULL;
+    furi_record_close(RECORD_STORAGE);
+
+    return 0;
+}
+
+// Queue a state change for the writer thread, the caller holding the mutex.
+static void ac_journal_push(AcJournal* journal, const AcJournalRecord* record) {
+    if(journal->pending_count < AC_JOURNAL_PENDING_MAX) {
+        journal->pending[journal->pending_count++] = *record;
+    } else {
+        journal->needs_compaction = true;
+    }
+
+    if(journal->is_running) {
+        furi_thread_flags_set(furi_thread_get_id(journal->thread), AcJournalFlagWrite);
+    }
+}
+
+static bool ac_journal_load_file(Storage* storage, const char* path, AcJournalState* state) {
+    File* file = storage_file_alloc(storage);
+    bool success = false;
+
+    do {
+        if(!storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) break;
+
+        AcJournalRecord record;
+        if(storage_file_read(file, &record, sizeof(record)) != sizeof(record)) break;
+        if(record.type != AcJournalRecordTypeHeader || record.unit != AC_JOURNAL_VERSION ||
+           record.value != AC_JOURNAL_MAGIC || record.check != ac_journal_get_check(&record)) {
+            FURI_LOG_E(TAG, "Unsupported journal: %s", path);
+            break;
+        }
+
+        // Every record up to the first bad one, if it was torn by a crash, is valid.
+        bool has_anchor = false;
+        memset(state, 0, sizeof(AcJournalState));
+        while(storage_file_read(file, &record, sizeof(record)) == sizeof(record)) {
+            if(record.check != ac_journal_get_check(&record) || !ac_journal_apply(state, &record)) {
+                FURI_LOG_W(TAG, "Journal %s truncated at a bad record", path);
+                break;
+            }
+            has_anchor |= record.type == AcJournalRecordTypeAnchor;
+        }
+
+        success = has_anchor;
+    } while(false);
+
+    storage_file_close(file);
+    storage_file_free(file);
+
+    return success;
+}
+
+AcJournal* ac_journal_alloc(const char* path) {
+    AcJournal* journal = malloc(sizeof(AcJournal));
+
+    journal->path = furi_string_alloc_set_str(path);
+    journal->temp_path = furi_string_alloc_printf("%s%s", path, AC_JOURNAL_TEMP_SUFFIX);
+
+    journal->thread = furi_thread_alloc_ex(
+        "AcJournal", AC_JOURNAL_THREAD_STACK_SIZE, ac_journal_thread, journal);
+    journal->is_running = false;
+
+    journal->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    memset(&journal->state, 0, sizeof(journal->state));
+    journal->pending_count = 0;
+    journal->needs_compaction = false;
+
+    journal->file = NULL;
+    journal->record_count = 0;
+
+    return journal;
+}
+
+void ac_journal_free(AcJournal* journal) {
+    ac_journal_stop(journal);
+    furi_thread_free(journal->thread);
+    furi_mutex_free(journal->mutex);
+    furi_string_free(journal->path);
+    furi_string_free(journal->temp_path);
+    free(journal);
+}
+
+bool ac_journal_load(AcJournal* journal, Storage* storage, AcJournalState* state) {
+    const char* path = furi_string_get_cstr(journal->path);
+    const char* temp_path = furi_string_get_cstr(journal->temp_path);
+
+    // The temporary file is only left on its own if compaction stopped before renaming it.
+    if(storage_file_exists(storage, path)) {
+        return ac_journal_load_file(storage, path, state);
+    } else if(storage_file_exists(storage, temp_path)) {
+        return ac_journal_load_file(storage, temp_path, state);
+    }
+    return false;
+}
+
+void ac_journal_start(AcJournal* journal, const AcJournalState* state) {
+    furi_assert(!journal->is_running);
+    furi_assert(state->unit_count <= AC_UNITS_MAX);
+
+    furi_check(furi_mutex_acquire(journal->mutex, FuriWaitForever) == FuriStatusOk);
+    journal->state = *state;
+    journal->pending_count = 0;
+    journal->needs_compaction = true;
+    journal->is_running = true;
+    furi_mutex_release(journal->mutex);
+
+    furi_thread_start(journal->thread);
+    furi_thread_flags_set(furi_thread_get_id(journal->thread), AcJournalFlagWrite);
+}
+
+void ac_journal_stop(AcJournal* journal) {
+    if(!journal->is_running) return;
+
+    furi_check(furi_mutex_acquire(journal->mutex, FuriWaitForever) == FuriStatusOk);
+    journal->is_running = false;
+    furi_mutex_release(journal->mutex);
+
+    furi_thread_flags_set(furi_thread_get_id(journal->thread), AcJournalFlagExit);
+    furi_thread_join(journal->thread);
+}
+
+void ac_journal_set_unit(AcJournal* journal, size_t unit, bool on) {
+    const AcJournalRecord record = ac_journal_make_record(AcJournalRecordTypeUnit, unit, on);
+
+    furi_check(furi_mutex_acquire(journal->mutex, FuriWaitForever) == FuriStatusOk);
+    furi_assert(unit < journal->state.unit_count);
+    journal->state.unit_is_on[unit] = on;
+    ac_journal_push(journal, &record);
+    furi_mutex_release(journal->mutex);
+}
+
+void ac_journal_set_unit_settings(AcJournal* journal, size_t unit, uint32_t settings) {
+    const AcJournalRecord record =
+        ac_journal_make_record(AcJournalRecordTypeSettings, unit, settings);
+
+    furi_check(furi_mutex_acquire(journal->mutex, FuriWaitForever) == FuriStatusOk);
+    furi_assert(unit < journal->state.unit_count);
+    journal->state.unit_settings[unit] = settings;
+    ac_journal_push(journal, &record);
+    furi_mutex_release(journal->mutex);
+}
+
+void ac_journal_set_deadline(AcJournal* journal, uint32_t deadline) {
+    const AcJournalRecord record = ac_journal_make_record(AcJournalRecordTypeDeadline, 0, deadline);
+
+    furi_check(furi_mutex_acquire(journal->mutex, FuriWaitForever) == FuriStatusOk);
+    journal->state.deadline = deadline;
+    ac_journal_push(journal, &record);
+    furi_mutex_release(journal->mutex);
+}
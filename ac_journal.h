@@ -0,0 +1,102 @@
+/**
+ * @file ac_journal.h
+ * @brief Append-only journal of the app state.
+ *
+ * The journal records the schedule anchor, the time the next event is due,
+ * whether each unit is on and the settings it was left at, so that the app can resume where it left off after
+ * a restart or a crash instead of starting the schedule over.
+ *
+ * State changes are queued in memory and written out by a background thread,
+ * one fixed-size checksummed record each, so that the callers never wait for
+ * storage. The same thread compacts the journal, rewriting it as the current
+ * state only, once it gets too long. A record torn by a crash fails its
+ * checksum and ends the journal there when it is read back.
+ */
+#pragma once
+
+#include <storage/storage.h>
+#include "ac_units.h"
+
+/**
+ * @brief State recorded in the journal.
+ */
+typedef struct {
+    uint32_t anchor; /**< RTC timestamp the schedule was started from. */
+    uint32_t deadline; /**< RTC timestamp at which the next event is due, 0 if unknown. */
+    size_t unit_count; /**< Number of units the state applies to. */
+    bool unit_is_on[AC_UNITS_MAX]; /**< Whether each unit is on. */
+    uint32_t unit_settings[AC_UNITS_MAX]; /**< Settings of each unit, as packed by the app, 0 if unknown. */
+} AcJournalState;
+
+/**
+ * @brief AcJournal opaque type declaration.
+ */
+typedef struct AcJournal AcJournal;
+
+/**
+ * @brief Create a new AcJournal instance.
+ *
+ * @param[in] path pointer to a zero-terminated string containing the journal file path.
+ * @returns pointer to the instance created.
+ */
+AcJournal* ac_journal_alloc(const char* path);
+
+/**
+ * @brief Delete an AcJournal instance, stopping it if needed.
+ *
+ * @param[in,out] journal pointer to the instance to be deleted.
+ */
+void ac_journal_free(AcJournal* journal);
+
+/**
+ * @brief Read the state last recorded in the journal file.
+ *
+ * @param[in] journal pointer to the instance to be read.
+ * @param[in] storage pointer to the storage record.
+ * @param[out] state pointer to the state to be filled in.
+ * @returns true if a state was recorded, false if there is no valid journal.
+ */
+bool ac_journal_load(AcJournal* journal, Storage* storage, AcJournalState* state);
+
+/**
+ * @brief Start recording, from a given state.
+ *
+ * The journal file is first rewritten to hold that state only.
+ *
+ * @param[in,out] journal pointer to the instance to be started.
+ * @param[in] state pointer to the initial state, copied into the instance.
+ */
+void ac_journal_start(AcJournal* journal, const AcJournalState* state);
+
+/**
+ * @brief Stop recording, once every state change has been written.
+ *
+ * @param[in,out] journal pointer to the instance to be stopped.
+ */
+void ac_journal_stop(AcJournal* journal);
+
+/**
+ * @brief Record whether a unit is on. Can be called from any thread.
+ *
+ * @param[in,out] journal pointer to the instance to record into.
+ * @param[in] unit index of the unit, less than the unit count of the state.
+ * @param[in] on whether the unit is now on.
+ */
+void ac_journal_set_unit(AcJournal* journal, size_t unit, bool on);
+
+/**
+ * @brief Record the settings of a unit. Can be called from any thread.
+ *
+ * @param[in,out] journal pointer to the instance to record into.
+ * @param[in] unit index of the unit, less than the unit count of the state.
+ * @param[in] settings settings of the unit, packed by the app into a non-zero value.
+ */
+void ac_journal_set_unit_settings(AcJournal* journal, size_t unit, uint32_t settings);
+
+/**
+ * @brief Record when the next event is due. Can be called from any thread.
+ *
+ * @param[in,out] journal pointer to the instance to record into.
+ * @param[in] deadline RTC timestamp at which the next event is due.
+ */
+void ac_journal_set_deadline(AcJournal* journal, uint32_t deadline);
@@ -0,0 +1,244 @@
+#include "ac_model.h"
+
+#include <furi.h>
+
+#define TAG "AcModel"
+
+// Marks a state the search has not reached yet.
+#define AC_MODEL_UNVISITED (UINT16_MAX)
+
+// Packed settings: a marker bit, so that 0 is never valid, then one byte per setting.
+#define AC_MODEL_SETTINGS_MARKER (1UL << 31)
+
+struct AcModel {
+    AcModelSpec spec;
+    size_t state_count;
+
+    // Search buffers, one element per state.
+    uint16_t* previous; /**< State each state was first reached from, AC_MODEL_UNVISITED if not yet. */
+    uint8_t* button; /**< Button pressed to reach each state. */
+    uint16_t* queue; /**< States reached, in the order they were reached. */
+};
+
+// Values a setting takes in the search: the known ones, then unknown.
+static inline size_t ac_model_get_slot_count(const AcModelSettingSpec* spec) {
+    return spec->count + 1;
+}
+
+static inline size_t ac_model_get_slot(const AcModelSettingSpec* spec, uint8_t value) {
+    return value == AC_MODEL_UNKNOWN ? spec->count : value;
+}
+
+static inline uint8_t ac_model_get_value(const AcModelSettingSpec* spec, size_t slot) {
+    return slot == spec->count ? AC_MODEL_UNKNOWN : slot;
+}
+
+static inline bool ac_model_is_valid_value(const AcModelSettingSpec* spec, uint8_t value) {
+    return value < spec->count || value == AC_MODEL_UNKNOWN;
+}
+
+static inline bool ac_model_is_matching(uint8_t value, uint8_t target) {
+    return target == AC_MODEL_ANY || value == target;
+}
+
+static void ac_model_check_setting(const AcModelSettingSpec* spec, uint8_t max) {
+    furi_check(spec->count <= max);
+    furi_check(spec->power_on == AC_MODEL_ANY || spec->power_on < spec->count);
+}
+
+// Step a setting to its next value.
+static void ac_model_step(const AcModelSettingSpec* spec, uint8_t* value) {
+    if(*value == AC_MODEL_UNKNOWN) return;
+
+    if(*value + 1 < spec->count) {
+        (*value)++;
+    } else {
+        *value = spec->is_exact ? 0 : AC_MODEL_UNKNOWN;
+    }
+}
+
+static void ac_model_power_on(const AcModelSettingSpec* spec, uint8_t* value) {
+    if(spec->power_on != AC_MODEL_ANY) *value = spec->power_on;
+}
+
+static size_t ac_model_get_index(const AcModel* model, const AcModelState* state) {
+    const AcModelSpec* spec = &model->spec;
+    size_t index = state->is_on;
+    index = index * ac_model_get_slot_count(&spec->mode) +
+            ac_model_get_slot(&spec->mode, state->mode);
+    index = index * ac_model_get_slot_count(&spec->fan_speed) +
+            ac_model_get_slot(&spec->fan_speed, state->fan_speed);
+    index = index * ac_model_get_slot_count(&spec->temperature) +
+            ac_model_get_slot(&spec->temperature, state->temperature);
+    return index;
+}
+
+static void ac_model_get_state(const AcModel* model, size_t index, AcModelState* state) {
+    const AcModelSpec* spec = &model->spec;
+    const size_t temperature_slots = ac_model_get_slot_count(&spec->temperature);
+    const size_t fan_speed_slots = ac_model_get_slot_count(&spec->fan_speed);
+    const size_t mode_slots = ac_model_get_slot_count(&spec->mode);
+
+    state->temperature = ac_model_get_value(&spec->temperature, index % temperature_slots);
+    index /= temperature_slots;
+    state->fan_speed = ac_model_get_value(&spec->fan_speed, index % fan_speed_slots);
+    index /= fan_speed_slots;
+    state->mode = ac_model_get_value(&spec->mode, index % mode_slots);
+    state->is_on = index / mode_slots;
+}
+
+static bool ac_model_is_target(const AcModelState* state, const AcModelState* target) {
+    return state->is_on == target->is_on && ac_model_is_matching(state->mode, target->mode) &&
+           ac_model_is_matching(state->fan_speed, target->fan_speed) &&
+           ac_model_is_matching(state->temperature, target->temperature);
+}
+
+AcModel* ac_model_alloc(const AcModelSpec* spec) {
+    ac_model_check_setting(&spec->mode, AC_MODEL_MODES_MAX);
+    ac_model_check_setting(&spec->fan_speed, AC_MODEL_FAN_SPEEDS_MAX);
+    ac_model_check_setting(&spec->temperature, AC_MODEL_TEMPERATURES_MAX);
+
+    AcModel* model = malloc(sizeof(AcModel));
+    model->spec = *spec;
+    model->state_count = 2 * ac_model_get_slot_count(&spec->mode) *
+                         ac_model_get_slot_count(&spec->fan_speed) *
+                         ac_model_get_slot_count(&spec->temperature);
+
+    model->previous = malloc(model->state_count * sizeof(uint16_t));
+    model->button = malloc(model->state_count * sizeof(uint8_t));
+    model->queue = malloc(model->state_count * sizeof(uint16_t));
+
+    return model;
+}
+
+void ac_model_free(AcModel* model) {
+    free(model->previous);
+    free(model->button);
+    free(model->queue);
+    free(model);
+}
+
+bool ac_model_is_valid(const AcModel* model, const AcModelState* state) {
+    const AcModelSpec* spec = &model->spec;
+    return ac_model_is_valid_value(&spec->mode, state->mode) &&
+           ac_model_is_valid_value(&spec->fan_speed, state->fan_speed) &&
+           ac_model_is_valid_value(&spec->temperature, state->temperature);
+}
+
+bool ac_model_is_ignored(const AcModelState* state, AcModelButton button) {
+    return !state->is_on && button != AcModelButtonPower;
+}
+
+void ac_model_press(const AcModel* model, AcModelState* state, AcModelButton button) {
+    const AcModelSpec* spec = &model->spec;
+    furi_assert(ac_model_is_valid(model, state));
+
+    if(ac_model_is_ignored(state, button)) return;
+
+    switch(button) {
+    case AcModelButtonPower:
+        state->is_on = !state->is_on;
+        if(state->is_on) {
+            ac_model_power_on(&spec->mode, &state->mode);
+            ac_model_power_on(&spec->fan_speed, &state->fan_speed);
+            ac_model_power_on(&spec->temperature, &state->temperature);
+        }
+        break;
+    case AcModelButtonMode:
+        ac_model_step(&spec->mode, &state->mode);
+        break;
+    case AcModelButtonFanSpeed:
+        ac_model_step(&spec->fan_speed, &state->fan_speed);
+        break;
+    case AcModelButtonLowerTemp:
+        ac_model_step(&spec->temperature, &state->temperature);
+        break;
+    default:
+        furi_crash("Unknown button");
+    }
+}
+
+bool ac_model_plan(
+    AcModel* model,
+    const AcModelState* from,
+    const AcModelState* target,
+    AcModelButton* buttons,
+    size_t capacity,
+    size_t* button_count) {
+    furi_assert(ac_model_is_valid(model, from));
+
+    memset(model->previous, 0xFF, model->state_count * sizeof(uint16_t));
+
+    const size_t start = ac_model_get_index(model, from);
+    model->previous[start] = start;
+    model->queue[0] = start;
+    size_t head = 0, tail = 1;
+
+    // Every press costs the same, so states are reached in order of distance from the start.
+    bool is_found = ac_model_is_target(from, target);
+    size_t found = start;
+    while(!is_found && head < tail) {
+        const size_t index = model->queue[head++];
+        AcModelState state;
+        ac_model_get_state(model, index, &state);
+
+        for(size_t button = 0; button < AcModelButtonCount && !is_found; ++button) {
+            AcModelState next = state;
+            ac_model_press(model, &next, button);
+
+            const size_t next_index = ac_model_get_index(model, &next);
+            if(model->previous[next_index] != AC_MODEL_UNVISITED) continue;
+
+            model->previous[next_index] = index;
+            model->button[next_index] = button;
+            model->queue[tail++] = next_index;
+
+            if(ac_model_is_target(&next, target)) {
+                is_found = true;
+                found = next_index;
+            }
+        }
+    }
+
+    if(!is_found) {
+        FURI_LOG_W(TAG, "Target state unreachable");
+        return false;
+    }
+
+    // Walk back from the target to count the presses, then again to fill them in.
+    size_t count = 0;
+    for(size_t index = found; index != start; index = model->previous[index]) {
+        ++count;
+    }
+    if(count > capacity) {
+        FURI_LOG_W(TAG, "Target state %zu presses away, more than %zu", count, capacity);
+        return false;
+    }
+
+    *button_count = count;
+    for(size_t index = found; index != start; index = model->previous[index]) {
+        buttons[--count] = model->button[index];
+    }
+
+    return true;
+}
+
+uint32_t ac_model_pack_settings(const AcModelState* state) {
+    return AC_MODEL_SETTINGS_MARKER | ((uint32_t)state->mode << 16) |
+           ((uint32_t)state->fan_speed << 8) | state->temperature;
+}
+
+bool ac_model_unpack_settings(const AcModel* model, uint32_t settings, AcModelState* state) {
+    if(!(settings & AC_MODEL_SETTINGS_MARKER)) return false;
+
+    AcModelState unpacked = {
+        .is_on = state->is_on,
+        .mode = (settings >> 16) & 0xFF,
+        .fan_speed = (settings >> 8) & 0xFF,
+        .temperature = settings & 0xFF,
+    };
+    if(!ac_model_is_valid(model, &unpacked)) return false;
+
+    *state = unpacked;
+    return true;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file ac_model.h
+ * @brief State machine of an A/C, as driven by its remote, and button planner.
+ *
+ * The state of a unit is whether it is on, its mode, its fan speed and its
+ * temperature setpoint. The remote has no button to set any of them directly,
+ * only buttons that step them:
+ * - Power toggles the unit on or off; a unit may power on with some settings
+ *   reset to a fixed value, and keeps the others,
+ * - Mode steps to the next mode,
+ * - Fan_speed steps to the next fan speed,
+ * - Lower_temp steps the setpoint down.
+ * The unit ignores every button but Power while it is off.
+ *
+ * Only the values of a setting that are known are modelled, from the first one
+ * on. Stepping past the last known value goes back to the first if the number
+ * of values is known to be exact, and otherwise leaves the setting
+ * AC_MODEL_UNKNOWN until Power resets it. A setting with no known value is not
+ * tracked: it is always AC_MODEL_UNKNOWN, and its button changes nothing in the
+ * model.
+ *
+ * The planner finds the fewest button presses taking a unit from its tracked
+ * state to a target state, with a breadth-first search over every state of the
+ * model. The search buffers are allocated with the model, so planning does not
+ * allocate.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Setting value, in a target state, matching any value of that setting.
+#define AC_MODEL_ANY (0xFFU)
+// Setting value of a state when the setting is not known.
+#define AC_MODEL_UNKNOWN (0xFEU)
+
+#define AC_MODEL_MODES_MAX (8U)
+#define AC_MODEL_FAN_SPEEDS_MAX (8U)
+#define AC_MODEL_TEMPERATURES_MAX (32U)
+
+/**
+ * @brief Remote buttons, in the same order as in Ac.ir.
+ */
+typedef enum {
+    AcModelButtonPower,
+    AcModelButtonMode,
+    AcModelButtonFanSpeed,
+    AcModelButtonLowerTemp,
+    AcModelButtonCount,
+} AcModelButton;
+
+/**
+ * @brief Description of one setting of a unit.
+ */
+typedef struct {
+    uint8_t count; /**< Number of known values, 0 if the setting is not tracked. */
+    bool is_exact; /**< Whether count is every value, so that stepping past the last one wraps. */
+    uint8_t power_on; /**< Value the unit powers on with, AC_MODEL_ANY if it keeps the setting. */
+} AcModelSettingSpec;
+
+/**
+ * @brief Description of the state machine of a unit.
+ *
+ * Modes and fan speeds are numbered in the order Mode and Fan_speed step through
+ * them, setpoints in the order Lower_temp steps through them, from the highest.
+ */
+typedef struct {
+    AcModelSettingSpec mode; /**< At most AC_MODEL_MODES_MAX values. */
+    AcModelSettingSpec fan_speed; /**< At most AC_MODEL_FAN_SPEEDS_MAX values. */
+    AcModelSettingSpec temperature; /**< At most AC_MODEL_TEMPERATURES_MAX values. */
+} AcModelSpec;
+
+/**
+ * @brief State of a unit.
+ *
+ * Any setting may be AC_MODEL_UNKNOWN, and in a target state AC_MODEL_ANY.
+ */
+typedef struct {
+    bool is_on;
+    uint8_t mode; /**< Index of the mode, from 0. */
+    uint8_t fan_speed; /**< Index of the fan speed, from 0. */
+    uint8_t temperature; /**< Index of the setpoint, from 0 for the highest. */
+} AcModelState;
+
+/**
+ * @brief AcModel opaque type declaration.
+ */
+typedef struct AcModel AcModel;
+
+/**
+ * @brief Create a new AcModel instance.
+ *
+ * @param[in] spec pointer to the description of the state machine, copied into the instance.
+ * @returns pointer to the instance created.
+ */
+AcModel* ac_model_alloc(const AcModelSpec* spec);
+
+/**
+ * @brief Delete an AcModel instance.
+ *
+ * @param[in,out] model pointer to the instance to be deleted.
+ */
+void ac_model_free(AcModel* model);
+
+/**
+ * @brief Test whether a state is a valid state of the model.
+ *
+ * @param[in] model pointer to the instance.
+ * @param[in] state pointer to the state to be tested.
+ * @returns true if every setting of the state is in range or unknown, false otherwise.
+ */
+bool ac_model_is_valid(const AcModel* model, const AcModelState* state);
+
+/**
+ * @brief Test whether a unit ignores a button in a state.
+ *
+ * @param[in] state pointer to a valid state.
+ * @param[in] button button pressed.
+ * @returns true if the press does nothing to the unit, false otherwise.
+ */
+bool ac_model_is_ignored(const AcModelState* state, AcModelButton button);
+
+/**
+ * @brief Apply a button press to a state.
+ *
+ * @param[in] model pointer to the instance.
+ * @param[in,out] state pointer to a valid state, updated to the state after the press.
+ * @param[in] button button pressed.
+ */
+void ac_model_press(const AcModel* model, AcModelState* state, AcModelButton button);
+
+/**
+ * @brief Find the shortest button sequence from a state to a target.
+ *
+ * Among sequences of the same length, the one found is always the same.
+ *
+ * @param[in,out] model pointer to the instance, whose search buffers are used.
+ * @param[in] from pointer to the valid state to start from.
+ * @param[in] target pointer to the target state, settings may be AC_MODEL_ANY.
+ * @param[out] buttons pointer to the array to hold the buttons to press, in order.
+ * @param[in] capacity number of elements in the buttons array.
+ * @param[out] button_count pointer to the variable to hold the number of buttons, 0 if already there.
+ * @returns true if a sequence of at most capacity buttons reaches the target, false otherwise.
+ */
+bool ac_model_plan(
+    AcModel* model,
+    const AcModelState* from,
+    const AcModelState* target,
+    AcModelButton* buttons,
+    size_t capacity,
+    size_t* button_count);
+
+/**
+ * @brief Pack the settings of a state, leaving out whether it is on, into a single value.
+ *
+ * @param[in] state pointer to the state to be packed.
+ * @returns packed settings, never 0.
+ */
+uint32_t ac_model_pack_settings(const AcModelState* state);
+
+/**
+ * @brief Unpack settings packed by ac_model_pack_settings() into a state.
+ *
+ * @param[in] model pointer to the instance.
+ * @param[in] settings packed settings.
+ * @param[in,out] state pointer to the state whose settings are to be replaced.
+ * @returns true if the settings are valid for the model, false otherwise (the state is unchanged).
+ */
+bool ac_model_unpack_settings(const AcModel* model, uint32_t settings, AcModelState* state);
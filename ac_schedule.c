@@ -0,0 +1,363 @@
+#include "ac_schedule.h"
+
+#include <furi.h>
+#include <furi_hal_rtc.h>
+#include <flipper_format/flipper_format.h>
+
+#define TAG "AcSchedule"
+
+// Schedule file keys
+#define AC_SCHEDULE_TYPE_KEY "type"
+#define AC_SCHEDULE_PERIOD_KEY "period"
+#define AC_SCHEDULE_OFFSET_KEY "offset"
+#define AC_SCHEDULE_DAY_KEY "day"
+#define AC_SCHEDULE_TIME_KEY "time"
+#define AC_SCHEDULE_ACTION_KEY "action"
+
+// Type key values
+#define AC_SCHEDULE_TYPE_CYCLE "cycle"
+#define AC_SCHEDULE_TYPE_DAILY "daily"
+#define AC_SCHEDULE_TYPE_WEEKLY "weekly"
+
+#define AC_SCHEDULE_SECONDS_PER_MINUTE (60UL)
+#define AC_SCHEDULE_SECONDS_PER_DAY (86400UL)
+#define AC_SCHEDULE_SECONDS_PER_WEEK (7 * AC_SCHEDULE_SECONDS_PER_DAY)
+// Timestamp 0 was a Thursday, the first Monday was 4 days later.
+#define AC_SCHEDULE_FIRST_MONDAY (4 * AC_SCHEDULE_SECONDS_PER_DAY)
+// Longest cycle period, so that the delay to any event fits in a signed 32-bit count of
+// milliseconds, as ticks are compared with one another.
+#define AC_SCHEDULE_MAX_PERIOD (3 * AC_SCHEDULE_SECONDS_PER_WEEK)
+
+// Maximum number of events reported per timer expiry, the rest follow one tick later.
+#define AC_SCHEDULE_BATCH_SIZE (8U)
+
+struct AcSchedule {
+    AcScheduleEvent* events;
+    uint32_t* due; /**< RTC timestamp of the next occurrence of each event. */
+    size_t* heap; /**< Event indices, ordered by due time then index. */
+    size_t count;
+    size_t capacity;
+
+    FuriTimer* timer;
+    AcScheduleCallback callback;
+    void* context;
+
+    bool is_running;
+    uint32_t anchor;
+    uint32_t next_tick;
+};
+
+static void ac_schedule_get_period(
+    const AcSchedule* schedule,
+    const AcScheduleEvent* event,
+    uint32_t* reference,
+    uint32_t* period) {
+    switch(event->type) {
+    case AcScheduleEventTypeCycle:
+        *reference = schedule->anchor + event->offset;
+        *period = event->period;
+        break;
+    case AcScheduleEventTypeDaily:
+        *reference = event->offset;
+        *period = AC_SCHEDULE_SECONDS_PER_DAY;
+        break;
+    case AcScheduleEventTypeWeekly:
+    default:
+        *reference = AC_SCHEDULE_FIRST_MONDAY + event->offset;
+        *period = AC_SCHEDULE_SECONDS_PER_WEEK;
+        break;
+    }
+}
+
+// First occurrence of an event at or after a given timestamp.
+static uint32_t
+    ac_schedule_get_occurrence(const AcSchedule* schedule, size_t index, uint32_t timestamp) {
+    uint32_t reference, period;
+    ac_schedule_get_period(schedule, &schedule->events[index], &reference, &period);
+
+    if(timestamp <= reference) {
+        return reference - (reference - timestamp) / period * period;
+    } else {
+        return timestamp + (period - (timestamp - reference) % period) % period;
+    }
+}
+
+static inline bool ac_schedule_heap_less(const AcSchedule* schedule, size_t lhs, size_t rhs) {
+    const size_t a = schedule->heap[lhs];
+    const size_t b = schedule->heap[rhs];
+    return schedule->due[a] != schedule->due[b] ? schedule->due[a] < schedule->due[b] : a < b;
+}
+
+static void ac_schedule_heap_sift_down(AcSchedule* schedule, size_t position) {
+    for(;;) {
+        size_t smallest = position;
+        const size_t left = 2 * position + 1;
+        const size_t right = left + 1;
+
+        if(left < schedule->count && ac_schedule_heap_less(schedule, left, smallest)) {
+            smallest = left;
+        }
+        if(right < schedule->count && ac_schedule_heap_less(schedule, right, smallest)) {
+            smallest = right;
+        }
+        if(smallest == position) break;
+
+        const size_t tmp = schedule->heap[position];
+        schedule->heap[position] = schedule->heap[smallest];
+        schedule->heap[smallest] = tmp;
+        position = smallest;
+    }
+}
+
+static void ac_schedule_heap_build(AcSchedule* schedule) {
+    for(size_t i = 0; i < schedule->count; ++i) {
+        schedule->heap[i] = i;
+    }
+    for(size_t i = schedule->count / 2; i-- > 0;) {
+        ac_schedule_heap_sift_down(schedule, i);
+    }
+}
+
+static void ac_schedule_arm(AcSchedule* schedule, uint32_t now) {
+    const uint32_t due = schedule->due[schedule->heap[0]];
+    // Events are never more than AC_SCHEDULE_MAX_PERIOD away.
+    const uint32_t delay_ms = due > now ? (due - now) * 1000 : 0;
+    // Always go through the timer, so that callbacks only ever run on the timer thread.
+    const uint32_t ticks = MAX(furi_ms_to_ticks(delay_ms), 1UL);
+
+    schedule->next_tick = furi_get_tick() + ticks;
+    furi_timer_start(schedule->timer, ticks);
+}
+
+static void ac_schedule_timer_callback(void* context) {
+    AcSchedule* schedule = context;
+    if(!schedule->is_running) return;
+
+    const uint32_t now = furi_hal_rtc_get_timestamp();
+    size_t batch[AC_SCHEDULE_BATCH_SIZE];
+    size_t batch_size = 0;
+
+    // Move every due event to its next occurrence before reporting any of them,
+    // so that callbacks see the schedule already armed for what comes next.
+    while(batch_size < AC_SCHEDULE_BATCH_SIZE) {
+        const size_t index = schedule->heap[0];
+        if(schedule->due[index] > now) break;
+
+        batch[batch_size++] = index;
+        schedule->due[index] = ac_schedule_get_occurrence(schedule, index, now + 1);
+        ac_schedule_heap_sift_down(schedule, 0);
+    }
+
+    ac_schedule_arm(schedule, now);
+
+    for(size_t i = 0; i < batch_size; ++i) {
+        FURI_LOG_D(TAG, "Event %zu due: %s", batch[i], schedule->events[batch[i]].action);
+        schedule->callback(&schedule->events[batch[i]], schedule->context);
+    }
+}
+
+static bool ac_schedule_is_valid(const AcScheduleEvent* event) {
+    if(event->action[0] == '\0') return false;
+    if(memchr(event->action, '\0', AC_SCHEDULE_ACTION_SIZE) == NULL) return false;
+
+    switch(event->type) {
+    case AcScheduleEventTypeCycle:
+        return event->period > 0 && event->period <= AC_SCHEDULE_MAX_PERIOD &&
+               event->offset < event->period;
+    case AcScheduleEventTypeDaily:
+        return event->offset < AC_SCHEDULE_SECONDS_PER_DAY;
+    case AcScheduleEventTypeWeekly:
+        return event->offset < AC_SCHEDULE_SECONDS_PER_WEEK;
+    default:
+        return false;
+    }
+}
+
+static bool ac_schedule_read_time(FlipperFormat* ff, uint32_t* offset) {
+    uint32_t time[2];
+    if(!flipper_format_read_uint32(ff, AC_SCHEDULE_TIME_KEY, time, COUNT_OF(time))) return false;
+    if(time[0] >= 24 || time[1] >= 60) return false;
+
+    *offset = (time[0] * 60 + time[1]) * AC_SCHEDULE_SECONDS_PER_MINUTE;
+    return true;
+}
+
+static bool ac_schedule_read_event(FlipperFormat* ff, const FuriString* type, AcScheduleEvent* event) {
+    FuriString* tmp = furi_string_alloc();
+    bool success = false;
+
+    do {
+        if(furi_string_equal(type, AC_SCHEDULE_TYPE_CYCLE)) {
+            event->type = AcScheduleEventTypeCycle;
+            if(!flipper_format_read_uint32(ff, AC_SCHEDULE_PERIOD_KEY, &event->period, 1)) break;
+            if(!flipper_format_read_uint32(ff, AC_SCHEDULE_OFFSET_KEY, &event->offset, 1)) break;
+            // Larger values would wrap around once in seconds.
+            if(event->period > AC_SCHEDULE_MAX_PERIOD / AC_SCHEDULE_SECONDS_PER_MINUTE ||
+               event->offset >= event->period) {
+                FURI_LOG_E(TAG, "Invalid period %lu or offset %lu", event->period, event->offset);
+                break;
+            }
+            event->period *= AC_SCHEDULE_SECONDS_PER_MINUTE;
+            event->offset *= AC_SCHEDULE_SECONDS_PER_MINUTE;
+
+        } else if(furi_string_equal(type, AC_SCHEDULE_TYPE_DAILY)) {
+            event->type = AcScheduleEventTypeDaily;
+            event->period = 0;
+            if(!ac_schedule_read_time(ff, &event->offset)) break;
+
+        } else if(furi_string_equal(type, AC_SCHEDULE_TYPE_WEEKLY)) {
+            uint32_t day;
+            event->type = AcScheduleEventTypeWeekly;
+            event->period = 0;
+            if(!flipper_format_read_uint32(ff, AC_SCHEDULE_DAY_KEY, &day, 1)) break;
+            if(day < 1 || day > 7) break;
+            if(!ac_schedule_read_time(ff, &event->offset)) break;
+            event->offset += (day - 1) * AC_SCHEDULE_SECONDS_PER_DAY;
+
+        } else {
+            FURI_LOG_E(TAG, "Unknown event type: %s", furi_string_get_cstr(type));
+            break;
+        }
+
+        if(!flipper_format_read_string(ff, AC_SCHEDULE_ACTION_KEY, tmp)) break;
+        if(furi_string_size(tmp) >= AC_SCHEDULE_ACTION_SIZE) break;
+        strlcpy(event->action, furi_string_get_cstr(tmp), AC_SCHEDULE_ACTION_SIZE);
+
+        success = ac_schedule_is_valid(event);
+    } while(false);
+
+    furi_string_free(tmp);
+    return success;
+}
+
+AcSchedule* ac_schedule_alloc(AcScheduleCallback callback, void* context) {
+    furi_assert(callback);
+    AcSchedule* schedule = malloc(sizeof(AcSchedule));
+
+    schedule->events = NULL;
+    schedule->due = NULL;
+    schedule->heap = NULL;
+    schedule->count = 0;
+    schedule->capacity = 0;
+
+    schedule->timer = furi_timer_alloc(ac_schedule_timer_callback, FuriTimerTypeOnce, schedule);
+    schedule->callback = callback;
+    schedule->context = context;
+
+    schedule->is_running = false;
+    schedule->anchor = 0;
+    schedule->next_tick = 0;
+
+    return schedule;
+}
+
+void ac_schedule_free(AcSchedule* schedule) {
+    ac_schedule_stop(schedule);
+    furi_timer_free(schedule->timer);
+    free(schedule->events);
+    free(schedule->due);
+    free(schedule->heap);
+    free(schedule);
+}
+
+bool ac_schedule_add(AcSchedule* schedule, const AcScheduleEvent* event) {
+    furi_assert(!schedule->is_running);
+
+    if(!ac_schedule_is_valid(event)) {
+        FURI_LOG_E(TAG, "Invalid event: %.*s", (int)AC_SCHEDULE_ACTION_SIZE, event->action);
+        return false;
+    }
+
+    if(schedule->count == schedule->capacity) {
+        schedule->capacity = schedule->capacity ? schedule->capacity * 2 : 4;
+        schedule->events =
+            realloc(schedule->events, schedule->capacity * sizeof(AcScheduleEvent));
+        schedule->due = realloc(schedule->due, schedule->capacity * sizeof(uint32_t));
+        schedule->heap = realloc(schedule->heap, schedule->capacity * sizeof(size_t));
+    }
+
+    schedule->events[schedule->count++] = *event;
+    return true;
+}
+
+bool ac_schedule_load(AcSchedule* schedule, Storage* storage, const char* path) {
+    furi_assert(!schedule->is_running);
+
+    FlipperFormat* ff = flipper_format_buffered_file_alloc(storage);
+    FuriString* tmp = furi_string_alloc();
+    const size_t count = schedule->count;
+    bool success = false;
+
+    do {
+        uint32_t version;
+        if(!flipper_format_buffered_file_open_existing(ff, path)) break;
+        if(!flipper_format_read_header(ff, tmp, &version)) break;
+        if(!furi_string_equal(tmp, AC_SCHEDULE_FILE_TYPE) ||
+           version != AC_SCHEDULE_FILE_VERSION) {
+            FURI_LOG_E(TAG, "Unsupported schedule file: %s", path);
+            break;
+        }
+
+        // Every event starts with its type, the first missing one marks the end of the file.
+        bool is_valid = true;
+        while(flipper_format_read_string(ff, AC_SCHEDULE_TYPE_KEY, tmp)) {
+            AcScheduleEvent event;
+            if(!ac_schedule_read_event(ff, tmp, &event) || !ac_schedule_add(schedule, &event)) {
+                FURI_LOG_E(
+                    TAG, "Invalid event #%zu in %s", schedule->count - count + 1, path);
+                is_valid = false;
+                break;
+            }
+        }
+
+        success = is_valid;
+    } while(false);
+
+    if(!success) {
+        schedule->count = count;
+    }
+
+    flipper_format_buffered_file_close(ff);
+    flipper_format_free(ff);
+    furi_string_free(tmp);
+
+    return success;
+}
+
+size_t ac_schedule_get_count(const AcSchedule* schedule) {
+    return schedule->count;
+}
+
+void ac_schedule_start(AcSchedule* schedule, uint32_t anchor) {
+    furi_assert(!schedule->is_running);
+
+    const uint32_t now = furi_hal_rtc_get_timestamp();
+    furi_assert(anchor <= now);
+
+    schedule->anchor = anchor;
+    for(size_t i = 0; i < schedule->count; ++i) {
+        schedule->due[i] = ac_schedule_get_occurrence(schedule, i, now);
+    }
+    ac_schedule_heap_build(schedule);
+
+    schedule->is_running = schedule->count > 0;
+    if(schedule->is_running) {
+        ac_schedule_arm(schedule, now);
+    }
+}
+
+void ac_schedule_stop(AcSchedule* schedule) {
+    schedule->is_running = false;
+    furi_timer_stop(schedule->timer);
+}
+
+uint32_t ac_schedule_get_anchor(const AcSchedule* schedule) {
+    return schedule->anchor;
+}
+
+const AcScheduleEvent* ac_schedule_get_next(const AcSchedule* schedule, uint32_t* tick) {
+    if(!schedule->is_running) return NULL;
+
+    *tick = schedule->next_tick;
+    return &schedule->events[schedule->heap[0]];
+}
@@ -0,0 +1,156 @@
+/**
+ * @file ac_schedule.h
+ * @brief Timed event schedule.
+ *
+ * A schedule is a list of recurring events, each naming an action to run:
+ * - cycle events repeat every period, at an offset from the schedule anchor,
+ * - daily events run at a given local time every day,
+ * - weekly events run at a given local time on a given day of the week.
+ *
+ * Pending events are kept in a min-heap ordered by due time and a single
+ * one-shot timer is armed for the earliest one, so the schedule wakes up exactly
+ * when an event is due and never in between.
+ *
+ * Schedule files use the FlipperFormat syntax:
+ *
+ *     Filetype: AC schedule file
+ *     Version: 1
+ *     #
+ *     type: cycle
+ *     period: 240
+ *     offset: 60
+ *     action: off
+ *     #
+ *     type: weekly
+ *     day: 6
+ *     time: 9 30
+ *     action: on
+ *
+ * Periods and offsets are in minutes, periods of at most 3 weeks (30240
+ * minutes), times are given as hour and minute and days go from 1 (Monday) to 7
+ * (Sunday).
+ */
+#pragma once
+
+#include <storage/storage.h>
+
+#define AC_SCHEDULE_FILE_TYPE "AC schedule file"
+#define AC_SCHEDULE_FILE_VERSION (1)
+
+#define AC_SCHEDULE_ACTION_SIZE (16U)
+
+/**
+ * @brief Event type.
+ */
+typedef enum {
+    AcScheduleEventTypeCycle, /**< Repeats every period, relative to the schedule anchor. */
+    AcScheduleEventTypeDaily, /**< Repeats every day, relative to local midnight. */
+    AcScheduleEventTypeWeekly, /**< Repeats every week, relative to Monday, local midnight. */
+} AcScheduleEventType;
+
+/**
+ * @brief Scheduled event.
+ */
+typedef struct {
+    AcScheduleEventType type; /**< Event type. */
+    uint32_t period; /**< Repetition period in seconds, at most 3 weeks, cycle events only. */
+    uint32_t offset; /**< Offset in seconds from the start of the period. */
+    char action[AC_SCHEDULE_ACTION_SIZE]; /**< Zero-terminated name of the action to run. */
+} AcScheduleEvent;
+
+/**
+ * @brief Event callback type.
+ *
+ * Called from the timer service thread when an event is due. Events due at the
+ * same time are reported in the order they were added.
+ *
+ * @param[in] event pointer to the event that is due.
+ * @param[in] context pointer to the user-defined context.
+ */
+typedef void (*AcScheduleCallback)(const AcScheduleEvent* event, void* context);
+
+/**
+ * @brief AcSchedule opaque type declaration.
+ */
+typedef struct AcSchedule AcSchedule;
+
+/**
+ * @brief Create a new, empty AcSchedule instance.
+ *
+ * @param[in] callback pointer to the function called when an event is due.
+ * @param[in] context pointer to the user-defined context passed to the callback.
+ * @returns pointer to the instance created.
+ */
+AcSchedule* ac_schedule_alloc(AcScheduleCallback callback, void* context);
+
+/**
+ * @brief Delete an AcSchedule instance, stopping it if needed.
+ *
+ * @param[in,out] schedule pointer to the instance to be deleted.
+ */
+void ac_schedule_free(AcSchedule* schedule);
+
+/**
+ * @brief Add an event to a stopped AcSchedule instance.
+ *
+ * @param[in,out] schedule pointer to the instance to be modified.
+ * @param[in] event pointer to the event to be added, copied into the instance.
+ * @returns true if the event was added, false if it is invalid.
+ */
+bool ac_schedule_add(AcSchedule* schedule, const AcScheduleEvent* event);
+
+/**
+ * @brief Add the events from a schedule file to a stopped AcSchedule instance.
+ *
+ * Nothing is added unless the whole file is valid.
+ *
+ * @param[in,out] schedule pointer to the instance to be modified.
+ * @param[in] storage pointer to the storage record.
+ * @param[in] path pointer to a zero-terminated string containing the schedule file path.
+ * @returns true if the file was successfully loaded, false otherwise.
+ */
+bool ac_schedule_load(AcSchedule* schedule, Storage* storage, const char* path);
+
+/**
+ * @brief Get the number of events in an AcSchedule instance.
+ *
+ * @param[in] schedule pointer to the instance to be queried.
+ * @returns number of events.
+ */
+size_t ac_schedule_get_count(const AcSchedule* schedule);
+
+/**
+ * @brief Start an AcSchedule instance.
+ *
+ * Each event first runs at its first occurrence at or after the current time,
+ * occurrences between the anchor and the current time are skipped. Events due at
+ * the current time run right away, from the timer service thread.
+ *
+ * @param[in,out] schedule pointer to the instance to be started.
+ * @param[in] anchor RTC timestamp from which cycle events are counted, at most the current time.
+ */
+void ac_schedule_start(AcSchedule* schedule, uint32_t anchor);
+
+/**
+ * @brief Stop an AcSchedule instance.
+ *
+ * @param[in,out] schedule pointer to the instance to be stopped.
+ */
+void ac_schedule_stop(AcSchedule* schedule);
+
+/**
+ * @brief Get the anchor of a started AcSchedule instance.
+ *
+ * @param[in] schedule pointer to the instance to be queried.
+ * @returns RTC timestamp passed to ac_schedule_start().
+ */
+uint32_t ac_schedule_get_anchor(const AcSchedule* schedule);
+
+/**
+ * @brief Get the next event of a started AcSchedule instance.
+ *
+ * @param[in] schedule pointer to the instance to be queried.
+ * @param[out] tick pointer to the variable to hold the kernel tick at which the event is due.
+ * @returns pointer to the next event, or NULL if the schedule is stopped or empty.
+ */
+const AcScheduleEvent* ac_schedule_get_next(const AcSchedule* schedule, uint32_t* tick);
@@ -0,0 +1,76 @@
+#include "ac_units.h"
+
+#include <furi.h>
+#include <flipper_format/flipper_format.h>
+
+#define TAG "AcUnits"
+
+// Units file keys
+#define AC_UNITS_NAME_KEY "name"
+#define AC_UNITS_ADDRESS_KEY "address"
+#define AC_UNITS_GAP_KEY "gap"
+#define AC_UNITS_VERIFY_KEY "verify"
+// Version 2 key, only read as whether it is 0.
+#define AC_UNITS_RETRIES_KEY "retries"
+
+static bool ac_units_read_unit(
+    FlipperFormat* ff,
+    uint32_t version,
+    const FuriString* name,
+    AcUnit* unit) {
+    if(furi_string_size(name) >= AC_UNIT_NAME_SIZE) return false;
+    strlcpy(unit->name, furi_string_get_cstr(name), AC_UNIT_NAME_SIZE);
+    unit->is_verified = false;
+
+    if(!flipper_format_read_hex(ff, AC_UNITS_ADDRESS_KEY, (uint8_t*)&unit->address, 4) ||
+       !flipper_format_read_uint32(ff, AC_UNITS_GAP_KEY, &unit->gap_ms, 1)) {
+        return false;
+    }
+
+    if(version == 2) {
+        uint32_t retries;
+        if(!flipper_format_read_uint32(ff, AC_UNITS_RETRIES_KEY, &retries, 1)) return false;
+        unit->is_verified = retries > 0;
+    } else if(version > 2) {
+        if(!flipper_format_read_bool(ff, AC_UNITS_VERIFY_KEY, &unit->is_verified, 1)) return false;
+    }
+
+    return true;
+}
+
+size_t ac_units_load(Storage* storage, const char* path, AcUnit* units, size_t capacity) {
+    FlipperFormat* ff = flipper_format_buffered_file_alloc(storage);
+    FuriString* tmp = furi_string_alloc();
+    size_t count = 0;
+    bool success = false;
+
+    do {
+        uint32_t version;
+        if(!flipper_format_buffered_file_open_existing(ff, path)) break;
+        if(!flipper_format_read_header(ff, tmp, &version)) break;
+        if(!furi_string_equal(tmp, AC_UNITS_FILE_TYPE) || version < 1 ||
+           version > AC_UNITS_FILE_VERSION) {
+            FURI_LOG_E(TAG, "Unsupported units file: %s", path);
+            break;
+        }
+
+        // Every unit starts with its name, the first missing one marks the end of the file.
+        bool is_valid = true;
+        while(flipper_format_read_string(ff, AC_UNITS_NAME_KEY, tmp)) {
+            if(count == capacity || !ac_units_read_unit(ff, version, tmp, &units[count])) {
+                FURI_LOG_E(TAG, "Invalid unit #%zu in %s", count + 1, path);
+                is_valid = false;
+                break;
+            }
+            ++count;
+        }
+
+        success = is_valid && count > 0;
+    } while(false);
+
+    flipper_format_buffered_file_close(ff);
+    flipper_format_free(ff);
+    furi_string_free(tmp);
+
+    return success ? count : 0;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file ac_units.h
+ * @brief A/C units driven by the app.
+ *
+ * Each unit is an A/C listening on its own NECext address. Units files use the
+ * FlipperFormat syntax:
+ *
+ *     Filetype: AC units file
+ *     Version: 3
+ *     #
+ *     name: Living room
+ *     address: 98 6F 00 00
+ *     gap: 100
+ *     verify: true
+ *
+ * The address is written like in signal files and the gap is the minimum time,
+ * in milliseconds, the unit needs between the end of a frame and the next one.
+ * Verify is true for units that echo what they receive, to listen for each frame
+ * to be heard back. Frames are never sent again, so version 2 files, which have
+ * a retries count instead, are read as verified if it is not 0, and version 1
+ * files, which have neither, are read as not verified.
+ */
+#pragma once
+
+#include <storage/storage.h>
+
+#define AC_UNITS_FILE_TYPE "AC units file"
+#define AC_UNITS_FILE_VERSION (3)
+
+#define AC_UNITS_MAX (8U)
+#define AC_UNIT_NAME_SIZE (16U)
+
+/**
+ * @brief A/C unit.
+ */
+typedef struct {
+    char name[AC_UNIT_NAME_SIZE]; /**< Zero-terminated name, for logs. */
+    uint32_t address; /**< NECext address of the unit. */
+    uint32_t gap_ms; /**< Minimum gap between two frames sent to the unit. */
+    bool is_verified; /**< Whether frames are listened for to be heard back. */
+} AcUnit;
+
+/**
+ * @brief Read the units from a units file.
+ *
+ * The file must hold between 1 and capacity units, all of them valid, otherwise
+ * it is rejected as a whole.
+ *
+ * @param[in] storage pointer to the storage record.
+ * @param[in] path pointer to a zero-terminated string containing the units file path.
+ * @param[out] units pointer to the array to hold the units.
+ * @param[in] capacity number of elements in the units array.
+ * @returns number of units read, 0 if the file could not be loaded.
+ */
+size_t ac_units_load(Storage* storage, const char* path, AcUnit* units, size_t capacity);
@@ -0,0 +1,201 @@
+#include "event_trace.h"
+
+#include <furi.h>
+#include <furi_hal_cortex.h>
+#include <stdatomic.h>
+
+#define TAG "EventTrace"
+
+#define EVENT_TRACE_MASK (EVENT_TRACE_CAPACITY - 1)
+
+typedef struct {
+    EventTraceRecord records[EVENT_TRACE_CAPACITY];
+    atomic_uint head; /**< Written by the producer only. */
+    atomic_uint tail; /**< Written by the consumer only. */
+    atomic_uint dropped; /**< Incremented by the producer, reset by the consumer. */
+} EventTraceRing;
+
+struct EventTrace {
+    EventTraceRing* rings;
+    size_t producer_count;
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t tick_frequency;
+    uint32_t cycles_per_us;
+    uint32_t record_size;
+} EventTraceHeader;
+
+EventTrace* event_trace_alloc(size_t producer_count) {
+    furi_assert(producer_count <= UINT8_MAX);
+    EventTrace* trace = malloc(sizeof(EventTrace));
+
+    trace->rings = malloc(producer_count * sizeof(EventTraceRing));
+    trace->producer_count = producer_count;
+
+    for(size_t i = 0; i < producer_count; ++i) {
+        atomic_init(&trace->rings[i].head, 0);
+        atomic_init(&trace->rings[i].tail, 0);
+        atomic_init(&trace->rings[i].dropped, 0);
+    }
+
+    return trace;
+}
+
+void event_trace_free(EventTrace* trace) {
+    free(trace->rings);
+    free(trace);
+}
+
+void event_trace_record(
+    EventTrace* trace,
+    size_t producer,
+    EventTraceType type,
+    uint16_t arg,
+    uint32_t value) {
+    if(!trace) return;
+    furi_assert(producer < trace->producer_count);
+
+    EventTraceRing* ring = &trace->rings[producer];
+    const unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    const unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if(head - tail == EVENT_TRACE_CAPACITY) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    EventTraceRecord* record = &ring->records[head & EVENT_TRACE_MASK];
+    record->tick = furi_get_tick();
+    record->type = type;
+    record->producer = producer;
+    record->arg = arg;
+    record->value = value;
+
+    // Publish the record only once it is complete.
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+uint32_t event_trace_get_cycles(void) {
+    return furi_hal_cortex_timer_get(0).start;
+}
+
+uint32_t event_trace_cycles_to_us(uint32_t cycles) {
+    return cycles / furi_hal_cortex_instructions_per_microsecond();
+}
+
+size_t event_trace_read(
+    EventTrace* trace,
+    size_t producer,
+    EventTraceRecord* records,
+    size_t capacity) {
+    furi_assert(producer < trace->producer_count);
+
+    EventTraceRing* ring = &trace->rings[producer];
+    size_t count = 0;
+
+    const uint32_t dropped = atomic_exchange_explicit(&ring->dropped, 0, memory_order_relaxed);
+    if(dropped > 0 && capacity > 0) {
+        records[count++] = (EventTraceRecord){
+            .tick = furi_get_tick(),
+            .type = EventTraceTypeDropped,
+            .producer = producer,
+            .arg = 0,
+            .value = dropped,
+        };
+    }
+
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    const unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    while(tail != head && count < capacity) {
+        records[count++] = ring->records[tail++ & EVENT_TRACE_MASK];
+    }
+
+    // Hand the slots back to the producer only once they are copied.
+    atomic_store_explicit(&ring->tail, tail, memory_order_release);
+
+    return count;
+}
+
+bool event_trace_is_empty(EventTrace* trace) {
+    for(size_t i = 0; i < trace->producer_count; ++i) {
+        EventTraceRing* ring = &trace->rings[i];
+        if(atomic_load_explicit(&ring->dropped, memory_order_relaxed) > 0) return false;
+        if(atomic_load_explicit(&ring->head, memory_order_relaxed) !=
+           atomic_load_explicit(&ring->tail, memory_order_relaxed)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Move a full trace file aside, in place of the previous one.
+static void event_trace_rotate(Storage* storage, const char* path) {
+    FuriString* old_path = furi_string_alloc_printf("%s%s", path, EVENT_TRACE_OLD_SUFFIX);
+
+    storage_simply_remove(storage, furi_string_get_cstr(old_path));
+    if(storage_common_rename(storage, path, furi_string_get_cstr(old_path)) != FSE_OK) {
+        // Start over in the same file rather than let it grow.
+        storage_simply_remove(storage, path);
+    }
+
+    furi_string_free(old_path);
+}
+
+bool event_trace_dump(EventTrace* trace, Storage* storage, const char* path) {
+    if(event_trace_is_empty(trace)) return true;
+
+    File* file = storage_file_alloc(storage);
+    EventTraceRecord* records = malloc(EVENT_TRACE_CAPACITY * sizeof(EventTraceRecord));
+    bool success = false;
+
+    do {
+        if(!storage_file_open(file, path, FSAM_WRITE, FSOM_OPEN_APPEND)) break;
+
+        if(storage_file_size(file) >= EVENT_TRACE_FILE_MAX_SIZE) {
+            storage_file_close(file);
+            event_trace_rotate(storage, path);
+            if(!storage_file_open(file, path, FSAM_WRITE, FSOM_OPEN_APPEND)) break;
+        }
+
+        if(storage_file_size(file) == 0) {
+            const EventTraceHeader header = {
+                .magic = EVENT_TRACE_MAGIC,
+                .version = EVENT_TRACE_VERSION,
+                .tick_frequency = furi_kernel_get_tick_frequency(),
+                .cycles_per_us = furi_hal_cortex_instructions_per_microsecond(),
+                .record_size = sizeof(EventTraceRecord),
+            };
+            if(storage_file_write(file, &header, sizeof(header)) != sizeof(header)) break;
+        }
+
+        bool is_written = true;
+        for(size_t i = 0; i < trace->producer_count && is_written; ++i) {
+            // Read until the ring is empty.
+            for(size_t count; (count = event_trace_read(
+                                   trace, i, records, EVENT_TRACE_CAPACITY)) > 0;) {
+                const size_t size = count * sizeof(EventTraceRecord);
+                if(storage_file_write(file, records, size) != size) {
+                    is_written = false;
+                    break;
+                }
+            }
+        }
+
+        success = is_written;
+    } while(false);
+
+    if(!success) {
+        FURI_LOG_E(TAG, "Cannot write %s", path);
+    }
+
+    storage_file_close(file);
+    storage_file_free(file);
+    free(records);
+
+    return success;
+}
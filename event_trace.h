@@ -0,0 +1,150 @@
+/**
+ * @file event_trace.h
+ * @brief Binary event trace.
+ *
+ * Recording an event copies a fixed-size record into a ring buffer, with no
+ * formatting, allocation, lock or system call, so that it can be done from timer
+ * callbacks and the transmit path without changing their timing. Each producer
+ * thread has a ring of its own, written by that thread only and read by a single
+ * consumer, so rings need no lock. When a ring is full, new events are dropped
+ * and counted rather than overwriting unread ones.
+ *
+ * The consumer periodically appends the recorded events to a file:
+ * - a header: magic "EVTR", format version, tick frequency, cycles per
+ *   microsecond and record size, all 32-bit little-endian,
+ * - records, as EventTraceRecord.
+ *
+ * Once the file reaches EVENT_TRACE_FILE_MAX_SIZE, it is renamed with the
+ * EVENT_TRACE_OLD_SUFFIX suffix, replacing the previous one, and a new file is
+ * started, so that the trace never takes more than about twice that size.
+ */
+#pragma once
+
+#include <storage/storage.h>
+
+#define EVENT_TRACE_MAGIC (0x52545645UL) // "EVTR"
+#define EVENT_TRACE_VERSION (1U)
+
+// Events per producer, must be a power of two.
+#define EVENT_TRACE_CAPACITY (128U)
+
+// Size from which the trace file is rotated, it then grows by one more dump at most.
+#define EVENT_TRACE_FILE_MAX_SIZE (64U * 1024U)
+#define EVENT_TRACE_OLD_SUFFIX ".old"
+
+/**
+ * @brief Event type, and meaning of the record arguments.
+ */
+typedef enum {
+    EventTraceTypeTxStart, /**< Transmission started: arg is the priority, value the queue depth. */
+    EventTraceTypeTxEnd, /**< Transmission ended: arg is the priority, value the duration in us. */
+    EventTraceTypeTimerFire, /**< Timer callback: arg identifies the timer, value is the lateness in ticks. */
+    EventTraceTypeRender, /**< Screen drawn: value is the duration in us. */
+    EventTraceTypeDropped, /**< Events lost because the ring was full: value is their number. */
+} EventTraceType;
+
+/**
+ * @brief Event record.
+ */
+typedef struct {
+    uint32_t tick; /**< Kernel tick at which the event was recorded. */
+    uint8_t type; /**< EventTraceType. */
+    uint8_t producer; /**< Index of the producer that recorded the event. */
+    uint16_t arg; /**< Type-specific argument. */
+    uint32_t value; /**< Type-specific value. */
+} EventTraceRecord;
+
+/**
+ * @brief EventTrace opaque type declaration.
+ */
+typedef struct EventTrace EventTrace;
+
+/**
+ * @brief Create a new EventTrace instance.
+ *
+ * @param[in] producer_count number of producers, each with its own ring.
+ * @returns pointer to the instance created.
+ */
+EventTrace* event_trace_alloc(size_t producer_count);
+
+/**
+ * @brief Delete an EventTrace instance. No producer may be recording.
+ *
+ * @param[in,out] trace pointer to the instance to be deleted.
+ */
+void event_trace_free(EventTrace* trace);
+
+/**
+ * @brief Record an event, without blocking.
+ *
+ * Each producer must only ever be used from one thread at a time.
+ *
+ * @param[in,out] trace pointer to the instance to record into, may be NULL.
+ * @param[in] producer index of the calling producer.
+ * @param[in] type event type.
+ * @param[in] arg type-specific argument.
+ * @param[in] value type-specific value.
+ */
+void event_trace_record(
+    EventTrace* trace,
+    size_t producer,
+    EventTraceType type,
+    uint16_t arg,
+    uint32_t value);
+
+/**
+ * @brief Get the cycle counter, to measure durations.
+ *
+ * @returns current value of the core cycle counter.
+ */
+uint32_t event_trace_get_cycles(void);
+
+/**
+ * @brief Convert a cycle count into microseconds.
+ *
+ * @param[in] cycles difference between two event_trace_get_cycles() values.
+ * @returns duration in microseconds.
+ */
+uint32_t event_trace_cycles_to_us(uint32_t cycles);
+
+/**
+ * @brief Take the events recorded so far by a producer.
+ *
+ * Must only be called from the consumer thread. If events were dropped, an
+ * EventTraceTypeDropped record comes first.
+ *
+ * @param[in,out] trace pointer to the instance to read from.
+ * @param[in] producer index of the producer.
+ * @param[out] records pointer to the array to hold the records.
+ * @param[in] capacity number of elements in the records array.
+ * @returns number of records taken.
+ */
+size_t event_trace_read(
+    EventTrace* trace,
+    size_t producer,
+    EventTraceRecord* records,
+    size_t capacity);
+
+/**
+ * @brief Tell whether there is nothing to read from any producer.
+ *
+ * Must only be called from the consumer thread.
+ *
+ * @param[in] trace pointer to the instance to be queried.
+ * @returns true if no event was recorded or dropped since the last read, false otherwise.
+ */
+bool event_trace_is_empty(EventTrace* trace);
+
+/**
+ * @brief Append the events recorded so far by every producer to a trace file.
+ *
+ * Must only be called from the consumer thread. The file is not opened if there
+ * is nothing to write. It is rotated first if it reached
+ * EVENT_TRACE_FILE_MAX_SIZE, and the header is written first if it is empty.
+ *
+ * @param[in,out] trace pointer to the instance to read from.
+ * @param[in] storage pointer to the storage record.
+ * @param[in] path pointer to a zero-terminated string containing the trace file path.
+ * @returns true if the events were written, false otherwise.
+ */
+bool event_trace_dump(EventTrace* trace, Storage* storage, const char* path);
@@ -0,0 +1,576 @@
+/*
+ * Measures the throughput and heap usage of the signal library code over
+ * generated libraries of increasing size, plus Ac.ir.
+ *
+ * Usage: signal_bench [results.json]
+ *
+ * Every benchmark reports signals per second, bytes and allocations per signal,
+ * and the peak heap above what was allocated before it started. Heap figures
+ * come from wrapping malloc() and friends at link time (see the Makefile), so
+ * they only cover allocations made by the library and the stand-ins.
+ */
+#include <furi.h>
+#include <flipper_format/flipper_format.h>
+#include <infrared_worker.h>
+#include <malloc.h>
+#include <time.h>
+
+#include "infrared_library_writer.h"
+#include "infrared_signal.h"
+
+// Set by the Makefile to absolute paths, so that the benchmark runs from any directory.
+#ifndef BENCH_DIR
+#define BENCH_DIR "build/bench"
+#endif
+#ifndef BENCH_AC_PATH
+#define BENCH_AC_PATH "../Ac.ir"
+#endif
+#define BENCH_DEFAULT_RESULTS_PATH BENCH_DIR "/results.json"
+
+// One signal in BENCH_RAW_RATIO is raw, with MAX_TIMINGS_AMOUNT timings.
+#define BENCH_RAW_RATIO (8U)
+
+// Benchmarks are repeated until at least this many signals were processed,
+// the in-memory ones BENCH_MEMORY_FACTOR times more.
+#define BENCH_MIN_SIGNALS (10000U)
+#define BENCH_MEMORY_FACTOR (100U)
+
+// Signals looked up by name per lookup benchmark, spread evenly over the library.
+#define BENCH_LOOKUPS (100U)
+
+// How a signal is looked up by name.
+typedef enum {
+    BenchLookupScan, // infrared_signal_search_by_name_and_read() from the start of the file.
+    BenchLookupIndex, // One InfraredIndex kept open for every lookup.
+    BenchLookupFile, // infrared_signal_load_by_name(), opening the file and its index each time.
+} BenchLookup;
+
+/* Heap accounting */
+
+typedef struct {
+    size_t current;
+    size_t peak;
+    uint64_t allocated;
+    uint64_t allocations;
+} BenchHeap;
+
+static BenchHeap bench_heap;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+
+static void bench_heap_add(void* ptr) {
+    if(!ptr) return;
+    const size_t size = malloc_usable_size(ptr);
+    bench_heap.current += size;
+    bench_heap.allocated += size;
+    bench_heap.allocations++;
+    if(bench_heap.current > bench_heap.peak) bench_heap.peak = bench_heap.current;
+}
+
+static void bench_heap_remove(void* ptr) {
+    if(!ptr) return;
+    bench_heap.current -= malloc_usable_size(ptr);
+}
+
+void* __wrap_malloc(size_t size) {
+    void* ptr = __real_malloc(size);
+    bench_heap_add(ptr);
+    return ptr;
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    void* ptr = __real_calloc(count, size);
+    bench_heap_add(ptr);
+    return ptr;
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    bench_heap_remove(ptr);
+    void* result = __real_realloc(ptr, size);
+    // A failed realloc leaves the original block in place.
+    bench_heap_add(result ? result : (size ? ptr : NULL));
+    return result;
+}
+
+void __wrap_free(void* ptr) {
+    bench_heap_remove(ptr);
+    __real_free(ptr);
+}
+
+/* Benchmarks */
+
+typedef struct {
+    const char* name;
+    const char* path;
+    size_t file_size;
+    InfraredSignal** signals;
+    FuriString** names;
+    size_t count;
+} BenchLibrary;
+
+typedef struct {
+    double seconds;
+    uint64_t signals;
+    uint64_t allocated;
+    uint64_t allocations;
+    size_t peak;
+} BenchResult;
+
+typedef struct {
+    uint64_t start_ns;
+    BenchHeap heap;
+} BenchRun;
+
+static uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void bench_begin(BenchRun* run) {
+    bench_heap.peak = bench_heap.current;
+    run->heap = bench_heap;
+    run->start_ns = bench_now_ns();
+}
+
+static void bench_end(const BenchRun* run, uint64_t signals, BenchResult* result) {
+    result->seconds = (bench_now_ns() - run->start_ns) / 1e9;
+    result->signals = signals;
+    result->allocated = bench_heap.allocated - run->heap.allocated;
+    result->allocations = bench_heap.allocations - run->heap.allocations;
+    result->peak = bench_heap.peak - run->heap.current;
+}
+
+static size_t bench_repetitions(const BenchLibrary* library) {
+    return MAX(1U, BENCH_MIN_SIGNALS / library->count);
+}
+
+static bool bench_read(
+    const BenchLibrary* library,
+    Storage* storage,
+    InfraredRawStorage raw_storage,
+    BenchResult* result) {
+    FlipperFormat* ff = flipper_format_buffered_file_alloc(storage);
+    InfraredSignal* signal = infrared_signal_alloc();
+    infrared_signal_set_raw_storage(signal, raw_storage);
+    FuriString* tmp = furi_string_alloc();
+    BenchRun run;
+    uint64_t signals = 0;
+    bool success = true;
+
+    bench_begin(&run);
+    for(size_t i = 0; i < bench_repetitions(library) && success; ++i) {
+        uint32_t version;
+        success = flipper_format_buffered_file_open_existing(ff, library->path) &&
+                  flipper_format_read_header(ff, tmp, &version);
+        while(success && infrared_signal_read(signal, ff, tmp)) {
+            signals++;
+        }
+        flipper_format_buffered_file_close(ff);
+    }
+    bench_end(&run, signals, result);
+
+    furi_string_free(tmp);
+    infrared_signal_free(signal);
+    flipper_format_free(ff);
+
+    return success && signals == bench_repetitions(library) * library->count;
+}
+
+static bool bench_save(const BenchLibrary* library, Storage* storage, BenchResult* result) {
+    FlipperFormat* ff = flipper_format_buffered_file_alloc(storage);
+    FuriString* path = furi_string_alloc_printf("%s.saved", library->path);
+    BenchRun run;
+    uint64_t signals = 0;
+    bool success = true;
+
+    bench_begin(&run);
+    for(size_t i = 0; i < bench_repetitions(library) && success; ++i) {
+        success = flipper_format_buffered_file_open_always(ff, furi_string_get_cstr(path)) &&
+                  flipper_format_write_header_cstr(ff, "IR signals file", 1);
+        for(size_t j = 0; j < library->count && success; ++j) {
+            success = infrared_signal_save(
+                library->signals[j], ff, furi_string_get_cstr(library->names[j]));
+            signals++;
+        }
+        flipper_format_buffered_file_close(ff);
+    }
+    bench_end(&run, signals, result);
+
+    storage_common_remove(storage, furi_string_get_cstr(path));
+    furi_string_free(path);
+    flipper_format_free(ff);
+
+    return success;
+}
+
+static bool
+    bench_save_batch(const BenchLibrary* library, Storage* storage, BenchResult* result) {
+    InfraredLibraryWriter* writer =
+        infrared_library_writer_alloc(storage, INFRARED_LIBRARY_WRITER_BUFFER_SIZE);
+    FuriString* path = furi_string_alloc_printf("%s.saved", library->path);
+    BenchRun run;
+    uint64_t signals = 0;
+    bool success = true;
+
+    bench_begin(&run);
+    for(size_t i = 0; i < bench_repetitions(library) && success; ++i) {
+        success = infrared_library_writer_begin(writer, furi_string_get_cstr(path));
+        for(size_t j = 0; j < library->count && success; ++j) {
+            success = infrared_library_writer_add(
+                writer, library->signals[j], furi_string_get_cstr(library->names[j]));
+            signals++;
+        }
+        success = success && infrared_library_writer_commit(writer);
+    }
+    bench_end(&run, signals, result);
+
+    storage_common_remove(storage, furi_string_get_cstr(path));
+    furi_string_free(path);
+    infrared_library_writer_free(writer);
+
+    return success;
+}
+
+static bool bench_lookup(
+    const BenchLibrary* library,
+    Storage* storage,
+    BenchLookup lookup,
+    BenchResult* result) {
+    FlipperFormat* ff = flipper_format_buffered_file_alloc(storage);
+    InfraredIndex* index = infrared_index_alloc();
+    InfraredSignal* signal = infrared_signal_alloc();
+    FuriString* tmp = furi_string_alloc();
+    const size_t lookup_count = MIN(library->count, BENCH_LOOKUPS);
+    BenchRun run;
+    uint64_t signals = 0;
+    bool success = true;
+
+    // Build the sidecar beforehand, so that every run measures lookups only.
+    success = infrared_index_open(index, storage, library->path);
+
+    bench_begin(&run);
+    if(lookup == BenchLookupIndex) {
+        uint32_t version;
+        success = success && flipper_format_buffered_file_open_existing(ff, library->path) &&
+                  flipper_format_read_header(ff, tmp, &version) &&
+                  infrared_index_open(index, storage, library->path);
+    }
+    for(size_t i = 0; i < lookup_count && success; ++i) {
+        const size_t j = i * library->count / lookup_count;
+        const char* name = furi_string_get_cstr(library->names[j]);
+
+        if(lookup == BenchLookupScan) {
+            uint32_t version;
+            success = flipper_format_buffered_file_open_existing(ff, library->path) &&
+                      flipper_format_read_header(ff, tmp, &version) &&
+                      infrared_signal_search_by_name_and_read(signal, ff, name);
+            flipper_format_buffered_file_close(ff);
+        } else if(lookup == BenchLookupIndex) {
+            success = infrared_signal_search_by_name_and_read_indexed(signal, ff, index, name);
+        } else {
+            success = infrared_signal_load_by_name(signal, storage, library->path, name);
+        }
+
+        success = success && infrared_signal_equals(signal, library->signals[j]);
+        signals++;
+    }
+    flipper_format_buffered_file_close(ff);
+    bench_end(&run, signals, result);
+
+    furi_string_free(tmp);
+    infrared_signal_free(signal);
+    infrared_index_free(index);
+    flipper_format_free(ff);
+
+    return success;
+}
+
+static bool bench_set_signal(const BenchLibrary* library, BenchResult* result) {
+    InfraredSignal* signal = infrared_signal_alloc();
+    BenchRun run;
+    uint64_t signals = 0;
+
+    bench_begin(&run);
+    for(size_t i = 0; i < bench_repetitions(library) * BENCH_MEMORY_FACTOR; ++i) {
+        for(size_t j = 0; j < library->count; ++j) {
+            infrared_signal_set_signal(signal, library->signals[j]);
+            signals++;
+        }
+    }
+    bench_end(&run, signals, result);
+
+    infrared_signal_free(signal);
+    return true;
+}
+
+static bool bench_is_valid(const BenchLibrary* library, BenchResult* result) {
+    BenchRun run;
+    uint64_t signals = 0;
+    bool success = true;
+
+    bench_begin(&run);
+    for(size_t i = 0; i < bench_repetitions(library) * BENCH_MEMORY_FACTOR; ++i) {
+        for(size_t j = 0; j < library->count; ++j) {
+            success &= infrared_signal_is_valid(library->signals[j]);
+            signals++;
+        }
+    }
+    bench_end(&run, signals, result);
+
+    return success;
+}
+
+/* Libraries */
+
+static uint32_t bench_random(uint32_t* state) {
+    *state = *state * 1664525UL + 1013904223UL;
+    return *state >> 8;
+}
+
+static bool bench_generate(Storage* storage, const char* path, size_t count) {
+    FlipperFormat* ff = flipper_format_buffered_file_alloc(storage);
+    InfraredSignal* signal = infrared_signal_alloc();
+    FuriString* name = furi_string_alloc();
+    uint32_t* timings = malloc(MAX_TIMINGS_AMOUNT * sizeof(uint32_t));
+    uint32_t state = count;
+    bool success = flipper_format_buffered_file_open_always(ff, path) &&
+                   flipper_format_write_header_cstr(ff, "IR signals file", 1);
+
+    for(size_t i = 0; i < count && success; ++i) {
+        if(i % BENCH_RAW_RATIO == BENCH_RAW_RATIO - 1) {
+            for(size_t j = 0; j < MAX_TIMINGS_AMOUNT; ++j) {
+                timings[j] = 300 + bench_random(&state) % 1700;
+            }
+            infrared_signal_set_raw_signal(signal, timings, MAX_TIMINGS_AMOUNT, 38000, 0.33f);
+        } else {
+            InfraredMessage message = {
+                .protocol = InfraredProtocolNECext,
+                .address = bench_random(&state) & 0xFFFF,
+                .command = bench_random(&state) & 0xFFFF,
+            };
+            infrared_signal_set_message(signal, &message);
+        }
+
+        furi_string_printf(name, "Signal_%05zu", i);
+        success = infrared_signal_save(signal, ff, furi_string_get_cstr(name));
+    }
+
+    flipper_format_buffered_file_close(ff);
+    flipper_format_free(ff);
+    infrared_signal_free(signal);
+    furi_string_free(name);
+    free(timings);
+
+    return success;
+}
+
+static bool bench_library_load(BenchLibrary* library, Storage* storage) {
+    FlipperFormat* ff = flipper_format_buffered_file_alloc(storage);
+    FuriString* tmp = furi_string_alloc();
+    size_t capacity = 0;
+    bool success = false;
+
+    library->signals = NULL;
+    library->names = NULL;
+    library->count = 0;
+
+    do {
+        FileInfo info;
+        uint32_t version;
+        if(storage_common_stat(storage, library->path, &info) != FSE_OK) break;
+        if(!flipper_format_buffered_file_open_existing(ff, library->path)) break;
+        if(!flipper_format_read_header(ff, tmp, &version)) break;
+        library->file_size = info.size;
+
+        for(;;) {
+            if(library->count == capacity) {
+                capacity = capacity ? capacity * 2 : 16;
+                library->signals = realloc(library->signals, capacity * sizeof(InfraredSignal*));
+                library->names = realloc(library->names, capacity * sizeof(FuriString*));
+            }
+
+            InfraredSignal* signal = infrared_signal_alloc();
+            FuriString* name = furi_string_alloc();
+            if(!infrared_signal_read(signal, ff, name)) {
+                infrared_signal_free(signal);
+                furi_string_free(name);
+                break;
+            }
+
+            library->signals[library->count] = signal;
+            library->names[library->count] = name;
+            library->count++;
+        }
+
+        success = library->count > 0;
+    } while(false);
+
+    flipper_format_buffered_file_close(ff);
+    flipper_format_free(ff);
+    furi_string_free(tmp);
+
+    return success;
+}
+
+static void bench_library_free(BenchLibrary* library) {
+    for(size_t i = 0; i < library->count; ++i) {
+        infrared_signal_free(library->signals[i]);
+        furi_string_free(library->names[i]);
+    }
+    free(library->signals);
+    free(library->names);
+}
+
+/* Reporting */
+
+static void bench_report(
+    FILE* json,
+    bool* is_first,
+    const BenchLibrary* library,
+    const char* benchmark,
+    const BenchResult* result) {
+    const double signals_per_second = result->seconds > 0 ? result->signals / result->seconds : 0;
+    const double bytes_per_signal = (double)result->allocated / result->signals;
+    const double allocations_per_signal = (double)result->allocations / result->signals;
+
+    printf(
+        "%-8s %6zu %-12s %14.0f %12.1f %10.2f %12zu\n",
+        library->name,
+        library->count,
+        benchmark,
+        signals_per_second,
+        bytes_per_signal,
+        allocations_per_signal,
+        result->peak);
+
+    fprintf(
+        json,
+        "%s\n    {\"library\": \"%s\", \"signals\": %zu, \"file_size\": %zu, "
+        "\"benchmark\": \"%s\", \"iterations\": %llu, \"seconds\": %.6f, "
+        "\"signals_per_second\": %.1f, \"bytes_allocated_per_signal\": %.2f, "
+        "\"allocations_per_signal\": %.3f, \"peak_heap_bytes\": %zu}",
+        *is_first ? "" : ",",
+        library->name,
+        library->count,
+        library->file_size,
+        benchmark,
+        (unsigned long long)result->signals,
+        result->seconds,
+        signals_per_second,
+        bytes_per_signal,
+        allocations_per_signal,
+        result->peak);
+
+    *is_first = false;
+}
+
+int main(int argc, char** argv) {
+    const char* results_path = argc > 1 ? argv[1] : BENCH_DEFAULT_RESULTS_PATH;
+    const size_t sizes[] = {100, 1000, 10000};
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    bool success = true;
+
+    storage_simply_mkdir(storage, BENCH_DIR);
+
+    FILE* json = fopen(results_path, "w");
+    if(!json) {
+        fprintf(stderr, "Cannot open %s\n", results_path);
+        return 1;
+    }
+
+    fprintf(json, "{\n  \"results\": [");
+    printf(
+        "%-8s %6s %-12s %14s %12s %10s %12s\n",
+        "library",
+        "count",
+        "benchmark",
+        "signals/s",
+        "bytes/signal",
+        "allocs/sig",
+        "peak heap");
+
+    bool is_first = true;
+    for(size_t i = 0; i <= COUNT_OF(sizes) && success; ++i) {
+        char name[16];
+        char path[64];
+        BenchLibrary library;
+
+        if(i == 0) {
+            library.name = "ac";
+            library.path = BENCH_AC_PATH;
+        } else {
+            snprintf(name, sizeof(name), "gen%zu", sizes[i - 1]);
+            snprintf(path, sizeof(path), "%s/%s.ir", BENCH_DIR, name);
+            library.name = name;
+            library.path = path;
+            if(!bench_generate(storage, path, sizes[i - 1])) {
+                fprintf(stderr, "Cannot generate %s\n", path);
+                success = false;
+                break;
+            }
+        }
+
+        if(!bench_library_load(&library, storage)) {
+            fprintf(stderr, "Cannot load %s\n", library.path);
+            success = false;
+            break;
+        }
+
+        BenchResult result;
+        if((success = bench_read(&library, storage, InfraredRawStorageFull, &result))) {
+            bench_report(json, &is_first, &library, "read", &result);
+        }
+        if(success &&
+           (success = bench_read(&library, storage, InfraredRawStorageVarint, &result))) {
+            bench_report(json, &is_first, &library, "read_varint", &result);
+        }
+        if(success &&
+           (success = bench_read(&library, storage, InfraredRawStorageDictionary, &result))) {
+            bench_report(json, &is_first, &library, "read_dict", &result);
+        }
+        if(success && (success = bench_save(&library, storage, &result))) {
+            bench_report(json, &is_first, &library, "save", &result);
+        }
+        if(success && (success = bench_save_batch(&library, storage, &result))) {
+            bench_report(json, &is_first, &library, "save_batch", &result);
+        }
+        // Lookups write a sidecar index next to the library: only do it for the generated ones.
+        const bool is_generated = i > 0;
+        if(success && is_generated &&
+           (success = bench_lookup(&library, storage, BenchLookupScan, &result))) {
+            bench_report(json, &is_first, &library, "lookup_scan", &result);
+        }
+        if(success && is_generated &&
+           (success = bench_lookup(&library, storage, BenchLookupIndex, &result))) {
+            bench_report(json, &is_first, &library, "lookup_index", &result);
+        }
+        if(success && is_generated &&
+           (success = bench_lookup(&library, storage, BenchLookupFile, &result))) {
+            bench_report(json, &is_first, &library, "lookup_file", &result);
+        }
+        if(success && (success = bench_set_signal(&library, &result))) {
+            bench_report(json, &is_first, &library, "set_signal", &result);
+        }
+        if(success && (success = bench_is_valid(&library, &result))) {
+            bench_report(json, &is_first, &library, "is_valid", &result);
+        }
+
+        bench_library_free(&library);
+    }
+
+    fprintf(json, "\n  ]\n}\n");
+    fclose(json);
+    furi_record_close(RECORD_STORAGE);
+
+    if(!success) {
+        fprintf(stderr, "Benchmark failed\n");
+        return 1;
+    }
+
+    printf("Results written to %s\n", results_path);
+    return 0;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define furi_crash(message)                                                         \
+    do {                                                                            \
+        fprintf(stderr, "furi_crash: %s (%s:%d)\n", (message), __FILE__, __LINE__); \
+        abort();                                                                    \
+    } while(0)
+
+#define furi_check(x)                                  \
+    do {                                               \
+        if(!(x)) furi_crash("furi_check failed: " #x); \
+    } while(0)
+
+#define furi_assert(x)                                  \
+    do {                                                \
+        if(!(x)) furi_crash("furi_assert failed: " #x); \
+    } while(0)
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stdint.h>
+
+/** Current tick count of the virtual clock (1 tick = 1 ms). */
+uint32_t furi_get_tick(void);
+uint32_t furi_kernel_get_tick_frequency(void);
+uint32_t furi_ms_to_ticks(uint32_t milliseconds);
+void furi_delay_tick(uint32_t ticks);
+void furi_delay_ms(uint32_t milliseconds);
+void furi_delay_us(uint32_t microseconds);
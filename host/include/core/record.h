@@ -0,0 +1,4 @@
+#pragma once
+
+void* furi_record_open(const char* name);
+void furi_record_close(const char* name);
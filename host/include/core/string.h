@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct FuriString FuriString;
+
+FuriString* furi_string_alloc(void);
+FuriString* furi_string_alloc_set_str(const char cstr_source[]);
+FuriString* furi_string_alloc_printf(const char format[], ...)
+    __attribute__((format(printf, 1, 2)));
+void furi_string_free(FuriString* string);
+void furi_string_reset(FuriString* string);
+const char* furi_string_get_cstr(const FuriString* string);
+size_t furi_string_size(const FuriString* string);
+bool furi_string_empty(const FuriString* string);
+char furi_string_get_char(const FuriString* string, size_t index);
+void furi_string_set(FuriString* string, const FuriString* source);
+void furi_string_set_str(FuriString* string, const char cstr[]);
+void furi_string_set_strn(FuriString* string, const char cstr[], size_t n);
+void furi_string_cat(FuriString* string, const FuriString* source);
+void furi_string_cat_str(FuriString* string, const char cstr[]);
+void furi_string_push_back(FuriString* string, char c);
+int furi_string_printf(FuriString* string, const char format[], ...)
+    __attribute__((format(printf, 2, 3)));
+int furi_string_cat_printf(FuriString* string, const char format[], ...)
+    __attribute__((format(printf, 2, 3)));
+int furi_string_vprintf(FuriString* string, const char format[], va_list args);
+bool furi_string_equal_str(const FuriString* string, const char cstr[]);
+bool furi_string_equal_string(const FuriString* string, const FuriString* other);
+int furi_string_cmp_str(const FuriString* string, const char cstr[]);
+bool furi_string_start_with_str(const FuriString* string, const char start[]);
+bool furi_string_end_with_str(const FuriString* string, const char end[]);
+void furi_string_left(FuriString* string, size_t index);
+void furi_string_right(FuriString* string, size_t index);
+void furi_string_trim(FuriString* string, const char chars[]);
+
+#define furi_string_equal(a, b)                                \
+    _Generic((b), char*                                        \
+             : furi_string_equal_str, const char*              \
+             : furi_string_equal_str, FuriString*              \
+             : furi_string_equal_string, const FuriString*     \
+             : furi_string_equal_string)(a, b)
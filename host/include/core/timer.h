@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+#include <core/common_defines.h>
+
+typedef void (*FuriTimerCallback)(void* context);
+typedef void (*FuriTimerPendigCallback)(void* context, uint32_t arg);
+
+typedef enum {
+    FuriTimerTypeOnce = 0,
+    FuriTimerTypePeriodic = 1,
+} FuriTimerType;
+
+typedef struct FuriTimer FuriTimer;
+
+FuriTimer* furi_timer_alloc(FuriTimerCallback func, FuriTimerType type, void* context);
+void furi_timer_free(FuriTimer* instance);
+FuriStatus furi_timer_start(FuriTimer* instance, uint32_t ticks);
+FuriStatus furi_timer_restart(FuriTimer* instance, uint32_t ticks);
+FuriStatus furi_timer_stop(FuriTimer* instance);
+uint32_t furi_timer_is_running(FuriTimer* instance);
+uint32_t furi_timer_get_expire_time(FuriTimer* instance);
+void furi_timer_pending_callback(FuriTimerPendigCallback callback, void* context, uint32_t arg);
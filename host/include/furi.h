@@ -0,0 +1,30 @@
+/**
+ * @file furi.h
+ * Host stand-in for the Furi core API.
+ *
+ * Only the subset of the firmware API used by this application is provided.
+ * Timers, queues, mutexes, thread flags and delays run on a virtual clock
+ * (see sim/sim.h), so a simulated day takes milliseconds of host time.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <core/common_defines.h>
+#include <core/check.h>
+#include <core/log.h>
+#include <core/string.h>
+#include <core/kernel.h>
+#include <core/thread.h>
+#include <core/timer.h>
+#include <core/message_queue.h>
+#include <core/mutex.h>
+#include <core/record.h>
+
+/* The firmware libc provides strlcpy(), glibc only does since 2.38. */
+size_t strlcpy(char* dst, const char* src, size_t size);
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Cycle counter based timer, as in the firmware. start is the cycle count when it was taken. */
+typedef struct {
+    uint32_t start;
+    uint32_t value;
+} FuriHalCortexTimer;
+
+/** Core clock in cycles per microsecond. */
+uint32_t furi_hal_cortex_instructions_per_microsecond(void);
+
+/** Start a timer expiring after timeout_us. The cycle counter follows the virtual clock. */
+FuriHalCortexTimer furi_hal_cortex_timer_get(uint32_t timeout_us);
+
+bool furi_hal_cortex_timer_is_expired(FuriHalCortexTimer cortex_timer);
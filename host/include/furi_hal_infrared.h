@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    FuriHalInfraredTxGetDataStateOk,
+    FuriHalInfraredTxGetDataStateDone,
+    FuriHalInfraredTxGetDataStateLastDone,
+} FuriHalInfraredTxGetDataState;
+
+typedef FuriHalInfraredTxGetDataState (
+    *FuriHalInfraredTxGetDataISRCallback)(void* context, uint32_t* duration, bool* level);
+
+bool furi_hal_infrared_is_busy(void);
+void furi_hal_infrared_async_tx_set_data_isr_callback(
+    FuriHalInfraredTxGetDataISRCallback callback,
+    void* context);
+void furi_hal_infrared_async_tx_start(uint32_t freq, float duty_cycle);
+void furi_hal_infrared_async_tx_wait_termination(void);
+void furi_hal_infrared_async_tx_stop(void);
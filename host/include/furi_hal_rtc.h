@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+/** Seconds since the Unix epoch, in the device's local time. Follows the virtual clock. */
+uint32_t furi_hal_rtc_get_timestamp(void);
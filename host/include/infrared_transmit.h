@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <infrared/encoder_decoder/infrared.h>
+
+void infrared_send_raw(const uint32_t timings[], uint32_t timings_cnt, bool start_from_mark);
+void infrared_send_raw_ext(
+    const uint32_t timings[],
+    uint32_t timings_cnt,
+    bool start_from_mark,
+    uint32_t frequency,
+    float duty_cycle);
+void infrared_send(const InfraredMessage* message, int times);
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct Stream Stream;
+
+typedef enum {
+    StreamOffsetFromCurrent,
+    StreamOffsetFromStart,
+    StreamOffsetFromEnd,
+} StreamOffset;
+
+bool stream_eof(Stream* stream);
+void stream_clean(Stream* stream);
+bool stream_seek(Stream* stream, int32_t offset, StreamOffset offset_type);
+size_t stream_tell(Stream* stream);
+size_t stream_size(Stream* stream);
+size_t stream_write(Stream* stream, const uint8_t* data, size_t size);
+size_t stream_read(Stream* stream, uint8_t* data, size_t count);
+bool stream_rewind(Stream* stream);
@@ -0,0 +1,268 @@
+/*
+ * Runs ac_app on the virtual clock and prints every transmission and timer
+ * expiry, followed by a summary.
+ *
+ * Usage: ac_app_sim [-e] [-l loss] [-c capture] [hours] [start]
+ *
+ * The RTC starts at 2026-01-01 00:00 plus start minutes, so that a second run
+ * can pick up the state journal left by a first one some time later.
+ *
+ * -l has a repeater echo every frame sent back to the infrared receiver once it
+ * has ended, losing the given percentage of them, and -c has the receiver hear the signals of a signal
+ * file, one per receive session, before any echo.
+ *
+ * -e checks the run against the built-in schedule started afresh, without a
+ * schedule, units or journal file: the frames sent in every cycle, and one timer
+ * expiry per minute plus one per delay between the presses of an action. The
+ * exit status is 1 if either does not match.
+ */
+#include <furi.h>
+#include <flipper_format/flipper_format.h>
+#include <sim/sim.h>
+#include <storage/storage.h>
+
+#include <getopt.h>
+
+#include "infrared_signal.h"
+
+int32_t ac_app_app(void* p);
+
+// Built-in schedule: on for 1 hour, then off for 3 hours, through the Power button of Ac.ir.
+#define SIM_CYCLE_MINUTES (4U * 60U)
+#define SIM_ADDRESS (0x6F98U)
+#define SIM_COMMAND_POWER (0xE619U)
+#define SIM_COMMAND_MODE (0xF708U)
+
+// The countdown timer ticks once a minute.
+#define SIM_TIMER_FIRES_PER_HOUR (60U)
+
+#define SIM_MAX_FRAMES (1024U)
+
+typedef struct {
+    uint32_t minute; /**< Minute of the cycle the frame is sent in. */
+    uint32_t command;
+} SimExpectedFrame;
+
+// The unit powers on in its first mode, so every turn-on steps it to the third one.
+static const SimExpectedFrame sim_cycle[] = {
+    {0, SIM_COMMAND_POWER},
+    {0, SIM_COMMAND_MODE},
+    {0, SIM_COMMAND_MODE},
+    {60, SIM_COMMAND_POWER},
+};
+
+typedef struct {
+    size_t transmissions;
+    size_t timer_fires;
+    uint64_t max_timer_latency_us;
+    uint64_t total_timer_latency_us;
+    size_t renders;
+    SimTransmission frames[SIM_MAX_FRAMES]; /**< First transmissions, for -e. */
+} SimReport;
+
+static void print_time(uint64_t time_us) {
+    uint64_t seconds = time_us / SIM_US_PER_S;
+    printf(
+        "%3llu:%02llu:%02llu.%03llu",
+        (unsigned long long)(seconds / 3600),
+        (unsigned long long)(seconds / 60 % 60),
+        (unsigned long long)(seconds % 60),
+        (unsigned long long)(time_us / SIM_US_PER_MS % 1000));
+}
+
+static void on_transmission(const SimTransmission* transmission, void* context) {
+    SimReport* report = context;
+    if(report->transmissions < SIM_MAX_FRAMES) {
+        report->frames[report->transmissions] = *transmission;
+    }
+    report->transmissions++;
+
+    print_time(transmission->time_us);
+    if(transmission->message.protocol != InfraredProtocolUnknown) {
+        printf(
+            " tx %s%s address=0x%04lX command=0x%04lX air=%llums\n",
+            infrared_get_protocol_name(transmission->message.protocol),
+            transmission->is_raw ? " (raw)" : "",
+            (unsigned long)transmission->message.address,
+            (unsigned long)transmission->message.command,
+            (unsigned long long)(transmission->duration_us / SIM_US_PER_MS));
+    } else {
+        printf(
+            " tx raw timings=%zu air=%llums\n",
+            transmission->timings_size,
+            (unsigned long long)(transmission->duration_us / SIM_US_PER_MS));
+    }
+}
+
+static void on_timer_fire(const SimTimerFire* fire, void* context) {
+    SimReport* report = context;
+    uint64_t latency_us = fire->fire_us - fire->deadline_us;
+    report->timer_fires++;
+    report->total_timer_latency_us += latency_us;
+    if(latency_us > report->max_timer_latency_us) report->max_timer_latency_us = latency_us;
+    if(latency_us > 0) {
+        print_time(fire->fire_us);
+        printf(" timer late by %llu us\n", (unsigned long long)latency_us);
+    }
+}
+
+static void on_render(const char* const* lines, size_t line_count, void* context) {
+    SimReport* report = context;
+    report->renders++;
+    UNUSED(lines);
+    UNUSED(line_count);
+}
+
+// Queue every signal of a signal file for the infrared receiver.
+static bool load_capture(const char* path) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    FlipperFormat* ff = flipper_format_buffered_file_alloc(storage);
+    InfraredSignal* signal = infrared_signal_alloc();
+    FuriString* tmp = furi_string_alloc();
+    size_t count = 0;
+    bool success = false;
+
+    do {
+        uint32_t version;
+        if(!flipper_format_buffered_file_open_existing(ff, path)) break;
+        if(!flipper_format_read_header(ff, tmp, &version)) break;
+
+        while(infrared_signal_read(signal, ff, tmp)) {
+            if(infrared_signal_is_raw(signal)) {
+                const InfraredRawSignal* raw = infrared_signal_get_raw_signal(signal);
+                sim_rx_inject_raw(raw->timings, raw->timings_size);
+            } else {
+                sim_rx_inject_message(infrared_signal_get_message(signal));
+            }
+            ++count;
+        }
+
+        success = count > 0;
+    } while(false);
+
+    furi_string_free(tmp);
+    infrared_signal_free(signal);
+    flipper_format_buffered_file_close(ff);
+    flipper_format_free(ff);
+    furi_record_close(RECORD_STORAGE);
+
+    return success;
+}
+
+// Compare the frames and timer expiries of a run with those of the built-in schedule.
+static bool check_report(const SimReport* report, uint64_t hours) {
+    const uint64_t minutes = hours * 60;
+    size_t index = 0;
+    size_t press_delays = 0;
+    bool success = true;
+
+    for(uint64_t cycle = 0; cycle * SIM_CYCLE_MINUTES < minutes; ++cycle) {
+        const SimExpectedFrame* expected = sim_cycle;
+
+        for(size_t i = 0; i < COUNT_OF(sim_cycle); ++i) {
+            const uint64_t minute = cycle * SIM_CYCLE_MINUTES + expected[i].minute;
+            if(minute >= minutes) break;
+
+            // Presses of one action are sent in the same minute, a timer apart.
+            if(i > 0 && expected[i].minute == expected[i - 1].minute) ++press_delays;
+
+            if(index >= MIN(report->transmissions, SIM_MAX_FRAMES)) {
+                fprintf(
+                    stderr,
+                    "check: frame %zu missing, due at minute %llu\n",
+                    index,
+                    (unsigned long long)minute);
+                return false;
+            }
+
+            const SimTransmission* frame = &report->frames[index++];
+            if(frame->time_us / (60 * SIM_US_PER_S) != minute ||
+               frame->message.protocol == InfraredProtocolUnknown ||
+               frame->message.address != SIM_ADDRESS ||
+               frame->message.command != expected[i].command) {
+                fprintf(
+                    stderr,
+                    "check: frame %zu is command 0x%04lX at minute %llu, "
+                    "expected 0x%04lX at minute %llu\n",
+                    index - 1,
+                    (unsigned long)frame->message.command,
+                    (unsigned long long)(frame->time_us / (60 * SIM_US_PER_S)),
+                    (unsigned long)expected[i].command,
+                    (unsigned long long)minute);
+                success = false;
+            }
+        }
+    }
+
+    if(report->transmissions != index) {
+        fprintf(stderr, "check: %zu frames, expected %zu\n", report->transmissions, index);
+        success = false;
+    }
+
+    const uint64_t timer_fires = hours * SIM_TIMER_FIRES_PER_HOUR + press_delays;
+    if(report->timer_fires != timer_fires) {
+        fprintf(
+            stderr,
+            "check: %zu timer expiries, expected %llu\n",
+            report->timer_fires,
+            (unsigned long long)timer_fires);
+        success = false;
+    }
+
+    return success;
+}
+
+int main(int argc, char** argv) {
+    bool is_checked = false;
+
+    for(int option; (option = getopt(argc, argv, "el:c:")) != -1;) {
+        switch(option) {
+        case 'e':
+            is_checked = true;
+            break;
+        case 'l':
+            sim_rx_set_loopback(true, strtoul(optarg, NULL, 10));
+            break;
+        case 'c':
+            if(!load_capture(optarg)) {
+                fprintf(stderr, "Cannot read the signals in %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-e] [-l loss] [-c capture] [hours] [start]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    uint64_t hours = optind < argc ? strtoull(argv[optind], NULL, 10) : 24;
+    uint64_t start_minutes = optind + 1 < argc ? strtoull(argv[optind + 1], NULL, 10) : 0;
+    sim_set_rtc_base(SIM_RTC_BASE + start_minutes * 60);
+
+    static SimReport report;
+    sim_set_transmission_callback(on_transmission, &report);
+    sim_set_timer_fire_callback(on_timer_fire, &report);
+    sim_set_render_callback(on_render, &report);
+
+    FuriThread* app = furi_thread_alloc_ex("AcApp", 2048, ac_app_app, NULL);
+    furi_thread_start(app);
+
+    sim_sleep_us(hours * SIM_US_PER_HOUR);
+    sim_send_input(InputKeyBack, InputTypeShort);
+
+    furi_thread_join(app);
+    furi_thread_free(app);
+
+    printf(
+        "simulated %llu h: %zu frames, %zu timer expiries (max latency %llu us, mean %llu us), %zu redraws\n",
+        (unsigned long long)hours,
+        report.transmissions,
+        report.timer_fires,
+        (unsigned long long)report.max_timer_latency_us,
+        (unsigned long long)(report.timer_fires ? report.total_timer_latency_us / report.timer_fires : 0),
+        report.renders);
+
+    if(is_checked && !check_report(&report, hours)) return 1;
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file sim.h
+ * @brief Control interface of the host simulation harness.
+ *
+ * Every Furi primitive in the host build runs on a single virtual clock.
+ * Time only moves forward when every simulated thread is blocked, and it then
+ * jumps straight to the earliest pending deadline, so schedules spanning days
+ * run in milliseconds while preserving the order in which things would
+ * happen on the device.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <infrared/encoder_decoder/infrared.h>
+#include <input/input.h>
+
+#define SIM_US_PER_MS (1000ULL)
+#define SIM_US_PER_S (1000000ULL)
+#define SIM_US_PER_HOUR (3600ULL * SIM_US_PER_S)
+
+/**
+ * One frame recorded by the infrared stand-ins.
+ *
+ * Raw transmissions are split into frames at long spaces and every frame is
+ * run through the decoder, so a protocol frame is recognised whichever path
+ * sent it.
+ */
+typedef struct {
+    uint64_t time_us; /**< Virtual time at which the frame started. */
+    uint64_t duration_us; /**< Air time of the frame, trailing space included. */
+    bool is_raw; /**< True if sent through the raw (timings) path. */
+    InfraredMessage message; /**< Decoded message, protocol is Unknown if not decodable. */
+    size_t timings_size; /**< Number of timings in the frame. */
+    uint32_t frequency; /**< Carrier frequency of the frame. */
+} SimTransmission;
+
+/** One software timer expiry observed by the timer service stand-in. */
+typedef struct {
+    uint64_t deadline_us; /**< Virtual time the timer was due. */
+    uint64_t fire_us; /**< Virtual time its callback actually started. */
+    uint64_t duration_us; /**< Virtual time spent inside the callback. */
+} SimTimerFire;
+
+typedef void (*SimTransmissionCallback)(const SimTransmission* transmission, void* context);
+typedef void (*SimTimerFireCallback)(const SimTimerFire* fire, void* context);
+typedef void (*SimRenderCallback)(const char* const* lines, size_t line_count, void* context);
+
+/** Current virtual time, in microseconds since the start of the simulation. */
+uint64_t sim_get_time_us(void);
+
+/** Block the calling simulated thread for the given amount of virtual time. */
+void sim_sleep_us(uint64_t duration_us);
+
+/** Wall-clock time reported by the RTC at virtual time zero by default: 2026-01-01 00:00:00. */
+#define SIM_RTC_BASE (1767225600UL)
+
+/** Set the wall-clock time (Unix seconds) reported by the RTC at virtual time zero. */
+void sim_set_rtc_base(uint32_t timestamp);
+
+/** Observe every infrared transmission. */
+void sim_set_transmission_callback(SimTransmissionCallback callback, void* context);
+
+/** Observe every software timer expiry. */
+void sim_set_timer_fire_callback(SimTimerFireCallback callback, void* context);
+
+/** Observe every frame drawn by a view port; lines are the strings drawn, in order. */
+void sim_set_render_callback(SimRenderCallback callback, void* context);
+
+/**
+ * Echo every frame transmitted, repeats excepted, back to the infrared receiver,
+ * dropping loss_percent of them at random (the same ones on every run).
+ *
+ * Echoes model a repeater: each one starts 60 ms after the last mark of its
+ * frame, and is only heard by a receive session already started by then.
+ */
+void sim_rx_set_loopback(bool enable, uint32_t loss_percent);
+
+/**
+ * Queue a capture for the infrared receiver. Each receive session hears one
+ * signal: the next capture queued if there is one, shortly after it starts,
+ * otherwise the echo of the last frame transmitted, if it has not started yet.
+ */
+void sim_rx_inject_raw(const uint32_t* timings, size_t timings_size);
+
+/** Queue a capture of one frame of the given message for the infrared receiver. */
+void sim_rx_inject_message(const InfraredMessage* message);
+
+/** Deliver an input event to the most recently added view port. */
+void sim_send_input(InputKey key, InputType type);
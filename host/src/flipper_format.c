@@ -0,0 +1,376 @@
+#include <furi.h>
+#include <flipper_format/flipper_format.h>
+
+#include <ctype.h>
+
+#include "stream_i.h"
+
+#define FLIPPER_FORMAT_FILETYPE_KEY "Filetype"
+#define FLIPPER_FORMAT_VERSION_KEY "Version"
+
+struct FlipperFormat {
+    Stream* stream;
+    bool strict_mode;
+};
+
+FlipperFormat* flipper_format_string_alloc(void) {
+    FlipperFormat* flipper_format = calloc(1, sizeof(FlipperFormat));
+    flipper_format->stream = stream_string_alloc();
+    return flipper_format;
+}
+
+FlipperFormat* flipper_format_file_alloc(Storage* storage) {
+    FlipperFormat* flipper_format = calloc(1, sizeof(FlipperFormat));
+    flipper_format->stream = stream_file_alloc(storage);
+    return flipper_format;
+}
+
+FlipperFormat* flipper_format_buffered_file_alloc(Storage* storage) {
+    return flipper_format_file_alloc(storage);
+}
+
+static bool flipper_format_open(FlipperFormat* flipper_format, const char* path, FS_OpenMode mode) {
+    File* file = stream_get_file(flipper_format->stream);
+    furi_check(file);
+    return storage_file_open(file, path, FSAM_READ_WRITE, mode);
+}
+
+bool flipper_format_file_open_existing(FlipperFormat* flipper_format, const char* path) {
+    return flipper_format_open(flipper_format, path, FSOM_OPEN_EXISTING);
+}
+
+bool flipper_format_file_open_always(FlipperFormat* flipper_format, const char* path) {
+    return flipper_format_open(flipper_format, path, FSOM_CREATE_ALWAYS);
+}
+
+bool flipper_format_file_open_new(FlipperFormat* flipper_format, const char* path) {
+    return flipper_format_open(flipper_format, path, FSOM_CREATE_NEW);
+}
+
+bool flipper_format_file_open_append(FlipperFormat* flipper_format, const char* path) {
+    return flipper_format_open(flipper_format, path, FSOM_OPEN_APPEND);
+}
+
+bool flipper_format_buffered_file_open_existing(FlipperFormat* flipper_format, const char* path) {
+    return flipper_format_file_open_existing(flipper_format, path);
+}
+
+bool flipper_format_buffered_file_open_always(FlipperFormat* flipper_format, const char* path) {
+    return flipper_format_file_open_always(flipper_format, path);
+}
+
+bool flipper_format_file_close(FlipperFormat* flipper_format) {
+    File* file = stream_get_file(flipper_format->stream);
+    return file && storage_file_close(file);
+}
+
+bool flipper_format_buffered_file_close(FlipperFormat* flipper_format) {
+    return flipper_format_file_close(flipper_format);
+}
+
+void flipper_format_free(FlipperFormat* flipper_format) {
+    stream_free(flipper_format->stream);
+    free(flipper_format);
+}
+
+void flipper_format_set_strict_mode(FlipperFormat* flipper_format, bool strict_mode) {
+    flipper_format->strict_mode = strict_mode;
+}
+
+Stream* flipper_format_get_raw_stream(FlipperFormat* flipper_format) {
+    return flipper_format->stream;
+}
+
+bool flipper_format_rewind(FlipperFormat* flipper_format) {
+    return stream_rewind(flipper_format->stream);
+}
+
+bool flipper_format_seek_to_end(FlipperFormat* flipper_format) {
+    return stream_seek(flipper_format->stream, 0, StreamOffsetFromEnd);
+}
+
+/* Read one line without its terminator. Returns false at end of stream. */
+static bool flipper_format_read_line(Stream* stream, FuriString* line) {
+    furi_string_reset(line);
+    uint8_t c;
+    bool any = false;
+    while(stream_read(stream, &c, 1) == 1) {
+        any = true;
+        if(c == '\n') break;
+        if(c != '\r') furi_string_push_back(line, (char)c);
+    }
+    return any;
+}
+
+/* Position the stream at the value of the next line holding the given key. */
+static bool flipper_format_seek_to_key(FlipperFormat* flipper_format, const char* key) {
+    Stream* stream = flipper_format->stream;
+    FuriString* line = furi_string_alloc();
+    size_t key_length = strlen(key);
+    bool found = false;
+
+    for(;;) {
+        size_t line_start = stream_tell(stream);
+        if(!flipper_format_read_line(stream, line)) break;
+
+        const char* text = furi_string_get_cstr(line);
+        if(text[0] == '#' || text[0] == '\0') continue;
+
+        const char* colon = strchr(text, ':');
+        if(colon && (size_t)(colon - text) == key_length && strncmp(text, key, key_length) == 0) {
+            size_t value_offset = key_length + 1;
+            if(text[value_offset] == ' ') value_offset++;
+            stream_seek(stream, (int32_t)(line_start + value_offset), StreamOffsetFromStart);
+            found = true;
+            break;
+        }
+
+        if(flipper_format->strict_mode) break;
+    }
+
+    furi_string_free(line);
+    return found;
+}
+
+static bool flipper_format_read_value_line(
+    FlipperFormat* flipper_format,
+    const char* key,
+    FuriString* value) {
+    if(!flipper_format_seek_to_key(flipper_format, key)) return false;
+    flipper_format_read_line(flipper_format->stream, value);
+    return true;
+}
+
+bool flipper_format_key_exist(FlipperFormat* flipper_format, const char* key) {
+    size_t position = stream_tell(flipper_format->stream);
+    stream_rewind(flipper_format->stream);
+    bool result = flipper_format_seek_to_key(flipper_format, key);
+    stream_seek(flipper_format->stream, (int32_t)position, StreamOffsetFromStart);
+    return result;
+}
+
+bool flipper_format_read_string(FlipperFormat* flipper_format, const char* key, FuriString* data) {
+    return flipper_format_read_value_line(flipper_format, key, data);
+}
+
+static bool flipper_format_write_key_value(
+    FlipperFormat* flipper_format,
+    const char* key,
+    const char* value) {
+    Stream* stream = flipper_format->stream;
+    size_t key_length = strlen(key);
+    size_t value_length = strlen(value);
+    return stream_write(stream, (const uint8_t*)key, key_length) == key_length &&
+           stream_write(stream, (const uint8_t*)": ", 2) == 2 &&
+           stream_write(stream, (const uint8_t*)value, value_length) == value_length &&
+           stream_write(stream, (const uint8_t*)"\n", 1) == 1;
+}
+
+bool flipper_format_write_string(FlipperFormat* flipper_format, const char* key, FuriString* data) {
+    return flipper_format_write_key_value(flipper_format, key, furi_string_get_cstr(data));
+}
+
+bool flipper_format_write_string_cstr(
+    FlipperFormat* flipper_format,
+    const char* key,
+    const char* data) {
+    return flipper_format_write_key_value(flipper_format, key, data);
+}
+
+bool flipper_format_read_header(FlipperFormat* flipper_format, FuriString* filetype, uint32_t* version) {
+    return flipper_format_read_string(flipper_format, FLIPPER_FORMAT_FILETYPE_KEY, filetype) &&
+           flipper_format_read_uint32(flipper_format, FLIPPER_FORMAT_VERSION_KEY, version, 1);
+}
+
+bool flipper_format_write_header(
+    FlipperFormat* flipper_format,
+    FuriString* filetype,
+    const uint32_t version) {
+    return flipper_format_write_header_cstr(
+        flipper_format, furi_string_get_cstr(filetype), version);
+}
+
+bool flipper_format_write_header_cstr(
+    FlipperFormat* flipper_format,
+    const char* filetype,
+    const uint32_t version) {
+    return flipper_format_write_string_cstr(
+               flipper_format, FLIPPER_FORMAT_FILETYPE_KEY, filetype) &&
+           flipper_format_write_uint32(flipper_format, FLIPPER_FORMAT_VERSION_KEY, &version, 1);
+}
+
+static size_t flipper_format_count_tokens(const char* text) {
+    size_t count = 0;
+    bool in_token = false;
+    for(; *text; ++text) {
+        if(isspace((unsigned char)*text)) {
+            in_token = false;
+        } else if(!in_token) {
+            in_token = true;
+            count++;
+        }
+    }
+    return count;
+}
+
+bool flipper_format_get_value_count(FlipperFormat* flipper_format, const char* key, uint32_t* count) {
+    size_t position = stream_tell(flipper_format->stream);
+    FuriString* value = furi_string_alloc();
+
+    bool result = flipper_format_read_value_line(flipper_format, key, value);
+    if(result) *count = (uint32_t)flipper_format_count_tokens(furi_string_get_cstr(value));
+
+    furi_string_free(value);
+    stream_seek(flipper_format->stream, (int32_t)position, StreamOffsetFromStart);
+    return result;
+}
+
+typedef bool (*FlipperFormatTokenParser)(const char* token, void* data, size_t index);
+
+static bool flipper_format_read_tokens(
+    FlipperFormat* flipper_format,
+    const char* key,
+    void* data,
+    uint16_t data_size,
+    FlipperFormatTokenParser parser) {
+    FuriString* value = furi_string_alloc();
+    bool result = flipper_format_read_value_line(flipper_format, key, value);
+
+    if(result) {
+        char* text = (char*)furi_string_get_cstr(value);
+        char* save = NULL;
+        size_t index = 0;
+        for(char* token = strtok_r(text, " \t", &save); token && index < data_size;
+            token = strtok_r(NULL, " \t", &save)) {
+            if(!parser(token, data, index++)) {
+                result = false;
+                break;
+            }
+        }
+        if(index < data_size) result = false;
+    }
+
+    furi_string_free(value);
+    return result;
+}
+
+static bool flipper_format_parse_uint32(const char* token, void* data, size_t index) {
+    char* end;
+    unsigned long value = strtoul(token, &end, 10);
+    ((uint32_t*)data)[index] = (uint32_t)value;
+    return *end == '\0';
+}
+
+static bool flipper_format_parse_float(const char* token, void* data, size_t index) {
+    char* end;
+    ((float*)data)[index] = strtof(token, &end);
+    return *end == '\0';
+}
+
+static bool flipper_format_parse_bool(const char* token, void* data, size_t index) {
+    if(strcmp(token, "true") == 0) {
+        ((bool*)data)[index] = true;
+    } else if(strcmp(token, "false") == 0) {
+        ((bool*)data)[index] = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool flipper_format_parse_hex(const char* token, void* data, size_t index) {
+    char* end;
+    unsigned long value = strtoul(token, &end, 16);
+    ((uint8_t*)data)[index] = (uint8_t)value;
+    return *end == '\0' && strlen(token) == 2;
+}
+
+bool flipper_format_read_uint32(
+    FlipperFormat* flipper_format,
+    const char* key,
+    uint32_t* data,
+    const uint16_t data_size) {
+    return flipper_format_read_tokens(
+        flipper_format, key, data, data_size, flipper_format_parse_uint32);
+}
+
+bool flipper_format_read_float(
+    FlipperFormat* flipper_format,
+    const char* key,
+    float* data,
+    const uint16_t data_size) {
+    return flipper_format_read_tokens(
+        flipper_format, key, data, data_size, flipper_format_parse_float);
+}
+
+bool flipper_format_read_bool(
+    FlipperFormat* flipper_format,
+    const char* key,
+    bool* data,
+    const uint16_t data_size) {
+    return flipper_format_read_tokens(
+        flipper_format, key, data, data_size, flipper_format_parse_bool);
+}
+
+bool flipper_format_read_hex(
+    FlipperFormat* flipper_format,
+    const char* key,
+    uint8_t* data,
+    const uint16_t data_size) {
+    return flipper_format_read_tokens(
+        flipper_format, key, data, data_size, flipper_format_parse_hex);
+}
+
+bool flipper_format_write_uint32(
+    FlipperFormat* flipper_format,
+    const char* key,
+    const uint32_t* data,
+    const uint16_t data_size) {
+    FuriString* value = furi_string_alloc();
+    for(uint16_t i = 0; i < data_size; ++i) {
+        furi_string_cat_printf(value, i ? " %lu" : "%lu", (unsigned long)data[i]);
+    }
+    bool result = flipper_format_write_string(flipper_format, key, value);
+    furi_string_free(value);
+    return result;
+}
+
+bool flipper_format_write_float(
+    FlipperFormat* flipper_format,
+    const char* key,
+    const float* data,
+    const uint16_t data_size) {
+    FuriString* value = furi_string_alloc();
+    for(uint16_t i = 0; i < data_size; ++i) {
+        furi_string_cat_printf(value, i ? " %f" : "%f", (double)data[i]);
+    }
+    bool result = flipper_format_write_string(flipper_format, key, value);
+    furi_string_free(value);
+    return result;
+}
+
+bool flipper_format_write_hex(
+    FlipperFormat* flipper_format,
+    const char* key,
+    const uint8_t* data,
+    const uint16_t data_size) {
+    FuriString* value = furi_string_alloc();
+    for(uint16_t i = 0; i < data_size; ++i) {
+        furi_string_cat_printf(value, i ? " %02X" : "%02X", data[i]);
+    }
+    bool result = flipper_format_write_string(flipper_format, key, value);
+    furi_string_free(value);
+    return result;
+}
+
+bool flipper_format_write_comment(FlipperFormat* flipper_format, FuriString* data) {
+    return flipper_format_write_comment_cstr(flipper_format, furi_string_get_cstr(data));
+}
+
+bool flipper_format_write_comment_cstr(FlipperFormat* flipper_format, const char* data) {
+    Stream* stream = flipper_format->stream;
+    size_t length = strlen(data);
+    return stream_write(stream, (const uint8_t*)"# ", 2) == 2 &&
+           stream_write(stream, (const uint8_t*)data, length) == length &&
+           stream_write(stream, (const uint8_t*)"\n", 1) == 1;
+}
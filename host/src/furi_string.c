@@ -0,0 +1,188 @@
+#include <furi.h>
+
+#include <ctype.h>
+#include <stdarg.h>
+
+struct FuriString {
+    char* data;
+    size_t size;
+    size_t capacity;
+};
+
+static void furi_string_reserve(FuriString* string, size_t size) {
+    if(size + 1 <= string->capacity) return;
+    size_t capacity = string->capacity ? string->capacity : 16;
+    while(capacity < size + 1) capacity *= 2;
+    string->data = realloc(string->data, capacity);
+    string->capacity = capacity;
+}
+
+FuriString* furi_string_alloc(void) {
+    FuriString* string = calloc(1, sizeof(FuriString));
+    furi_string_reserve(string, 0);
+    string->data[0] = '\0';
+    return string;
+}
+
+FuriString* furi_string_alloc_set_str(const char cstr_source[]) {
+    FuriString* string = furi_string_alloc();
+    furi_string_set_str(string, cstr_source);
+    return string;
+}
+
+FuriString* furi_string_alloc_printf(const char format[], ...) {
+    FuriString* string = furi_string_alloc();
+    va_list args;
+    va_start(args, format);
+    furi_string_vprintf(string, format, args);
+    va_end(args);
+    return string;
+}
+
+void furi_string_free(FuriString* string) {
+    free(string->data);
+    free(string);
+}
+
+void furi_string_reset(FuriString* string) {
+    string->size = 0;
+    string->data[0] = '\0';
+}
+
+const char* furi_string_get_cstr(const FuriString* string) {
+    return string->data;
+}
+
+size_t furi_string_size(const FuriString* string) {
+    return string->size;
+}
+
+bool furi_string_empty(const FuriString* string) {
+    return string->size == 0;
+}
+
+char furi_string_get_char(const FuriString* string, size_t index) {
+    furi_check(index < string->size);
+    return string->data[index];
+}
+
+void furi_string_set_strn(FuriString* string, const char cstr[], size_t n) {
+    furi_string_reserve(string, n);
+    memmove(string->data, cstr, n);
+    string->data[n] = '\0';
+    string->size = n;
+}
+
+void furi_string_set_str(FuriString* string, const char cstr[]) {
+    furi_string_set_strn(string, cstr, strlen(cstr));
+}
+
+void furi_string_set(FuriString* string, const FuriString* source) {
+    furi_string_set_strn(string, source->data, source->size);
+}
+
+void furi_string_cat_str(FuriString* string, const char cstr[]) {
+    size_t length = strlen(cstr);
+    furi_string_reserve(string, string->size + length);
+    memcpy(string->data + string->size, cstr, length + 1);
+    string->size += length;
+}
+
+void furi_string_cat(FuriString* string, const FuriString* source) {
+    furi_string_cat_str(string, source->data);
+}
+
+void furi_string_push_back(FuriString* string, char c) {
+    furi_string_reserve(string, string->size + 1);
+    string->data[string->size++] = c;
+    string->data[string->size] = '\0';
+}
+
+static int furi_string_vcat_printf(FuriString* string, const char format[], va_list args) {
+    va_list copy;
+    va_copy(copy, args);
+    int length = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+    if(length < 0) return length;
+
+    furi_string_reserve(string, string->size + (size_t)length);
+    vsnprintf(string->data + string->size, (size_t)length + 1, format, args);
+    string->size += (size_t)length;
+    return length;
+}
+
+int furi_string_vprintf(FuriString* string, const char format[], va_list args) {
+    furi_string_reset(string);
+    return furi_string_vcat_printf(string, format, args);
+}
+
+int furi_string_printf(FuriString* string, const char format[], ...) {
+    va_list args;
+    va_start(args, format);
+    int result = furi_string_vprintf(string, format, args);
+    va_end(args);
+    return result;
+}
+
+int furi_string_cat_printf(FuriString* string, const char format[], ...) {
+    va_list args;
+    va_start(args, format);
+    int result = furi_string_vcat_printf(string, format, args);
+    va_end(args);
+    return result;
+}
+
+bool furi_string_equal_str(const FuriString* string, const char cstr[]) {
+    return strcmp(string->data, cstr) == 0;
+}
+
+bool furi_string_equal_string(const FuriString* string, const FuriString* other) {
+    return string->size == other->size && memcmp(string->data, other->data, string->size) == 0;
+}
+
+int furi_string_cmp_str(const FuriString* string, const char cstr[]) {
+    return strcmp(string->data, cstr);
+}
+
+bool furi_string_start_with_str(const FuriString* string, const char start[]) {
+    return strncmp(string->data, start, strlen(start)) == 0;
+}
+
+bool furi_string_end_with_str(const FuriString* string, const char end[]) {
+    size_t length = strlen(end);
+    return length <= string->size &&
+           memcmp(string->data + string->size - length, end, length) == 0;
+}
+
+void furi_string_left(FuriString* string, size_t index) {
+    if(index < string->size) {
+        string->size = index;
+        string->data[index] = '\0';
+    }
+}
+
+void furi_string_right(FuriString* string, size_t index) {
+    if(index >= string->size) {
+        furi_string_reset(string);
+    } else {
+        furi_string_set_strn(string, string->data + index, string->size - index);
+    }
+}
+
+void furi_string_trim(FuriString* string, const char chars[]) {
+    size_t begin = 0;
+    size_t end = string->size;
+    while(begin < end && strchr(chars, string->data[begin])) begin++;
+    while(end > begin && strchr(chars, string->data[end - 1])) end--;
+    furi_string_set_strn(string, string->data + begin, end - begin);
+}
+
+__attribute__((weak)) size_t strlcpy(char* dst, const char* src, size_t size) {
+    const size_t length = strlen(src);
+    if(size > 0) {
+        const size_t n = length < size - 1 ? length : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return length;
+}
@@ -0,0 +1,176 @@
+#include <furi.h>
+#include <gui/gui.h>
+#include <sim/sim.h>
+
+#include "sim_i.h"
+
+#define SIM_CANVAS_MAX_LINES 8
+#define SIM_CANVAS_LINE_SIZE 64
+
+struct Canvas {
+    char lines[SIM_CANVAS_MAX_LINES][SIM_CANVAS_LINE_SIZE];
+    const char* line_pointers[SIM_CANVAS_MAX_LINES];
+    size_t line_count;
+};
+
+struct ViewPort {
+    ViewPortDrawCallback draw_callback;
+    void* draw_context;
+    ViewPortInputCallback input_callback;
+    void* input_context;
+    bool enabled;
+    bool dirty;
+};
+
+struct Gui {
+    FuriThread* thread;
+    ViewPort* view_port;
+    bool drawing;
+    Canvas canvas;
+};
+
+static Gui sim_gui;
+
+static SimRenderCallback sim_render_callback = NULL;
+static void* sim_render_context = NULL;
+
+void sim_set_render_callback(SimRenderCallback callback, void* context) {
+    sim_render_callback = callback;
+    sim_render_context = context;
+}
+
+static bool sim_gui_has_work(void* context) {
+    Gui* gui = context;
+    return gui->view_port && gui->view_port->dirty;
+}
+
+/* Redraws happen on a dedicated thread, like the firmware's GUI service. */
+static int32_t sim_gui_thread(void* context) {
+    Gui* gui = context;
+
+    sim_lock_acquire();
+    for(;;) {
+        sim_wait_locked(sim_gui_has_work, gui, UINT64_MAX);
+        ViewPort* view_port = gui->view_port;
+        view_port->dirty = false;
+        gui->drawing = true;
+        sim_lock_release();
+
+        Canvas* canvas = &gui->canvas;
+        canvas->line_count = 0;
+        if(view_port->draw_callback) view_port->draw_callback(canvas, view_port->draw_context);
+        if(sim_render_callback) {
+            sim_render_callback(canvas->line_pointers, canvas->line_count, sim_render_context);
+        }
+
+        sim_lock_acquire();
+        gui->drawing = false;
+        sim_notify_locked();
+    }
+
+    return 0;
+}
+
+void* sim_gui_instance(void) {
+    if(!sim_gui.thread) {
+        for(size_t i = 0; i < SIM_CANVAS_MAX_LINES; ++i) {
+            sim_gui.canvas.line_pointers[i] = sim_gui.canvas.lines[i];
+        }
+        sim_gui.thread = furi_thread_alloc_ex("Gui", 2048, sim_gui_thread, &sim_gui);
+        furi_thread_start(sim_gui.thread);
+    }
+    return &sim_gui;
+}
+
+void sim_send_input(InputKey key, InputType type) {
+    ViewPort* view_port = sim_gui.view_port;
+    if(!view_port || !view_port->input_callback) return;
+
+    InputEvent event = {.key = key, .type = type};
+    view_port->input_callback(&event, view_port->input_context);
+}
+
+ViewPort* view_port_alloc(void) {
+    ViewPort* view_port = calloc(1, sizeof(ViewPort));
+    view_port->enabled = true;
+    return view_port;
+}
+
+void view_port_free(ViewPort* view_port) {
+    free(view_port);
+}
+
+void view_port_enabled_set(ViewPort* view_port, bool enabled) {
+    view_port->enabled = enabled;
+}
+
+void view_port_draw_callback_set(ViewPort* view_port, ViewPortDrawCallback callback, void* context) {
+    view_port->draw_callback = callback;
+    view_port->draw_context = context;
+}
+
+void view_port_input_callback_set(
+    ViewPort* view_port,
+    ViewPortInputCallback callback,
+    void* context) {
+    view_port->input_callback = callback;
+    view_port->input_context = context;
+}
+
+void view_port_update(ViewPort* view_port) {
+    sim_lock_acquire();
+    if(view_port->enabled && sim_gui.view_port == view_port) {
+        view_port->dirty = true;
+        sim_notify_locked();
+    }
+    sim_lock_release();
+}
+
+void gui_add_view_port(Gui* gui, ViewPort* view_port, GuiLayer layer) {
+    UNUSED(layer);
+    sim_lock_acquire();
+    gui->view_port = view_port;
+    view_port->dirty = true;
+    sim_notify_locked();
+    sim_lock_release();
+}
+
+static bool sim_gui_is_idle(void* context) {
+    return !((Gui*)context)->drawing;
+}
+
+void gui_remove_view_port(Gui* gui, ViewPort* view_port) {
+    sim_lock_acquire();
+    sim_wait_locked(sim_gui_is_idle, gui, UINT64_MAX);
+    if(gui->view_port == view_port) gui->view_port = NULL;
+    sim_lock_release();
+}
+
+void canvas_clear(Canvas* canvas) {
+    canvas->line_count = 0;
+}
+
+void canvas_set_font(Canvas* canvas, Font font) {
+    UNUSED(canvas);
+    UNUSED(font);
+}
+
+void canvas_draw_str(Canvas* canvas, int32_t x, int32_t y, const char* str) {
+    UNUSED(x);
+    UNUSED(y);
+    if(canvas->line_count < SIM_CANVAS_MAX_LINES) {
+        snprintf(canvas->lines[canvas->line_count++], SIM_CANVAS_LINE_SIZE, "%s", str);
+    }
+}
+
+void canvas_draw_str_aligned(
+    Canvas* canvas,
+    int32_t x,
+    int32_t y,
+    Align horizontal,
+    Align vertical,
+    const char* str) {
+    UNUSED(horizontal);
+    UNUSED(vertical);
+    canvas_draw_str(canvas, x, y, str);
+}
@@ -0,0 +1,293 @@
+#include <furi.h>
+#include <infrared/encoder_decoder/infrared.h>
+
+/*
+ * Pulse-distance protocols: a header mark/space, little-endian data bits where
+ * the space length carries the bit value, a stop mark, then silence up to the
+ * frame period. Repeats use the short repeat frame of the protocol.
+ */
+
+#define INFRARED_TOLERANCE_PERCENT 30
+
+typedef struct {
+    const char* name;
+    uint8_t address_length;
+    uint8_t command_length;
+    uint8_t bits;
+    uint32_t header_mark;
+    uint32_t header_space;
+    uint32_t repeat_space;
+    uint32_t bit_mark;
+    uint32_t zero_space;
+    uint32_t one_space;
+    uint32_t frame_period;
+    size_t min_repeat_count;
+} InfraredProtocolSpec;
+
+static const InfraredProtocolSpec infrared_protocols[InfraredProtocolMAX] = {
+    [InfraredProtocolNEC] = {"NEC", 8, 8, 32, 9000, 4500, 2250, 560, 560, 1690, 110000, 1},
+    [InfraredProtocolNECext] = {"NECext", 16, 16, 32, 9000, 4500, 2250, 560, 560, 1690, 110000, 1},
+    [InfraredProtocolNEC42] = {"NEC42", 13, 8, 42, 9000, 4500, 2250, 560, 560, 1690, 110000, 1},
+    [InfraredProtocolNEC42ext] =
+        {"NEC42ext", 26, 16, 42, 9000, 4500, 2250, 560, 560, 1690, 110000, 1},
+    [InfraredProtocolSamsung32] =
+        {"Samsung32", 8, 8, 32, 4500, 4500, 4500, 550, 550, 1650, 108000, 1},
+};
+
+static uint64_t infrared_pack(const InfraredMessage* message) {
+    uint64_t a = message->address;
+    uint64_t c = message->command;
+
+    switch(message->protocol) {
+    case InfraredProtocolNEC:
+        return (a & 0xFF) | ((~a & 0xFF) << 8) | ((c & 0xFF) << 16) | ((~c & 0xFF) << 24);
+    case InfraredProtocolNECext:
+        return (a & 0xFFFF) | ((c & 0xFFFF) << 16);
+    case InfraredProtocolNEC42:
+        return (a & 0x1FFF) | ((~a & 0x1FFF) << 13) | ((c & 0xFF) << 26) |
+               ((~c & 0xFF) << 34);
+    case InfraredProtocolNEC42ext:
+        return (a & 0x3FFFFFF) | ((c & 0xFFFF) << 26);
+    case InfraredProtocolSamsung32:
+        return (a & 0xFF) | ((a & 0xFF) << 8) | ((c & 0xFF) << 16) | ((~c & 0xFF) << 24);
+    default:
+        return 0;
+    }
+}
+
+static bool infrared_unpack(InfraredProtocol protocol, uint64_t data, InfraredMessage* message) {
+    message->protocol = protocol;
+    message->repeat = false;
+
+    switch(protocol) {
+    case InfraredProtocolNEC:
+        if(((data >> 16) & 0xFF) != (~(data >> 24) & 0xFF)) return false;
+        if((data & 0xFF) == (~(data >> 8) & 0xFF)) {
+            message->address = data & 0xFF;
+            message->command = (data >> 16) & 0xFF;
+            return true;
+        }
+        return false;
+    case InfraredProtocolNECext:
+        message->address = data & 0xFFFF;
+        message->command = (data >> 16) & 0xFFFF;
+        return true;
+    case InfraredProtocolNEC42:
+        message->address = data & 0x1FFF;
+        message->command = (data >> 26) & 0xFF;
+        return true;
+    case InfraredProtocolNEC42ext:
+        message->address = data & 0x3FFFFFF;
+        message->command = (data >> 26) & 0xFFFF;
+        return true;
+    case InfraredProtocolSamsung32:
+        if((data & 0xFF) != ((data >> 8) & 0xFF)) return false;
+        message->address = data & 0xFF;
+        message->command = (data >> 16) & 0xFF;
+        return true;
+    default:
+        return false;
+    }
+}
+
+const char* infrared_get_protocol_name(InfraredProtocol protocol) {
+    return infrared_is_protocol_valid(protocol) ? infrared_protocols[protocol].name : "Invalid";
+}
+
+InfraredProtocol infrared_get_protocol_by_name(const char* protocol_name) {
+    for(int i = 0; i < InfraredProtocolMAX; ++i) {
+        if(strcmp(infrared_protocols[i].name, protocol_name) == 0) return (InfraredProtocol)i;
+    }
+    return InfraredProtocolUnknown;
+}
+
+bool infrared_is_protocol_valid(InfraredProtocol protocol) {
+    return protocol >= 0 && protocol < InfraredProtocolMAX;
+}
+
+uint8_t infrared_get_protocol_address_length(InfraredProtocol protocol) {
+    return infrared_is_protocol_valid(protocol) ? infrared_protocols[protocol].address_length : 0;
+}
+
+uint8_t infrared_get_protocol_command_length(InfraredProtocol protocol) {
+    return infrared_is_protocol_valid(protocol) ? infrared_protocols[protocol].command_length : 0;
+}
+
+uint32_t infrared_get_protocol_frequency(InfraredProtocol protocol) {
+    UNUSED(protocol);
+    return INFRARED_COMMON_CARRIER_FREQUENCY;
+}
+
+float infrared_get_protocol_duty_cycle(InfraredProtocol protocol) {
+    UNUSED(protocol);
+    return INFRARED_COMMON_DUTY_CYCLE;
+}
+
+size_t infrared_get_protocol_min_repeat_count(InfraredProtocol protocol) {
+    return infrared_is_protocol_valid(protocol) ? infrared_protocols[protocol].min_repeat_count :
+                                                  1;
+}
+
+/* Encoder */
+
+#define INFRARED_ENCODER_MAX_STEPS (2 + 2 * 64 + 2)
+
+struct InfraredEncoderHandler {
+    InfraredMessage message;
+    uint32_t durations[INFRARED_ENCODER_MAX_STEPS];
+    size_t count;
+    size_t index;
+};
+
+static void infrared_encoder_build(InfraredEncoderHandler* handler, bool repeat) {
+    const InfraredProtocolSpec* spec = &infrared_protocols[handler->message.protocol];
+    size_t count = 0;
+    uint32_t elapsed = 0;
+
+    handler->durations[count++] = spec->header_mark;
+    if(repeat) {
+        handler->durations[count++] = spec->repeat_space;
+    } else {
+        handler->durations[count++] = spec->header_space;
+        uint64_t data = infrared_pack(&handler->message);
+        for(uint8_t bit = 0; bit < spec->bits; ++bit) {
+            handler->durations[count++] = spec->bit_mark;
+            handler->durations[count++] = ((data >> bit) & 1) ? spec->one_space :
+                                                                  spec->zero_space;
+        }
+    }
+    handler->durations[count++] = spec->bit_mark;
+
+    for(size_t i = 0; i < count; ++i) elapsed += handler->durations[i];
+    handler->durations[count++] =
+        spec->frame_period > elapsed ? spec->frame_period - elapsed : spec->bit_mark;
+
+    handler->count = count;
+    handler->index = 0;
+}
+
+InfraredEncoderHandler* infrared_alloc_encoder(void) {
+    return calloc(1, sizeof(InfraredEncoderHandler));
+}
+
+void infrared_free_encoder(InfraredEncoderHandler* handler) {
+    free(handler);
+}
+
+void infrared_reset_encoder(InfraredEncoderHandler* handler, const InfraredMessage* message) {
+    furi_check(infrared_is_protocol_valid(message->protocol));
+    handler->message = *message;
+    infrared_encoder_build(handler, message->repeat);
+}
+
+InfraredStatus infrared_encode(InfraredEncoderHandler* handler, uint32_t* duration, bool* level) {
+    if(handler->index >= handler->count) infrared_encoder_build(handler, true);
+
+    *level = (handler->index % 2) == 0;
+    *duration = handler->durations[handler->index++];
+    return handler->index == handler->count ? InfraredStatusDone : InfraredStatusOk;
+}
+
+/* Decoder */
+
+struct InfraredDecoderHandler {
+    InfraredMessage message;
+    bool ready;
+    bool have_message;
+    int protocol;
+    uint32_t pending_mark;
+    uint32_t timings[2 + 2 * 64 + 1];
+    size_t count;
+};
+
+static bool infrared_match(uint32_t duration, uint32_t expected) {
+    uint32_t delta = expected * INFRARED_TOLERANCE_PERCENT / 100;
+    return duration + delta >= expected && duration <= expected + delta;
+}
+
+static bool infrared_decoder_try(InfraredDecoderHandler* handler) {
+    const uint32_t* t = handler->timings;
+    size_t n = handler->count;
+
+    for(int p = 0; p < InfraredProtocolMAX; ++p) {
+        const InfraredProtocolSpec* spec = &infrared_protocols[p];
+        if(!infrared_match(t[0], spec->header_mark)) continue;
+
+        if(n == 3 && infrared_match(t[1], spec->repeat_space) &&
+           infrared_match(t[2], spec->bit_mark) && handler->have_message &&
+           handler->message.protocol == p) {
+            handler->message.repeat = true;
+            return true;
+        }
+
+        if(n != (size_t)(3 + 2 * spec->bits) || !infrared_match(t[1], spec->header_space)) {
+            continue;
+        }
+
+        uint64_t data = 0;
+        bool valid = true;
+        for(uint8_t bit = 0; bit < spec->bits && valid; ++bit) {
+            uint32_t mark = t[2 + 2 * bit];
+            uint32_t space = t[3 + 2 * bit];
+            if(!infrared_match(mark, spec->bit_mark)) {
+                valid = false;
+            } else if(infrared_match(space, spec->one_space)) {
+                data |= 1ULL << bit;
+            } else if(!infrared_match(space, spec->zero_space)) {
+                valid = false;
+            }
+        }
+
+        InfraredMessage message;
+        if(valid && infrared_unpack((InfraredProtocol)p, data, &message)) {
+            handler->message = message;
+            handler->have_message = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+InfraredDecoderHandler* infrared_alloc_decoder(void) {
+    return calloc(1, sizeof(InfraredDecoderHandler));
+}
+
+void infrared_free_decoder(InfraredDecoderHandler* handler) {
+    free(handler);
+}
+
+void infrared_reset_decoder(InfraredDecoderHandler* handler) {
+    handler->count = 0;
+    handler->ready = false;
+    handler->have_message = false;
+}
+
+const InfraredMessage*
+    infrared_decode(InfraredDecoderHandler* handler, bool level, uint32_t duration) {
+    const InfraredMessage* result = NULL;
+
+    // A long space terminates the current frame.
+    if(!level && duration > 20000) {
+        if(handler->count > 0 && handler->count < COUNT_OF(handler->timings)) {
+            if(infrared_decoder_try(handler)) result = &handler->message;
+        }
+        handler->count = 0;
+        return result;
+    }
+
+    if(handler->count == 0 && !level) return NULL;
+    if(handler->count >= COUNT_OF(handler->timings)) {
+        handler->count = 0;
+        return NULL;
+    }
+    handler->timings[handler->count++] = duration;
+    return NULL;
+}
+
+const InfraredMessage* infrared_check_decoder_ready(InfraredDecoderHandler* handler) {
+    const InfraredMessage* result = NULL;
+    if(handler->count > 0 && infrared_decoder_try(handler)) result = &handler->message;
+    handler->count = 0;
+    return result;
+}
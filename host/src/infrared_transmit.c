@@ -0,0 +1,226 @@
+#include <furi.h>
+#include <furi_hal_infrared.h>
+#include <infrared_transmit.h>
+#include <infrared_worker.h>
+#include <sim/sim.h>
+
+#include "sim_i.h"
+
+/* Spaces longer than this split a raw transmission into separately reported frames. */
+#define SIM_FRAME_SPLIT_US 20000
+
+static SimTransmissionCallback sim_transmission_callback = NULL;
+static void* sim_transmission_context = NULL;
+
+static FuriHalInfraredTxGetDataISRCallback sim_tx_callback = NULL;
+static void* sim_tx_context = NULL;
+static uint64_t sim_tx_end_us = 0;
+static bool sim_tx_busy = false;
+
+void sim_set_transmission_callback(SimTransmissionCallback callback, void* context) {
+    sim_transmission_callback = callback;
+    sim_transmission_context = context;
+}
+
+static void sim_report(const SimTransmission* transmission) {
+    if(sim_transmission_callback) {
+        sim_transmission_callback(transmission, sim_transmission_context);
+    }
+}
+
+typedef struct {
+    uint64_t start_us;
+    uint64_t elapsed_us;
+    uint32_t frequency;
+    SimTransmission frame;
+    InfraredDecoderHandler* decoder;
+    uint32_t timings[MAX_TIMINGS_AMOUNT]; /* Timings of the current frame, for the loopback. */
+} SimRawReport;
+
+static void sim_raw_report_begin(SimRawReport* report, uint64_t start_us, uint32_t frequency) {
+    memset(report, 0, sizeof(SimRawReport));
+    report->start_us = start_us;
+    report->frequency = frequency;
+    report->decoder = infrared_alloc_decoder();
+    report->frame.message.protocol = InfraredProtocolUnknown;
+}
+
+static void sim_raw_report_flush(SimRawReport* report) {
+    if(report->frame.timings_size == 0) return;
+
+    if(report->frame.message.protocol == InfraredProtocolUnknown) {
+        const InfraredMessage* message = infrared_check_decoder_ready(report->decoder);
+        if(message) report->frame.message = *message;
+    }
+
+    report->frame.is_raw = true;
+    report->frame.frequency = report->frequency;
+    sim_report(&report->frame);
+    if(!report->frame.message.repeat) {
+        sim_rx_loopback(
+            report->timings,
+            MIN(report->frame.timings_size, (size_t)MAX_TIMINGS_AMOUNT),
+            report->frame.time_us);
+    }
+
+    memset(&report->frame, 0, sizeof(SimTransmission));
+    report->frame.message.protocol = InfraredProtocolUnknown;
+    infrared_reset_decoder(report->decoder);
+}
+
+static void sim_raw_report_push(SimRawReport* report, bool level, uint32_t duration) {
+    if(report->frame.timings_size == 0) {
+        if(!level) {
+            report->elapsed_us += duration;
+            return;
+        }
+        report->frame.time_us = report->start_us + report->elapsed_us;
+    }
+
+    const InfraredMessage* message = infrared_decode(report->decoder, level, duration);
+    if(message) report->frame.message = *message;
+    if(report->frame.timings_size < MAX_TIMINGS_AMOUNT) {
+        report->timings[report->frame.timings_size] = duration;
+    }
+    report->frame.timings_size++;
+    report->frame.duration_us += duration;
+    report->elapsed_us += duration;
+
+    if(!level && duration >= SIM_FRAME_SPLIT_US) sim_raw_report_flush(report);
+}
+
+static void sim_raw_report_end(SimRawReport* report) {
+    sim_raw_report_flush(report);
+    infrared_free_decoder(report->decoder);
+}
+
+bool furi_hal_infrared_is_busy(void) {
+    return sim_tx_busy;
+}
+
+void furi_hal_infrared_async_tx_set_data_isr_callback(
+    FuriHalInfraredTxGetDataISRCallback callback,
+    void* context) {
+    sim_tx_callback = callback;
+    sim_tx_context = context;
+}
+
+void furi_hal_infrared_async_tx_start(uint32_t freq, float duty_cycle) {
+    UNUSED(duty_cycle);
+    furi_check(sim_tx_callback);
+    furi_check(!sim_tx_busy);
+
+    uint64_t start_us = sim_get_time_us();
+    SimRawReport report;
+    sim_raw_report_begin(&report, start_us, freq);
+
+    FuriHalInfraredTxGetDataState state;
+    do {
+        uint32_t duration = 0;
+        bool level = false;
+        state = sim_tx_callback(sim_tx_context, &duration, &level);
+        sim_raw_report_push(&report, level, duration);
+    } while(state != FuriHalInfraredTxGetDataStateLastDone);
+
+    sim_tx_end_us = start_us + report.elapsed_us;
+    sim_tx_busy = true;
+    sim_raw_report_end(&report);
+}
+
+void furi_hal_infrared_async_tx_wait_termination(void) {
+    if(!sim_tx_busy) return;
+    uint64_t now = sim_get_time_us();
+    if(sim_tx_end_us > now) sim_sleep_us(sim_tx_end_us - now);
+    sim_tx_busy = false;
+}
+
+void furi_hal_infrared_async_tx_stop(void) {
+    furi_hal_infrared_async_tx_wait_termination();
+}
+
+typedef struct {
+    const uint32_t* timings;
+    uint32_t timings_cnt;
+    uint32_t index;
+    bool level;
+} SimRawSource;
+
+static FuriHalInfraredTxGetDataState
+    sim_raw_source_callback(void* context, uint32_t* duration, bool* level) {
+    SimRawSource* source = context;
+    *duration = source->timings[source->index++];
+    *level = source->level;
+    source->level = !source->level;
+    return source->index >= source->timings_cnt ? FuriHalInfraredTxGetDataStateLastDone :
+                                                  FuriHalInfraredTxGetDataStateOk;
+}
+
+void infrared_send_raw_ext(
+    const uint32_t timings[],
+    uint32_t timings_cnt,
+    bool start_from_mark,
+    uint32_t frequency,
+    float duty_cycle) {
+    furi_check(timings_cnt > 0);
+    SimRawSource source = {
+        .timings = timings, .timings_cnt = timings_cnt, .level = start_from_mark};
+
+    furi_hal_infrared_async_tx_set_data_isr_callback(sim_raw_source_callback, &source);
+    furi_hal_infrared_async_tx_start(frequency, duty_cycle);
+    furi_hal_infrared_async_tx_wait_termination();
+}
+
+void infrared_send_raw(const uint32_t timings[], uint32_t timings_cnt, bool start_from_mark) {
+    infrared_send_raw_ext(
+        timings,
+        timings_cnt,
+        start_from_mark,
+        INFRARED_COMMON_CARRIER_FREQUENCY,
+        INFRARED_COMMON_DUTY_CYCLE);
+}
+
+void infrared_send(const InfraredMessage* message, int times) {
+    furi_check(infrared_is_protocol_valid(message->protocol));
+
+    InfraredEncoderHandler* encoder = infrared_alloc_encoder();
+    infrared_reset_encoder(encoder, message);
+
+    size_t frames = MAX((size_t)times, infrared_get_protocol_min_repeat_count(message->protocol));
+    uint64_t start_us = sim_get_time_us();
+    uint64_t elapsed_us = 0;
+    uint32_t* timings = malloc(MAX_TIMINGS_AMOUNT * sizeof(uint32_t));
+
+    for(size_t frame = 0; frame < frames; ++frame) {
+        SimTransmission transmission = {
+            .time_us = start_us + elapsed_us,
+            .message = *message,
+            .frequency = infrared_get_protocol_frequency(message->protocol),
+        };
+        transmission.message.repeat = frame > 0;
+
+        InfraredStatus status;
+        do {
+            uint32_t duration;
+            bool level;
+            status = infrared_encode(encoder, &duration, &level);
+            if(transmission.timings_size < MAX_TIMINGS_AMOUNT) {
+                timings[transmission.timings_size] = duration;
+            }
+            transmission.duration_us += duration;
+            transmission.timings_size++;
+        } while(status == InfraredStatusOk);
+
+        elapsed_us += transmission.duration_us;
+        sim_report(&transmission);
+        if(frame == 0) {
+            sim_rx_loopback(
+                timings,
+                MIN(transmission.timings_size, (size_t)MAX_TIMINGS_AMOUNT),
+                transmission.time_us);
+        }
+    }
+
+    free(timings);
+    infrared_free_encoder(encoder);
+    sim_sleep_us(elapsed_us);
+}
@@ -0,0 +1,220 @@
+#include <furi.h>
+#include <infrared_worker.h>
+#include <sim/sim.h>
+
+#include "sim_i.h"
+
+/* Time between the start of a receive session and a queued capture being heard. */
+#define SIM_RX_DELAY_MS 20
+/* Time between the last mark of a frame and the start of its echo, as sent back by a repeater. */
+#define SIM_RX_ECHO_DELAY_MS 60
+#define SIM_RX_QUEUE_SIZE 64
+
+struct InfraredWorkerSignal {
+    bool is_decoded;
+    InfraredMessage message;
+    uint32_t timings[MAX_TIMINGS_AMOUNT];
+    size_t timings_size;
+};
+
+struct InfraredWorker {
+    InfraredWorkerReceivedSignalCallback callback;
+    void* context;
+    bool is_decoding;
+    FuriTimer* timer;
+    InfraredWorkerSignal signal;
+};
+
+/* The one infrared receiver: the worker receiving, if any, and what it is going to hear. */
+static InfraredWorker* sim_rx_worker = NULL;
+
+static InfraredWorkerSignal* sim_rx_queue[SIM_RX_QUEUE_SIZE];
+static size_t sim_rx_queue_head = 0;
+static size_t sim_rx_queue_count = 0;
+
+static InfraredWorkerSignal sim_rx_echo;
+static bool sim_rx_has_echo = false;
+static uint64_t sim_rx_echo_start_us = 0;
+static uint64_t sim_rx_echo_end_us = 0;
+static bool sim_rx_loopback_enabled = false;
+static uint32_t sim_rx_loss_percent = 0;
+static uint32_t sim_rx_random = 1;
+
+static void sim_rx_decode(InfraredWorkerSignal* signal) {
+    InfraredDecoderHandler* decoder = infrared_alloc_decoder();
+    signal->is_decoded = false;
+
+    for(size_t i = 0; i <= signal->timings_size && !signal->is_decoded; ++i) {
+        const InfraredMessage* message = i < signal->timings_size ?
+                                             infrared_decode(decoder, !(i & 1), signal->timings[i]) :
+                                             infrared_check_decoder_ready(decoder);
+        if(message) {
+            signal->message = *message;
+            signal->is_decoded = true;
+        }
+    }
+
+    infrared_free_decoder(decoder);
+}
+
+static void sim_rx_set_timings(InfraredWorkerSignal* signal, const uint32_t* timings, size_t timings_size) {
+    signal->timings_size = MIN(timings_size, (size_t)MAX_TIMINGS_AMOUNT);
+    memcpy(signal->timings, timings, signal->timings_size * sizeof(uint32_t));
+}
+
+static void sim_rx_push(InfraredWorkerSignal* signal) {
+    if(sim_rx_queue_count == SIM_RX_QUEUE_SIZE) {
+        free(signal);
+        return;
+    }
+    sim_rx_queue[(sim_rx_queue_head + sim_rx_queue_count++) % SIM_RX_QUEUE_SIZE] = signal;
+}
+
+void sim_rx_inject_raw(const uint32_t* timings, size_t timings_size) {
+    InfraredWorkerSignal* signal = malloc(sizeof(InfraredWorkerSignal));
+    sim_rx_set_timings(signal, timings, timings_size);
+    sim_rx_decode(signal);
+    sim_rx_push(signal);
+}
+
+void sim_rx_inject_message(const InfraredMessage* message) {
+    InfraredWorkerSignal* signal = malloc(sizeof(InfraredWorkerSignal));
+    InfraredEncoderHandler* encoder = infrared_alloc_encoder();
+    infrared_reset_encoder(encoder, message);
+
+    // One frame, as the receiver would report it.
+    signal->timings_size = 0;
+    InfraredStatus status;
+    do {
+        uint32_t duration;
+        bool level;
+        status = infrared_encode(encoder, &duration, &level);
+        if(signal->timings_size < MAX_TIMINGS_AMOUNT) {
+            signal->timings[signal->timings_size++] = duration;
+        }
+    } while(status == InfraredStatusOk);
+
+    infrared_free_encoder(encoder);
+
+    signal->is_decoded = true;
+    signal->message = *message;
+    signal->message.repeat = false;
+    sim_rx_push(signal);
+}
+
+void sim_rx_set_loopback(bool enable, uint32_t loss_percent) {
+    sim_rx_loopback_enabled = enable;
+    sim_rx_loss_percent = loss_percent;
+    sim_rx_has_echo = false;
+}
+
+void sim_rx_loopback(const uint32_t* timings, size_t timings_size, uint64_t start_us) {
+    if(!sim_rx_loopback_enabled || timings_size == 0) return;
+
+    // The echo is the frame without its trailing space, starting a while after its last mark.
+    const size_t marks_size = timings_size & 1 ? timings_size : timings_size - 1;
+    uint64_t marks_us = 0;
+    for(size_t i = 0; i < marks_size; ++i) {
+        marks_us += timings[i];
+    }
+
+    // Same sequence on every run, so that lost frames can be reproduced.
+    sim_rx_random = sim_rx_random * 1103515245 + 12345;
+    if((sim_rx_random >> 16) % 100 < sim_rx_loss_percent) {
+        sim_rx_has_echo = false;
+        return;
+    }
+
+    sim_rx_set_timings(&sim_rx_echo, timings, marks_size);
+    sim_rx_decode(&sim_rx_echo);
+    sim_rx_has_echo = true;
+    sim_rx_echo_start_us = start_us + marks_us + SIM_RX_ECHO_DELAY_MS * SIM_US_PER_MS;
+    sim_rx_echo_end_us = sim_rx_echo_start_us + marks_us;
+}
+
+static void sim_rx_timer_callback(void* context) {
+    InfraredWorker* instance = context;
+    if(sim_rx_worker != instance) return;
+
+    if(sim_rx_queue_count > 0) {
+        InfraredWorkerSignal* signal = sim_rx_queue[sim_rx_queue_head];
+        sim_rx_queue_head = (sim_rx_queue_head + 1) % SIM_RX_QUEUE_SIZE;
+        sim_rx_queue_count--;
+        instance->signal = *signal;
+        free(signal);
+    } else if(sim_rx_has_echo) {
+        instance->signal = sim_rx_echo;
+        sim_rx_has_echo = false;
+    } else {
+        return;
+    }
+
+    if(!instance->is_decoding) instance->signal.is_decoded = false;
+    if(instance->callback) instance->callback(instance->context, &instance->signal);
+}
+
+InfraredWorker* infrared_worker_alloc(void) {
+    InfraredWorker* instance = malloc(sizeof(InfraredWorker));
+    memset(instance, 0, sizeof(InfraredWorker));
+    instance->is_decoding = true;
+    instance->timer = furi_timer_alloc(sim_rx_timer_callback, FuriTimerTypeOnce, instance);
+    return instance;
+}
+
+void infrared_worker_free(InfraredWorker* instance) {
+    furi_check(sim_rx_worker != instance);
+    furi_timer_free(instance->timer);
+    free(instance);
+}
+
+void infrared_worker_rx_start(InfraredWorker* instance) {
+    furi_check(sim_rx_worker == NULL);
+    sim_rx_worker = instance;
+
+    // One signal is heard per session: the next one queued, otherwise the echo of the last frame sent.
+    // Like a real receiver, it only hears an echo it is already listening for when the echo starts.
+    const uint64_t now_us = sim_get_time_us();
+    if(sim_rx_queue_count > 0) {
+        furi_timer_start(instance->timer, furi_ms_to_ticks(SIM_RX_DELAY_MS));
+    } else if(sim_rx_has_echo && now_us <= sim_rx_echo_start_us) {
+        const uint64_t wait_us = sim_rx_echo_end_us - now_us;
+        furi_timer_start(
+            instance->timer, furi_ms_to_ticks((wait_us + SIM_US_PER_MS - 1) / SIM_US_PER_MS));
+    } else {
+        sim_rx_has_echo = false;
+    }
+}
+
+void infrared_worker_rx_stop(InfraredWorker* instance) {
+    furi_check(sim_rx_worker == instance);
+    furi_timer_stop(instance->timer);
+    sim_rx_worker = NULL;
+}
+
+void infrared_worker_rx_set_received_signal_callback(
+    InfraredWorker* instance,
+    InfraredWorkerReceivedSignalCallback callback,
+    void* context) {
+    instance->callback = callback;
+    instance->context = context;
+}
+
+void infrared_worker_rx_enable_signal_decoding(InfraredWorker* instance, bool enable) {
+    instance->is_decoding = enable;
+}
+
+bool infrared_worker_signal_is_decoded(const InfraredWorkerSignal* signal) {
+    return signal->is_decoded;
+}
+
+const InfraredMessage* infrared_worker_get_decoded_signal(const InfraredWorkerSignal* signal) {
+    return &signal->message;
+}
+
+void infrared_worker_get_raw_signal(
+    const InfraredWorkerSignal* signal,
+    const uint32_t** timings,
+    size_t* timings_cnt) {
+    *timings = signal->timings;
+    *timings_cnt = signal->timings_size;
+}
@@ -0,0 +1,30 @@
+/* Internal interface shared by the host stand-ins. */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef bool (*SimPredicate)(void* context);
+
+void sim_lock_acquire(void);
+void sim_lock_release(void);
+uint64_t sim_now_locked(void);
+
+/* Wake every blocked waiter so it re-evaluates its predicate. Lock must be held. */
+void sim_notify_locked(void);
+
+/*
+ * Block until predicate returns true or the virtual clock reaches deadline_us.
+ * Lock must be held. Returns the final predicate result.
+ */
+bool sim_wait_locked(SimPredicate predicate, void* context, uint64_t deadline_us);
+uint64_t sim_deadline_from_ticks(uint32_t timeout);
+
+void* sim_gui_instance(void);
+
+/*
+ * Hand a frame just transmitted, which started at start_us, to the receiver stand-in. If loopback is
+ * on, it is echoed back a while after it ended, and only heard by a receive session started by then.
+ */
+void sim_rx_loopback(const uint32_t* timings, size_t timings_size, uint64_t start_us);
@@ -0,0 +1,688 @@
+#include <furi.h>
+#include <furi_hal_cortex.h>
+#include <furi_hal_rtc.h>
+#include <sim/sim.h>
+
+#include <pthread.h>
+#include <stdarg.h>
+
+#include "sim_i.h"
+
+typedef struct SimWaiter {
+    struct SimWaiter* next;
+    uint64_t deadline_us;
+    bool blocked;
+} SimWaiter;
+
+struct FuriThread {
+    pthread_t pthread;
+    const char* name;
+    FuriThreadCallback callback;
+    void* context;
+    bool started;
+    bool finished;
+    int32_t return_code;
+    uint32_t flags;
+};
+
+struct FuriTimer {
+    FuriTimer* next;
+    FuriTimerCallback callback;
+    void* context;
+    FuriTimerType type;
+    bool running;
+    uint32_t period_ticks;
+    uint64_t expire_us;
+};
+
+struct FuriMessageQueue {
+    uint8_t* buffer;
+    uint32_t msg_size;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t count;
+};
+
+struct FuriMutex {
+    FuriMutexType type;
+    FuriThreadId owner;
+    uint32_t depth;
+};
+
+typedef struct SimPending {
+    struct SimPending* next;
+    FuriTimerPendigCallback callback;
+    void* context;
+    uint32_t arg;
+} SimPending;
+
+static pthread_mutex_t sim_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sim_cond = PTHREAD_COND_INITIALIZER;
+static uint64_t sim_now_us = 0;
+static int sim_running = 1;
+static SimWaiter* sim_waiters = NULL;
+
+static FuriThread sim_main_thread = {.name = "main", .started = true};
+static __thread FuriThread* sim_current_thread = NULL;
+
+static FuriTimer* sim_timers = NULL;
+static SimPending* sim_pending = NULL;
+static uint32_t sim_timer_generation = 0;
+static bool sim_timer_service_started = false;
+static FuriThread sim_timer_thread = {.name = "TimerSvc"};
+
+static uint32_t sim_rtc_base = SIM_RTC_BASE;
+
+static SimTimerFireCallback sim_timer_fire_callback = NULL;
+static void* sim_timer_fire_context = NULL;
+
+static FuriLogLevel sim_log_level = FuriLogLevelWarn;
+
+void sim_lock_acquire(void) {
+    pthread_mutex_lock(&sim_lock);
+}
+
+void sim_lock_release(void) {
+    pthread_mutex_unlock(&sim_lock);
+}
+
+uint64_t sim_now_locked(void) {
+    return sim_now_us;
+}
+
+void sim_notify_locked(void) {
+    for(SimWaiter* waiter = sim_waiters; waiter; waiter = waiter->next) {
+        if(waiter->blocked) {
+            waiter->blocked = false;
+            sim_running++;
+        }
+    }
+    pthread_cond_broadcast(&sim_cond);
+}
+
+/* Called whenever the last running thread blocks: jump to the next deadline. */
+static void sim_advance_locked(void) {
+    if(sim_running != 0) return;
+
+    uint64_t next_us = UINT64_MAX;
+    for(SimWaiter* waiter = sim_waiters; waiter; waiter = waiter->next) {
+        if(waiter->blocked && waiter->deadline_us < next_us) next_us = waiter->deadline_us;
+    }
+
+    if(next_us == UINT64_MAX) {
+        fprintf(stderr, "sim: deadlock, every thread waits forever at %llu us\n",
+            (unsigned long long)sim_now_us);
+        abort();
+    }
+
+    sim_now_us = next_us;
+
+    for(SimWaiter* waiter = sim_waiters; waiter; waiter = waiter->next) {
+        if(waiter->blocked && waiter->deadline_us <= sim_now_us) {
+            waiter->blocked = false;
+            sim_running++;
+        }
+    }
+    pthread_cond_broadcast(&sim_cond);
+}
+
+bool sim_wait_locked(SimPredicate predicate, void* context, uint64_t deadline_us) {
+    SimWaiter waiter = {.deadline_us = deadline_us};
+
+    for(;;) {
+        if(predicate && predicate(context)) return true;
+        if(sim_now_us >= deadline_us) return false;
+
+        waiter.blocked = true;
+        waiter.next = sim_waiters;
+        sim_waiters = &waiter;
+        sim_running--;
+
+        sim_advance_locked();
+        while(waiter.blocked) {
+            pthread_cond_wait(&sim_cond, &sim_lock);
+        }
+
+        for(SimWaiter** link = &sim_waiters; *link; link = &(*link)->next) {
+            if(*link == &waiter) {
+                *link = waiter.next;
+                break;
+            }
+        }
+    }
+}
+
+uint64_t sim_deadline_from_ticks(uint32_t timeout) {
+    if(timeout == FuriWaitForever) return UINT64_MAX;
+    return sim_now_us + (uint64_t)timeout * SIM_US_PER_MS;
+}
+
+uint64_t sim_get_time_us(void) {
+    sim_lock_acquire();
+    uint64_t now = sim_now_us;
+    sim_lock_release();
+    return now;
+}
+
+void sim_sleep_us(uint64_t duration_us) {
+    sim_lock_acquire();
+    sim_wait_locked(NULL, NULL, sim_now_us + duration_us);
+    sim_lock_release();
+}
+
+void sim_set_rtc_base(uint32_t timestamp) {
+    sim_rtc_base = timestamp;
+}
+
+void sim_set_timer_fire_callback(SimTimerFireCallback callback, void* context) {
+    sim_timer_fire_callback = callback;
+    sim_timer_fire_context = context;
+}
+
+/* Kernel */
+
+uint32_t furi_get_tick(void) {
+    return (uint32_t)(sim_get_time_us() / SIM_US_PER_MS);
+}
+
+uint32_t furi_kernel_get_tick_frequency(void) {
+    return 1000;
+}
+
+uint32_t furi_ms_to_ticks(uint32_t milliseconds) {
+    return milliseconds;
+}
+
+void furi_delay_tick(uint32_t ticks) {
+    sim_sleep_us((uint64_t)ticks * SIM_US_PER_MS);
+}
+
+void furi_delay_ms(uint32_t milliseconds) {
+    sim_sleep_us((uint64_t)milliseconds * SIM_US_PER_MS);
+}
+
+void furi_delay_us(uint32_t microseconds) {
+    sim_sleep_us(microseconds);
+}
+
+uint32_t furi_hal_rtc_get_timestamp(void) {
+    return sim_rtc_base + (uint32_t)(sim_get_time_us() / SIM_US_PER_S);
+}
+
+#define SIM_CYCLES_PER_US (64U)
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void) {
+    return SIM_CYCLES_PER_US;
+}
+
+FuriHalCortexTimer furi_hal_cortex_timer_get(uint32_t timeout_us) {
+    FuriHalCortexTimer timer = {
+        .start = (uint32_t)(sim_get_time_us() * SIM_CYCLES_PER_US),
+        .value = timeout_us * SIM_CYCLES_PER_US,
+    };
+    return timer;
+}
+
+bool furi_hal_cortex_timer_is_expired(FuriHalCortexTimer cortex_timer) {
+    return (uint32_t)(sim_get_time_us() * SIM_CYCLES_PER_US) - cortex_timer.start >=
+           cortex_timer.value;
+}
+
+/* Logging */
+
+void furi_log_set_level(FuriLogLevel level) {
+    sim_log_level = level;
+}
+
+void furi_log_print_format(FuriLogLevel level, const char* tag, const char* format, ...) {
+    if(level > sim_log_level) return;
+
+    static const char letters[] = "??EWIDT";
+    uint64_t now = sim_get_time_us();
+
+    char line[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    fprintf(
+        stderr,
+        "%10llu.%03llu [%c][%s] %s\n",
+        (unsigned long long)(now / SIM_US_PER_S),
+        (unsigned long long)(now / SIM_US_PER_MS % 1000),
+        letters[level],
+        tag,
+        line);
+}
+
+/* Threads */
+
+static FuriThread* sim_thread_current(void) {
+    return sim_current_thread ? sim_current_thread : &sim_main_thread;
+}
+
+static void* sim_thread_body(void* context) {
+    FuriThread* thread = context;
+    sim_current_thread = thread;
+
+    int32_t return_code = thread->callback(thread->context);
+
+    sim_lock_acquire();
+    thread->return_code = return_code;
+    thread->finished = true;
+    sim_running--;
+    sim_notify_locked();
+    sim_advance_locked();
+    sim_lock_release();
+
+    return NULL;
+}
+
+static void sim_thread_spawn(FuriThread* thread) {
+    sim_lock_acquire();
+    thread->started = true;
+    sim_running++;
+    sim_lock_release();
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, 256 * 1024);
+    furi_check(pthread_create(&thread->pthread, &attr, sim_thread_body, thread) == 0);
+    pthread_attr_destroy(&attr);
+}
+
+FuriThread* furi_thread_alloc_ex(
+    const char* name,
+    uint32_t stack_size,
+    FuriThreadCallback callback,
+    void* context) {
+    UNUSED(stack_size);
+    FuriThread* thread = calloc(1, sizeof(FuriThread));
+    thread->name = name;
+    thread->callback = callback;
+    thread->context = context;
+    return thread;
+}
+
+void furi_thread_free(FuriThread* thread) {
+    furi_check(!thread->started || thread->finished);
+    free(thread);
+}
+
+void furi_thread_set_priority(FuriThread* thread, FuriThreadPriority priority) {
+    UNUSED(thread);
+    UNUSED(priority);
+}
+
+void furi_thread_start(FuriThread* thread) {
+    furi_check(!thread->started);
+    sim_thread_spawn(thread);
+}
+
+static bool sim_thread_is_finished(void* context) {
+    return ((FuriThread*)context)->finished;
+}
+
+bool furi_thread_join(FuriThread* thread) {
+    sim_lock_acquire();
+    sim_wait_locked(sim_thread_is_finished, thread, UINT64_MAX);
+    sim_lock_release();
+    pthread_join(thread->pthread, NULL);
+    return true;
+}
+
+int32_t furi_thread_get_return_code(FuriThread* thread) {
+    return thread->return_code;
+}
+
+FuriThreadId furi_thread_get_id(FuriThread* thread) {
+    return thread;
+}
+
+FuriThreadId furi_thread_get_current_id(void) {
+    return sim_thread_current();
+}
+
+uint32_t furi_thread_flags_set(FuriThreadId thread_id, uint32_t flags) {
+    FuriThread* thread = thread_id;
+    sim_lock_acquire();
+    thread->flags |= flags;
+    uint32_t result = thread->flags;
+    sim_notify_locked();
+    sim_lock_release();
+    return result;
+}
+
+uint32_t furi_thread_flags_clear(uint32_t flags) {
+    FuriThread* thread = sim_thread_current();
+    sim_lock_acquire();
+    uint32_t result = thread->flags;
+    thread->flags &= ~flags;
+    sim_lock_release();
+    return result;
+}
+
+typedef struct {
+    FuriThread* thread;
+    uint32_t flags;
+    uint32_t options;
+} SimFlagsWait;
+
+static bool sim_thread_flags_ready(void* context) {
+    SimFlagsWait* wait = context;
+    uint32_t matched = wait->thread->flags & wait->flags;
+    return (wait->options & FuriFlagWaitAll) ? (matched == wait->flags) : (matched != 0);
+}
+
+uint32_t furi_thread_flags_wait(uint32_t flags, uint32_t options, uint32_t timeout) {
+    SimFlagsWait wait = {.thread = sim_thread_current(), .flags = flags, .options = options};
+
+    sim_lock_acquire();
+    uint32_t result = FuriFlagErrorTimeout;
+    if(sim_wait_locked(sim_thread_flags_ready, &wait, sim_deadline_from_ticks(timeout))) {
+        result = wait.thread->flags;
+        if(!(options & FuriFlagNoClear)) wait.thread->flags &= ~flags;
+    }
+    sim_lock_release();
+
+    return result;
+}
+
+/* Timers */
+
+static bool sim_timer_service_changed(void* context) {
+    return *(uint32_t*)context != sim_timer_generation;
+}
+
+static int32_t sim_timer_service(void* context) {
+    UNUSED(context);
+
+    sim_lock_acquire();
+    for(;;) {
+        if(sim_pending) {
+            SimPending* pending = sim_pending;
+            sim_pending = pending->next;
+            sim_lock_release();
+            pending->callback(pending->context, pending->arg);
+            free(pending);
+            sim_lock_acquire();
+            continue;
+        }
+
+        FuriTimer* due = NULL;
+        for(FuriTimer* timer = sim_timers; timer; timer = timer->next) {
+            if(timer->running && (!due || timer->expire_us < due->expire_us)) due = timer;
+        }
+
+        if(due && due->expire_us <= sim_now_us) {
+            SimTimerFire fire = {.deadline_us = due->expire_us, .fire_us = sim_now_us};
+            if(due->type == FuriTimerTypePeriodic) {
+                due->expire_us += (uint64_t)due->period_ticks * SIM_US_PER_MS;
+            } else {
+                due->running = false;
+            }
+
+            FuriTimerCallback callback = due->callback;
+            void* callback_context = due->context;
+            sim_lock_release();
+            callback(callback_context);
+            sim_lock_acquire();
+
+            fire.duration_us = sim_now_us - fire.fire_us;
+            if(sim_timer_fire_callback) {
+                SimTimerFireCallback observer = sim_timer_fire_callback;
+                sim_lock_release();
+                observer(&fire, sim_timer_fire_context);
+                sim_lock_acquire();
+            }
+            continue;
+        }
+
+        uint32_t generation = sim_timer_generation;
+        sim_wait_locked(
+            sim_timer_service_changed, &generation, due ? due->expire_us : UINT64_MAX);
+    }
+
+    return 0;
+}
+
+static void sim_timer_service_ensure(void) {
+    sim_lock_acquire();
+    bool start = !sim_timer_service_started;
+    sim_timer_service_started = true;
+    sim_lock_release();
+
+    if(start) {
+        sim_timer_thread.callback = sim_timer_service;
+        sim_thread_spawn(&sim_timer_thread);
+        pthread_detach(sim_timer_thread.pthread);
+    }
+}
+
+static void sim_timer_changed_locked(void) {
+    sim_timer_generation++;
+    sim_notify_locked();
+}
+
+FuriTimer* furi_timer_alloc(FuriTimerCallback func, FuriTimerType type, void* context) {
+    sim_timer_service_ensure();
+
+    FuriTimer* timer = calloc(1, sizeof(FuriTimer));
+    timer->callback = func;
+    timer->context = context;
+    timer->type = type;
+
+    sim_lock_acquire();
+    timer->next = sim_timers;
+    sim_timers = timer;
+    sim_lock_release();
+
+    return timer;
+}
+
+void furi_timer_free(FuriTimer* instance) {
+    sim_lock_acquire();
+    for(FuriTimer** link = &sim_timers; *link; link = &(*link)->next) {
+        if(*link == instance) {
+            *link = instance->next;
+            break;
+        }
+    }
+    sim_timer_changed_locked();
+    sim_lock_release();
+    free(instance);
+}
+
+FuriStatus furi_timer_start(FuriTimer* instance, uint32_t ticks) {
+    sim_lock_acquire();
+    instance->running = true;
+    instance->period_ticks = ticks;
+    instance->expire_us = sim_now_us + (uint64_t)ticks * SIM_US_PER_MS;
+    sim_timer_changed_locked();
+    sim_lock_release();
+    return FuriStatusOk;
+}
+
+FuriStatus furi_timer_restart(FuriTimer* instance, uint32_t ticks) {
+    return furi_timer_start(instance, ticks);
+}
+
+FuriStatus furi_timer_stop(FuriTimer* instance) {
+    sim_lock_acquire();
+    instance->running = false;
+    sim_timer_changed_locked();
+    sim_lock_release();
+    return FuriStatusOk;
+}
+
+uint32_t furi_timer_is_running(FuriTimer* instance) {
+    sim_lock_acquire();
+    uint32_t running = instance->running;
+    sim_lock_release();
+    return running;
+}
+
+uint32_t furi_timer_get_expire_time(FuriTimer* instance) {
+    sim_lock_acquire();
+    uint32_t expire = (uint32_t)(instance->expire_us / SIM_US_PER_MS);
+    sim_lock_release();
+    return expire;
+}
+
+void furi_timer_pending_callback(FuriTimerPendigCallback callback, void* context, uint32_t arg) {
+    sim_timer_service_ensure();
+
+    SimPending* pending = calloc(1, sizeof(SimPending));
+    pending->callback = callback;
+    pending->context = context;
+    pending->arg = arg;
+
+    sim_lock_acquire();
+    SimPending** link = &sim_pending;
+    while(*link) link = &(*link)->next;
+    *link = pending;
+    sim_timer_changed_locked();
+    sim_lock_release();
+}
+
+/* Message queues */
+
+FuriMessageQueue* furi_message_queue_alloc(uint32_t msg_count, uint32_t msg_size) {
+    FuriMessageQueue* queue = calloc(1, sizeof(FuriMessageQueue));
+    queue->buffer = calloc(msg_count, msg_size);
+    queue->msg_size = msg_size;
+    queue->capacity = msg_count;
+    return queue;
+}
+
+void furi_message_queue_free(FuriMessageQueue* instance) {
+    free(instance->buffer);
+    free(instance);
+}
+
+static bool sim_queue_has_space(void* context) {
+    FuriMessageQueue* queue = context;
+    return queue->count < queue->capacity;
+}
+
+static bool sim_queue_has_data(void* context) {
+    FuriMessageQueue* queue = context;
+    return queue->count > 0;
+}
+
+FuriStatus
+    furi_message_queue_put(FuriMessageQueue* instance, const void* msg_ptr, uint32_t timeout) {
+    sim_lock_acquire();
+    FuriStatus status = FuriStatusErrorTimeout;
+    if(sim_wait_locked(sim_queue_has_space, instance, sim_deadline_from_ticks(timeout))) {
+        uint32_t tail = (instance->head + instance->count) % instance->capacity;
+        memcpy(instance->buffer + tail * instance->msg_size, msg_ptr, instance->msg_size);
+        instance->count++;
+        sim_notify_locked();
+        status = FuriStatusOk;
+    } else if(timeout == 0) {
+        status = FuriStatusErrorResource;
+    }
+    sim_lock_release();
+    return status;
+}
+
+FuriStatus furi_message_queue_get(FuriMessageQueue* instance, void* msg_ptr, uint32_t timeout) {
+    sim_lock_acquire();
+    FuriStatus status = FuriStatusErrorTimeout;
+    if(sim_wait_locked(sim_queue_has_data, instance, sim_deadline_from_ticks(timeout))) {
+        memcpy(msg_ptr, instance->buffer + instance->head * instance->msg_size, instance->msg_size);
+        instance->head = (instance->head + 1) % instance->capacity;
+        instance->count--;
+        sim_notify_locked();
+        status = FuriStatusOk;
+    } else if(timeout == 0) {
+        status = FuriStatusErrorResource;
+    }
+    sim_lock_release();
+    return status;
+}
+
+uint32_t furi_message_queue_get_capacity(FuriMessageQueue* instance) {
+    return instance->capacity;
+}
+
+uint32_t furi_message_queue_get_count(FuriMessageQueue* instance) {
+    sim_lock_acquire();
+    uint32_t count = instance->count;
+    sim_lock_release();
+    return count;
+}
+
+uint32_t furi_message_queue_get_space(FuriMessageQueue* instance) {
+    return instance->capacity - furi_message_queue_get_count(instance);
+}
+
+FuriStatus furi_message_queue_reset(FuriMessageQueue* instance) {
+    sim_lock_acquire();
+    instance->head = 0;
+    instance->count = 0;
+    sim_notify_locked();
+    sim_lock_release();
+    return FuriStatusOk;
+}
+
+/* Mutexes */
+
+FuriMutex* furi_mutex_alloc(FuriMutexType type) {
+    FuriMutex* mutex = calloc(1, sizeof(FuriMutex));
+    mutex->type = type;
+    return mutex;
+}
+
+void furi_mutex_free(FuriMutex* instance) {
+    furi_check(instance->owner == NULL);
+    free(instance);
+}
+
+static bool sim_mutex_available(void* context) {
+    FuriMutex* mutex = context;
+    return mutex->owner == NULL ||
+           (mutex->type == FuriMutexTypeRecursive && mutex->owner == sim_thread_current());
+}
+
+FuriStatus furi_mutex_acquire(FuriMutex* instance, uint32_t timeout) {
+    sim_lock_acquire();
+    FuriStatus status = FuriStatusErrorTimeout;
+    if(sim_wait_locked(sim_mutex_available, instance, sim_deadline_from_ticks(timeout))) {
+        instance->owner = sim_thread_current();
+        instance->depth++;
+        status = FuriStatusOk;
+    }
+    sim_lock_release();
+    return status;
+}
+
+FuriStatus furi_mutex_release(FuriMutex* instance) {
+    sim_lock_acquire();
+    furi_check(instance->owner == sim_thread_current());
+    if(--instance->depth == 0) {
+        instance->owner = NULL;
+        sim_notify_locked();
+    }
+    sim_lock_release();
+    return FuriStatusOk;
+}
+
+FuriThreadId furi_mutex_get_owner(FuriMutex* instance) {
+    return instance->owner;
+}
+
+/* Records */
+
+static uint8_t sim_record_storage;
+
+void* furi_record_open(const char* name) {
+    if(strcmp(name, "gui") == 0) return sim_gui_instance();
+    return &sim_record_storage;
+}
+
+void furi_record_close(const char* name) {
+    UNUSED(name);
+}
@@ -0,0 +1,231 @@
+#include <furi.h>
+#include <storage/storage.h>
+
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef enum {
+    FileOpNone,
+    FileOpRead,
+    FileOpWrite,
+} FileOp;
+
+struct File {
+    FILE* handle;
+    FileOp last_op;
+};
+
+/* stdio requires a seek between switching from reading to writing and back. */
+static void storage_file_switch(File* file, FileOp op) {
+    if(file->last_op != op && file->last_op != FileOpNone) fseek(file->handle, 0, SEEK_CUR);
+    file->last_op = op;
+}
+
+const char* storage_host_path(const char* path, char* buffer, size_t buffer_size) {
+    static const char* const device_roots[] = {"/ext/", "/int/", "/any/", "/data/"};
+
+    for(size_t i = 0; i < COUNT_OF(device_roots); ++i) {
+        if(strncmp(path, device_roots[i], strlen(device_roots[i])) == 0) {
+            const char* root = getenv("SIM_STORAGE_ROOT");
+            snprintf(buffer, buffer_size, "%s%s", root ? root : ".", path);
+            return buffer;
+        }
+    }
+
+    snprintf(buffer, buffer_size, "%s", path);
+    return buffer;
+}
+
+static void storage_make_parents(const char* host_path) {
+    char buffer[512];
+    snprintf(buffer, sizeof(buffer), "%s", host_path);
+    for(char* slash = strchr(buffer + 1, '/'); slash; slash = strchr(slash + 1, '/')) {
+        *slash = '\0';
+        mkdir(buffer, 0777);
+        *slash = '/';
+    }
+}
+
+File* storage_file_alloc(Storage* storage) {
+    UNUSED(storage);
+    return calloc(1, sizeof(File));
+}
+
+void storage_file_free(File* file) {
+    if(file->handle) fclose(file->handle);
+    free(file);
+}
+
+bool storage_file_open(
+    File* file,
+    const char* path,
+    FS_AccessMode access_mode,
+    FS_OpenMode open_mode) {
+    char host_path[512];
+    storage_host_path(path, host_path, sizeof(host_path));
+
+    bool exists = access(host_path, F_OK) == 0;
+    const char* mode = NULL;
+
+    switch(open_mode) {
+    case FSOM_OPEN_EXISTING:
+        if(!exists) return false;
+        mode = (access_mode & FSAM_WRITE) ? "r+b" : "rb";
+        break;
+    case FSOM_OPEN_ALWAYS:
+        mode = exists ? ((access_mode & FSAM_WRITE) ? "r+b" : "rb") : "w+b";
+        break;
+    case FSOM_OPEN_APPEND:
+        mode = "a+b";
+        break;
+    case FSOM_CREATE_NEW:
+        if(exists) return false;
+        mode = "w+b";
+        break;
+    case FSOM_CREATE_ALWAYS:
+        mode = "w+b";
+        break;
+    }
+
+    if(!exists) storage_make_parents(host_path);
+    file->handle = fopen(host_path, mode);
+    file->last_op = FileOpNone;
+    return file->handle != NULL;
+}
+
+bool storage_file_close(File* file) {
+    if(!file->handle) return false;
+    fclose(file->handle);
+    file->handle = NULL;
+    return true;
+}
+
+bool storage_file_is_open(File* file) {
+    return file->handle != NULL;
+}
+
+size_t storage_file_read(File* file, void* buff, size_t bytes_to_read) {
+    storage_file_switch(file, FileOpRead);
+    return fread(buff, 1, bytes_to_read, file->handle);
+}
+
+size_t storage_file_write(File* file, const void* buff, size_t bytes_to_write) {
+    storage_file_switch(file, FileOpWrite);
+    return fwrite(buff, 1, bytes_to_write, file->handle);
+}
+
+bool storage_file_seek(File* file, uint32_t offset, bool from_start) {
+    file->last_op = FileOpNone;
+    return fseek(file->handle, (long)offset, from_start ? SEEK_SET : SEEK_CUR) == 0;
+}
+
+uint64_t storage_file_tell(File* file) {
+    return (uint64_t)ftell(file->handle);
+}
+
+uint64_t storage_file_size(File* file) {
+    long position = ftell(file->handle);
+    fseek(file->handle, 0, SEEK_END);
+    long size = ftell(file->handle);
+    fseek(file->handle, position, SEEK_SET);
+    file->last_op = FileOpNone;
+    return (uint64_t)size;
+}
+
+bool storage_file_truncate(File* file) {
+    fflush(file->handle);
+    return ftruncate(fileno(file->handle), ftell(file->handle)) == 0;
+}
+
+bool storage_file_sync(File* file) {
+    return fflush(file->handle) == 0 && fsync(fileno(file->handle)) == 0;
+}
+
+bool storage_file_eof(File* file) {
+    long position = ftell(file->handle);
+    return (uint64_t)position >= storage_file_size(file);
+}
+
+bool storage_file_exists(Storage* storage, const char* path) {
+    FileInfo info;
+    return storage_common_stat(storage, path, &info) == FSE_OK &&
+           !(info.flags & FSF_DIRECTORY);
+}
+
+static FS_Error storage_error_from_errno(void) {
+    switch(errno) {
+    case ENOENT:
+        return FSE_NOT_EXIST;
+    case EEXIST:
+        return FSE_EXIST;
+    case EACCES:
+        return FSE_DENIED;
+    default:
+        return FSE_INTERNAL;
+    }
+}
+
+FS_Error storage_common_stat(Storage* storage, const char* path, FileInfo* fileinfo) {
+    UNUSED(storage);
+    char host_path[512];
+    struct stat st;
+    if(stat(storage_host_path(path, host_path, sizeof(host_path)), &st) != 0) {
+        return storage_error_from_errno();
+    }
+    if(fileinfo) {
+        fileinfo->flags = S_ISDIR(st.st_mode) ? FSF_DIRECTORY : 0;
+        fileinfo->size = (uint64_t)st.st_size;
+    }
+    return FSE_OK;
+}
+
+FS_Error storage_common_timestamp(Storage* storage, const char* path, uint32_t* timestamp) {
+    UNUSED(storage);
+    char host_path[512];
+    struct stat st;
+    if(stat(storage_host_path(path, host_path, sizeof(host_path)), &st) != 0) {
+        return storage_error_from_errno();
+    }
+    *timestamp = (uint32_t)st.st_mtime;
+    return FSE_OK;
+}
+
+FS_Error storage_common_remove(Storage* storage, const char* path) {
+    UNUSED(storage);
+    char host_path[512];
+    return remove(storage_host_path(path, host_path, sizeof(host_path))) == 0 ?
+               FSE_OK :
+               storage_error_from_errno();
+}
+
+FS_Error storage_common_rename(Storage* storage, const char* old_path, const char* new_path) {
+    UNUSED(storage);
+    char old_host_path[512];
+    char new_host_path[512];
+    storage_host_path(old_path, old_host_path, sizeof(old_host_path));
+    storage_host_path(new_path, new_host_path, sizeof(new_host_path));
+
+    // Like the device, refuse to replace an existing file.
+    if(access(new_host_path, F_OK) == 0) return FSE_EXIST;
+    return rename(old_host_path, new_host_path) == 0 ? FSE_OK : storage_error_from_errno();
+}
+
+FS_Error storage_common_mkdir(Storage* storage, const char* path) {
+    UNUSED(storage);
+    char host_path[512];
+    storage_host_path(path, host_path, sizeof(host_path));
+    storage_make_parents(host_path);
+    if(mkdir(host_path, 0777) != 0) return storage_error_from_errno();
+    return FSE_OK;
+}
+
+bool storage_simply_remove(Storage* storage, const char* path) {
+    FS_Error error = storage_common_remove(storage, path);
+    return error == FSE_OK || error == FSE_NOT_EXIST;
+}
+
+bool storage_simply_mkdir(Storage* storage, const char* path) {
+    FS_Error error = storage_common_mkdir(storage, path);
+    return error == FSE_OK || error == FSE_EXIST;
+}
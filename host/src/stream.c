@@ -0,0 +1,107 @@
+#include <furi.h>
+#include <toolbox/stream/stream.h>
+
+#include "stream_i.h"
+
+struct Stream {
+    File* file;
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+    size_t position;
+};
+
+Stream* stream_file_alloc(Storage* storage) {
+    Stream* stream = calloc(1, sizeof(Stream));
+    stream->file = storage_file_alloc(storage);
+    return stream;
+}
+
+Stream* stream_string_alloc(void) {
+    return calloc(1, sizeof(Stream));
+}
+
+void stream_free(Stream* stream) {
+    if(stream->file) storage_file_free(stream->file);
+    free(stream->data);
+    free(stream);
+}
+
+File* stream_get_file(Stream* stream) {
+    return stream->file;
+}
+
+bool stream_eof(Stream* stream) {
+    return stream_tell(stream) >= stream_size(stream);
+}
+
+void stream_clean(Stream* stream) {
+    if(stream->file) {
+        storage_file_seek(stream->file, 0, true);
+        storage_file_truncate(stream->file);
+    } else {
+        stream->size = 0;
+        stream->position = 0;
+    }
+}
+
+bool stream_seek(Stream* stream, int32_t offset, StreamOffset offset_type) {
+    size_t size = stream_size(stream);
+    int64_t base = 0;
+    if(offset_type == StreamOffsetFromCurrent) base = (int64_t)stream_tell(stream);
+    if(offset_type == StreamOffsetFromEnd) base = (int64_t)size;
+
+    int64_t target = base + offset;
+    bool result = true;
+    if(target < 0) {
+        target = 0;
+        result = false;
+    } else if(target > (int64_t)size) {
+        target = (int64_t)size;
+        result = false;
+    }
+
+    if(stream->file) {
+        storage_file_seek(stream->file, (uint32_t)target, true);
+    } else {
+        stream->position = (size_t)target;
+    }
+    return result;
+}
+
+size_t stream_tell(Stream* stream) {
+    return stream->file ? (size_t)storage_file_tell(stream->file) : stream->position;
+}
+
+size_t stream_size(Stream* stream) {
+    return stream->file ? (size_t)storage_file_size(stream->file) : stream->size;
+}
+
+size_t stream_write(Stream* stream, const uint8_t* data, size_t size) {
+    if(stream->file) return storage_file_write(stream->file, data, size);
+
+    if(stream->position + size > stream->capacity) {
+        size_t capacity = stream->capacity ? stream->capacity : 256;
+        while(capacity < stream->position + size) capacity *= 2;
+        stream->data = realloc(stream->data, capacity);
+        stream->capacity = capacity;
+    }
+    memcpy(stream->data + stream->position, data, size);
+    stream->position += size;
+    if(stream->position > stream->size) stream->size = stream->position;
+    return size;
+}
+
+size_t stream_read(Stream* stream, uint8_t* data, size_t count) {
+    if(stream->file) return storage_file_read(stream->file, data, count);
+
+    size_t available = stream->size - stream->position;
+    if(count > available) count = available;
+    memcpy(data, stream->data + stream->position, count);
+    stream->position += count;
+    return count;
+}
+
+bool stream_rewind(Stream* stream) {
+    return stream_seek(stream, 0, StreamOffsetFromStart);
+}
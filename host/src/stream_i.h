@@ -0,0 +1,9 @@
+#pragma once
+
+#include <storage/storage.h>
+#include <toolbox/stream/stream.h>
+
+Stream* stream_file_alloc(Storage* storage);
+Stream* stream_string_alloc(void);
+void stream_free(Stream* stream);
+File* stream_get_file(Stream* stream);
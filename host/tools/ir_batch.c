@@ -0,0 +1,514 @@
+/*
+ * Validates, and optionally normalizes, infrared signal files in bulk using the
+ * signal library code, on every core of the host.
+ *
+ * Usage: ir_batch [-j threads] [-p] [-w | -o out_dir] [-v] path...
+ *
+ *   -j  number of worker threads, defaults to the number of online CPUs
+ *   -p  promote raw signals that decode to a known protocol (see
+ *       infrared_signal_promote_raw())
+ *   -w  rewrite each valid file in place, in the canonical format, first
+ *       recovering files whose previous rewrite was interrupted
+ *   -o  write the canonical form of each valid file under out_dir instead,
+ *       keeping its path relative to the argument it was found under
+ *   -v  keep the library log output (on stderr)
+ *
+ * Paths may be files or directories, which are searched recursively for .ir
+ * files. Files are spread over per-thread deques: each worker takes files from
+ * the back of its own deque and, once it is empty, steals from the front of the
+ * others', so a few huge files do not hold up the rest of the batch.
+ *
+ * Without -w the files checked are never modified: a file only left as its
+ * .bak backup by an interrupted rewrite is reported as an error instead.
+ *
+ * One line is printed per file, in argument order, followed by throughput
+ * figures. The exit status is 1 if any file failed.
+ */
+#include <furi.h>
+#include <flipper_format/flipper_format.h>
+
+#include <dirent.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "infrared_library_writer.h"
+#include "infrared_signal.h"
+
+#define IR_BATCH_FILE_TYPE "IR signals file"
+#define IR_BATCH_FILE_VERSION (1)
+#define IR_BATCH_EXTENSION ".ir"
+
+#define IR_BATCH_MAX_THREADS (256U)
+#define IR_BATCH_PATH_SIZE (512U)
+#define IR_BATCH_ERROR_SIZE (160U)
+
+typedef struct {
+    bool promote;
+    bool rewrite;
+    const char* output_dir;
+} IrBatchOptions;
+
+typedef struct {
+    char path[IR_BATCH_PATH_SIZE];
+    size_t root_length; /**< Length of the argument prefix, stripped from output paths. */
+    bool success;
+    uint64_t bytes;
+    size_t signals;
+    size_t raw;
+    size_t promoted;
+    char error[IR_BATCH_ERROR_SIZE];
+} IrBatchFile;
+
+typedef struct {
+    IrBatchFile* items;
+    size_t count;
+    size_t capacity;
+} IrBatchFileList;
+
+/* Work-stealing deques of file indices */
+
+typedef struct {
+    pthread_mutex_t mutex;
+    size_t* items;
+    size_t head;
+    size_t tail;
+} IrBatchDeque;
+
+typedef struct IrBatchPool IrBatchPool;
+
+typedef struct {
+    IrBatchPool* pool;
+    size_t index;
+    pthread_t thread;
+    size_t processed;
+    size_t stolen;
+} IrBatchWorker;
+
+struct IrBatchPool {
+    const IrBatchOptions* options;
+    IrBatchFileList* files;
+    Storage* storage;
+    IrBatchDeque* deques;
+    IrBatchWorker* workers;
+    size_t worker_count;
+};
+
+static bool ir_batch_deque_pop_back(IrBatchDeque* deque, size_t* item) {
+    pthread_mutex_lock(&deque->mutex);
+    const bool has_item = deque->head != deque->tail;
+    if(has_item) *item = deque->items[--deque->tail];
+    pthread_mutex_unlock(&deque->mutex);
+    return has_item;
+}
+
+static bool ir_batch_deque_pop_front(IrBatchDeque* deque, size_t* item) {
+    pthread_mutex_lock(&deque->mutex);
+    const bool has_item = deque->head != deque->tail;
+    if(has_item) *item = deque->items[deque->head++];
+    pthread_mutex_unlock(&deque->mutex);
+    return has_item;
+}
+
+/* File discovery */
+
+static bool ir_batch_has_suffix(const char* path, const char* suffix) {
+    const size_t length = strlen(path);
+    const size_t suffix_length = strlen(suffix);
+    return length > suffix_length && strcmp(path + length - suffix_length, suffix) == 0;
+}
+
+static bool ir_batch_has_extension(const char* path) {
+    return ir_batch_has_suffix(path, IR_BATCH_EXTENSION);
+}
+
+static void ir_batch_add_file(IrBatchFileList* list, const char* path, size_t root_length) {
+    if(list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 64;
+        list->items = realloc(list->items, list->capacity * sizeof(IrBatchFile));
+    }
+
+    IrBatchFile* file = &list->items[list->count++];
+    memset(file, 0, sizeof(IrBatchFile));
+    snprintf(file->path, sizeof(file->path), "%s", path);
+    file->root_length = root_length;
+}
+
+static int ir_batch_compare_names(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+// A file whose replacement was interrupted may only be left as its backup until it is recovered.
+static bool ir_batch_has_backup(const char* path) {
+    char backup_path[IR_BATCH_PATH_SIZE + sizeof(INFRARED_LIBRARY_WRITER_BACKUP_SUFFIX)];
+    snprintf(
+        backup_path, sizeof(backup_path), "%s%s", path, INFRARED_LIBRARY_WRITER_BACKUP_SUFFIX);
+
+    struct stat info;
+    return stat(backup_path, &info) == 0 && S_ISREG(info.st_mode);
+}
+
+// Directory entries are visited in name order, so that reports are reproducible. Files only
+// left as their backup are listed too, and recovered or reported when they are processed.
+static bool ir_batch_scan(IrBatchFileList* list, const char* path, size_t root_length) {
+    struct stat info;
+    const bool exists = stat(path, &info) == 0;
+    if(!exists && !ir_batch_has_backup(path)) {
+        fprintf(stderr, "Cannot access %s\n", path);
+        return false;
+    }
+
+    if(!exists || !S_ISDIR(info.st_mode)) {
+        // A file named on the command line keeps its name under the output directory.
+        const char* name = strrchr(path, '/');
+        ir_batch_add_file(list, path, MIN(root_length, name ? (size_t)(name - path) : 0U));
+        return true;
+    }
+
+    DIR* dir = opendir(path);
+    if(!dir) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+
+    char** names = NULL;
+    size_t name_count = 0;
+
+    for(struct dirent* entry = readdir(dir); entry; entry = readdir(dir)) {
+        if(entry->d_name[0] == '.') continue;
+        names = realloc(names, (name_count + 1) * sizeof(char*));
+        names[name_count++] = strdup(entry->d_name);
+    }
+    closedir(dir);
+
+    qsort(names, name_count, sizeof(char*), ir_batch_compare_names);
+
+    bool success = true;
+    for(size_t i = 0; i < name_count; ++i) {
+        char child[IR_BATCH_PATH_SIZE];
+        snprintf(child, sizeof(child), "%s/%s", path, names[i]);
+
+        if(stat(child, &info) == 0 && S_ISDIR(info.st_mode)) {
+            success &= ir_batch_scan(list, child, root_length);
+        } else if(ir_batch_has_extension(child)) {
+            ir_batch_add_file(list, child, root_length);
+        } else if(ir_batch_has_suffix(child, INFRARED_LIBRARY_WRITER_BACKUP_SUFFIX)) {
+            child[strlen(child) - strlen(INFRARED_LIBRARY_WRITER_BACKUP_SUFFIX)] = '\0';
+            if(ir_batch_has_extension(child) && stat(child, &info) != 0) {
+                ir_batch_add_file(list, child, root_length);
+            }
+        }
+
+        free(names[i]);
+    }
+
+    free(names);
+    return success;
+}
+
+/* Processing */
+
+static bool ir_batch_output_path(
+    const IrBatchOptions* options,
+    const IrBatchFile* file,
+    char* buffer,
+    size_t buffer_size) {
+    if(options->rewrite) {
+        snprintf(buffer, buffer_size, "%s", file->path);
+    } else if(options->output_dir) {
+        const char* relative = file->path + file->root_length;
+        while(*relative == '/') ++relative;
+        snprintf(buffer, buffer_size, "%s/%s", options->output_dir, relative);
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+static void ir_batch_process(IrBatchPool* pool, IrBatchFile* file) {
+    const IrBatchOptions* options = pool->options;
+    Storage* storage = pool->storage;
+
+    FlipperFormat* input = flipper_format_buffered_file_alloc(storage);
+    InfraredLibraryWriter* output = NULL;
+    InfraredSignal* signal = infrared_signal_alloc();
+    FuriString* tmp = furi_string_alloc();
+
+    char output_path[IR_BATCH_PATH_SIZE];
+    const bool has_output =
+        ir_batch_output_path(options, file, output_path, sizeof(output_path));
+
+    do {
+        // The file may be one a previous rewrite in place was interrupted on. Only a rewrite
+        // recovers it: the other modes do not write to the files they check.
+        if(options->rewrite) {
+            infrared_library_writer_recover(storage, file->path);
+        } else if(access(file->path, F_OK) != 0 && ir_batch_has_backup(file->path)) {
+            snprintf(
+                file->error,
+                sizeof(file->error),
+                "interrupted rewrite, only the %s file is left (recovered by -w)",
+                INFRARED_LIBRARY_WRITER_BACKUP_SUFFIX);
+            break;
+        }
+
+        struct stat info;
+        if(stat(file->path, &info) == 0) file->bytes = info.st_size;
+
+        uint32_t version;
+        if(!flipper_format_buffered_file_open_existing(input, file->path)) {
+            snprintf(file->error, sizeof(file->error), "cannot open file");
+            break;
+        }
+        if(!flipper_format_read_header(input, tmp, &version)) {
+            snprintf(file->error, sizeof(file->error), "missing header");
+            break;
+        }
+        if(!furi_string_equal(tmp, IR_BATCH_FILE_TYPE) || version != IR_BATCH_FILE_VERSION) {
+            snprintf(
+                file->error,
+                sizeof(file->error),
+                "unsupported file type '%s' version %lu",
+                furi_string_get_cstr(tmp),
+                version);
+            break;
+        }
+
+        if(has_output) {
+            output = infrared_library_writer_alloc(storage, INFRARED_LIBRARY_WRITER_BUFFER_SIZE);
+            if(!infrared_library_writer_begin(output, output_path)) {
+                snprintf(file->error, sizeof(file->error), "cannot write %s", output_path);
+                break;
+            }
+        }
+
+        file->success = true;
+
+        while(file->success && infrared_signal_read_name(input, tmp)) {
+            const char* name = furi_string_get_cstr(tmp);
+            const size_t index = file->signals++;
+
+            if(!infrared_signal_read_body(signal, input)) {
+                snprintf(
+                    file->error, sizeof(file->error), "signal %zu '%s': cannot parse", index, name);
+                file->success = false;
+            } else if(!infrared_signal_is_valid(signal)) {
+                snprintf(
+                    file->error, sizeof(file->error), "signal %zu '%s': invalid", index, name);
+                file->success = false;
+            } else {
+                if(options->promote && infrared_signal_promote_raw(signal)) {
+                    file->promoted++;
+                } else if(infrared_signal_is_raw(signal)) {
+                    file->raw++;
+                }
+
+                if(output && !infrared_library_writer_add(output, signal, name)) {
+                    snprintf(file->error, sizeof(file->error), "cannot write %s", output_path);
+                    file->success = false;
+                }
+            }
+        }
+    } while(false);
+
+    if(output) {
+        // Files that failed are never written out, not even partially.
+        if(file->success && !infrared_library_writer_commit(output)) {
+            snprintf(file->error, sizeof(file->error), "cannot replace %s", output_path);
+            file->success = false;
+        }
+        infrared_library_writer_free(output);
+    }
+
+    furi_string_free(tmp);
+    infrared_signal_free(signal);
+    flipper_format_free(input);
+}
+
+static void* ir_batch_worker_thread(void* context) {
+    IrBatchWorker* worker = context;
+    IrBatchPool* pool = worker->pool;
+
+    for(;;) {
+        size_t item;
+        bool has_item = ir_batch_deque_pop_back(&pool->deques[worker->index], &item);
+
+        // Own deque empty: steal the oldest work of the next non-empty victim.
+        for(size_t i = 1; i < pool->worker_count && !has_item; ++i) {
+            const size_t victim = (worker->index + i) % pool->worker_count;
+            has_item = ir_batch_deque_pop_front(&pool->deques[victim], &item);
+            if(has_item) worker->stolen++;
+        }
+
+        // No work is ever added once the pool is started: every deque is empty.
+        if(!has_item) break;
+
+        ir_batch_process(pool, &pool->files->items[item]);
+        worker->processed++;
+    }
+
+    return NULL;
+}
+
+static void ir_batch_run(IrBatchPool* pool) {
+    const size_t file_count = pool->files->count;
+
+    pool->deques = malloc(pool->worker_count * sizeof(IrBatchDeque));
+    pool->workers = malloc(pool->worker_count * sizeof(IrBatchWorker));
+
+    for(size_t i = 0; i < pool->worker_count; ++i) {
+        IrBatchDeque* deque = &pool->deques[i];
+        pthread_mutex_init(&deque->mutex, NULL);
+        deque->items = malloc((file_count / pool->worker_count + 1) * sizeof(size_t));
+        deque->head = 0;
+        deque->tail = 0;
+    }
+
+    // Deal the files out in contiguous runs, so that neighbours share directories.
+    for(size_t i = 0; i < file_count; ++i) {
+        IrBatchDeque* deque = &pool->deques[i * pool->worker_count / file_count];
+        deque->items[deque->tail++] = i;
+    }
+
+    for(size_t i = 0; i < pool->worker_count; ++i) {
+        IrBatchWorker* worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i;
+        worker->processed = 0;
+        worker->stolen = 0;
+        pthread_create(&worker->thread, NULL, ir_batch_worker_thread, worker);
+    }
+
+    for(size_t i = 0; i < pool->worker_count; ++i) {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+}
+
+static void ir_batch_pool_free(IrBatchPool* pool) {
+    for(size_t i = 0; i < pool->worker_count; ++i) {
+        pthread_mutex_destroy(&pool->deques[i].mutex);
+        free(pool->deques[i].items);
+    }
+
+    free(pool->deques);
+    free(pool->workers);
+}
+
+static double ir_batch_get_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void ir_batch_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [-j threads] [-p] [-w | -o out_dir] [-v] path...\n", program);
+}
+
+int main(int argc, char** argv) {
+    IrBatchOptions options = {0};
+    size_t worker_count = sysconf(_SC_NPROCESSORS_ONLN);
+    bool is_verbose = false;
+
+    for(int option; (option = getopt(argc, argv, "j:pwo:v")) != -1;) {
+        switch(option) {
+        case 'j':
+            worker_count = strtoul(optarg, NULL, 10);
+            break;
+        case 'p':
+            options.promote = true;
+            break;
+        case 'w':
+            options.rewrite = true;
+            break;
+        case 'o':
+            options.output_dir = optarg;
+            break;
+        case 'v':
+            is_verbose = true;
+            break;
+        default:
+            ir_batch_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if(optind == argc || (options.rewrite && options.output_dir)) {
+        ir_batch_usage(argv[0]);
+        return 2;
+    }
+
+    worker_count = MAX(MIN(worker_count, IR_BATCH_MAX_THREADS), 1U);
+    furi_log_set_level(is_verbose ? FuriLogLevelWarn : FuriLogLevelNone);
+
+    IrBatchFileList files = {0};
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    bool success = true;
+
+    for(int i = optind; i < argc; ++i) {
+        success &= ir_batch_scan(&files, argv[i], strlen(argv[i]));
+    }
+
+    IrBatchPool pool = {
+        .options = &options,
+        .files = &files,
+        .storage = storage,
+        .worker_count = MIN(worker_count, MAX(files.count, 1U)),
+    };
+
+    const double start = ir_batch_get_seconds();
+    ir_batch_run(&pool);
+    const double seconds = ir_batch_get_seconds() - start;
+
+    size_t failed = 0, signals = 0, raw = 0, promoted = 0;
+    uint64_t bytes = 0;
+
+    for(size_t i = 0; i < files.count; ++i) {
+        const IrBatchFile* file = &files.items[i];
+        if(file->success) {
+            printf(
+                "ok     %s (%zu signals, %zu raw, %zu promoted)\n",
+                file->path,
+                file->signals,
+                file->raw,
+                file->promoted);
+        } else {
+            printf("error  %s: %s\n", file->path, file->error);
+            failed++;
+        }
+        signals += file->signals;
+        raw += file->raw;
+        promoted += file->promoted;
+        bytes += file->bytes;
+    }
+
+    size_t stolen = 0;
+    for(size_t i = 0; i < pool.worker_count; ++i) {
+        stolen += pool.workers[i].stolen;
+    }
+
+    printf(
+        "\n%zu files, %zu failed, %zu signals (%zu raw, %zu promoted), %.1f MB in %.3f s on %zu threads\n",
+        files.count,
+        failed,
+        signals,
+        raw,
+        promoted,
+        bytes / 1e6,
+        seconds,
+        pool.worker_count);
+    printf(
+        "%.0f files/s, %.0f signals/s, %.1f MB/s, %zu files stolen\n",
+        files.count / seconds,
+        signals / seconds,
+        bytes / 1e6 / seconds,
+        stolen);
+
+    ir_batch_pool_free(&pool);
+    furi_record_close(RECORD_STORAGE);
+    free(files.items);
+
+    return success && failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+/*
+ * Builds infrared_signal.hpp as C++ and checks the ownership rules of
+ * infrared::Signal: moves leave the source empty, a move assignment deletes the
+ * instance it replaces and copies are equal to their source.
+ *
+ * Usage: signal_cpp_check
+ *
+ * The exit status is 1 if any check failed.
+ */
+#include "infrared_signal.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+static bool check_success = true;
+
+#define CHECK(condition)                                                                \
+    do {                                                                                \
+        if(!(condition)) {                                                              \
+            std::fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__, #condition); \
+            check_success = false;                                                      \
+        }                                                                               \
+    } while(false)
+
+static void check_moves(void) {
+    const InfraredMessage first_message = {InfraredProtocolNEC, 0x01, 0x02, false};
+    const InfraredMessage second_message = {InfraredProtocolNEC, 0x01, 0x03, false};
+
+    infrared::Signal first(first_message);
+    infrared::Signal second(second_message);
+
+    infrared::Signal moved(std::move(first));
+    CHECK(!first);
+    CHECK(moved && moved.message().command == first_message.command);
+
+    // The instance held by moved is deleted, not handed over to second.
+    moved = std::move(second);
+    CHECK(!second);
+    CHECK(moved.message().command == second_message.command);
+
+    infrared::Signal& same = moved;
+    moved = std::move(same);
+    CHECK(moved && moved.message().command == second_message.command);
+
+    const infrared::Signal copy = moved.copy();
+    CHECK(copy == moved);
+
+    InfraredSignal* released = moved.release();
+    CHECK(!moved && released);
+    infrared_signal_free(released);
+}
+
+int main() {
+    check_moves();
+
+    std::printf("%s\n", check_success ? "ok" : "failed");
+    return check_success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,66 @@
+#include "infrared_fanout.h"
+
+#include <furi.h>
+
+#define INFRARED_FANOUT_US_PER_MS (1000ULL)
+
+size_t infrared_fanout_plan(
+    const InfraredFanoutTarget* targets,
+    size_t target_count,
+    InfraredSequenceStep* steps,
+    size_t step_capacity,
+    size_t* step_targets,
+    uint32_t* duration_ms) {
+    size_t step_count = 0;
+    for(size_t i = 0; i < target_count; ++i) {
+        step_count += targets[i].step_count;
+    }
+    if(step_count > step_capacity) return 0;
+
+    // Per target: index of the next step and time from which it may be sent.
+    size_t* next_steps = malloc(target_count * sizeof(size_t));
+    uint64_t* ready_us = malloc(target_count * sizeof(uint64_t));
+    for(size_t i = 0; i < target_count; ++i) {
+        next_steps[i] = 0;
+        ready_us[i] = 0;
+    }
+
+    uint64_t now_us = 0;
+
+    for(size_t count = 0; count < step_count; ++count) {
+        size_t target = target_count;
+        for(size_t i = 0; i < target_count; ++i) {
+            if(next_steps[i] == targets[i].step_count) continue;
+            if(target == target_count || ready_us[i] < ready_us[target]) target = i;
+        }
+
+        // Everyone is waiting: extend the previous delay, the sequencer works in milliseconds.
+        if(ready_us[target] > now_us) {
+            const uint64_t wait_ms =
+                (ready_us[target] - now_us + INFRARED_FANOUT_US_PER_MS - 1) /
+                INFRARED_FANOUT_US_PER_MS;
+            steps[count - 1].delay_ms += wait_ms;
+            now_us += wait_ms * INFRARED_FANOUT_US_PER_MS;
+        }
+
+        const InfraredSequenceStep* step = &targets[target].steps[next_steps[target]++];
+        steps[count].signal = step->signal;
+        steps[count].delay_ms = 0;
+        steps[count].retries = step->retries;
+        steps[count].is_repeatable = step->is_repeatable;
+        if(step_targets) step_targets[count] = target;
+
+        now_us += infrared_signal_get_duration(step->signal);
+        ready_us[target] = now_us + MAX(step->delay_ms, targets[target].gap_ms) *
+                                        INFRARED_FANOUT_US_PER_MS;
+    }
+
+    free(next_steps);
+    free(ready_us);
+
+    if(duration_ms) {
+        *duration_ms = (now_us + INFRARED_FANOUT_US_PER_MS - 1) / INFRARED_FANOUT_US_PER_MS;
+    }
+
+    return step_count;
+}
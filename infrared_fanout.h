@@ -0,0 +1,47 @@
+/**
+ * @file infrared_fanout.h
+ * @brief Interleaved transmission to several devices.
+ *
+ * Sending the same sequence to several devices one after the other wastes the
+ * delays each device needs between frames. The planner merges the sequences of
+ * all devices into one, sending to another device while a device waits out its
+ * gap, and only inserting a delay when every device with frames left is still
+ * waiting. The order of the frames sent to each device is preserved.
+ */
+#pragma once
+
+#include "infrared_sequencer.h"
+
+/**
+ * @brief One device to send a sequence to.
+ */
+typedef struct {
+    const InfraredSequenceStep* steps; /**< Sequence for this device, delays are minimums. */
+    size_t step_count; /**< Number of elements in the steps array. */
+    uint32_t gap_ms; /**< Minimum time between the end of a frame and the start of the next. */
+} InfraredFanoutTarget;
+
+/**
+ * @brief Merge the sequences of several devices into a single sequence.
+ *
+ * Frames are scheduled greedily: the next frame is always the one that can start
+ * the earliest, ties going to the first target. The delay after a frame for a
+ * device is the larger of its step delay and its gap. Delays between frames for
+ * different devices are not required, so they are only inserted to wait for a
+ * device. Frame durations come from infrared_signal_get_duration().
+ *
+ * @param[in] targets pointer to the array of devices.
+ * @param[in] target_count number of elements in the targets array.
+ * @param[out] steps pointer to the array to hold the merged sequence.
+ * @param[in] step_capacity number of elements in the steps array.
+ * @param[out] step_targets pointer to the array of step_capacity elements to hold the target of each step, may be NULL.
+ * @param[out] duration_ms pointer to the variable to hold the planned duration, may be NULL.
+ * @returns number of steps in the merged sequence, 0 if they do not fit.
+ */
+size_t infrared_fanout_plan(
+    const InfraredFanoutTarget* targets,
+    size_t target_count,
+    InfraredSequenceStep* steps,
+    size_t step_capacity,
+    size_t* step_targets,
+    uint32_t* duration_ms);
@@ -0,0 +1,294 @@
+#include "infrared_index.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <core/check.h>
+#include <flipper_format/flipper_format.h>
+
+#include "infrared_signal.h"
+
+#define TAG "InfraredIndex"
+
+#define INFRARED_INDEX_MAGIC (0x58444952UL) // "IRDX"
+#define INFRARED_INDEX_VERSION (1U)
+
+#define INFRARED_INDEX_FNV_OFFSET_BASIS (2166136261UL)
+#define INFRARED_INDEX_FNV_PRIME (16777619UL)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t source_size;
+    uint32_t source_timestamp;
+    uint32_t count;
+} InfraredIndexHeader;
+
+typedef struct {
+    uint32_t hash;
+    uint32_t ordinal;
+} InfraredIndexEntry;
+
+struct InfraredIndex {
+    size_t count;
+    size_t capacity;
+    uint32_t* offsets; /**< Record offsets, by ordinal. */
+    InfraredIndexEntry* entries; /**< Name hashes, sorted by hash then ordinal. */
+};
+
+static uint32_t infrared_index_hash(const char* name) {
+    uint32_t hash = INFRARED_INDEX_FNV_OFFSET_BASIS;
+    for(; *name; ++name) {
+        hash ^= (uint8_t)*name;
+        hash *= INFRARED_INDEX_FNV_PRIME;
+    }
+    return hash;
+}
+
+static int infrared_index_entry_compare(const void* a, const void* b) {
+    const InfraredIndexEntry* lhs = a;
+    const InfraredIndexEntry* rhs = b;
+
+    if(lhs->hash != rhs->hash) return lhs->hash < rhs->hash ? -1 : 1;
+    if(lhs->ordinal != rhs->ordinal) return lhs->ordinal < rhs->ordinal ? -1 : 1;
+    return 0;
+}
+
+static void infrared_index_reset(InfraredIndex* index) {
+    free(index->offsets);
+    free(index->entries);
+    index->offsets = NULL;
+    index->entries = NULL;
+    index->count = 0;
+    index->capacity = 0;
+}
+
+static void infrared_index_reserve(InfraredIndex* index, size_t capacity) {
+    if(capacity <= index->capacity) return;
+
+    index->offsets = realloc(index->offsets, capacity * sizeof(uint32_t));
+    index->entries = realloc(index->entries, capacity * sizeof(InfraredIndexEntry));
+    index->capacity = capacity;
+}
+
+static void infrared_index_push(InfraredIndex* index, uint32_t offset, const char* name) {
+    if(index->count == index->capacity) {
+        infrared_index_reserve(index, index->capacity ? index->capacity * 2 : 16);
+    }
+
+    index->offsets[index->count] = offset;
+    index->entries[index->count].hash = infrared_index_hash(name);
+    index->entries[index->count].ordinal = index->count;
+    index->count++;
+}
+
+static bool infrared_index_build(InfraredIndex* index, Storage* storage, const char* path) {
+    FlipperFormat* ff = flipper_format_buffered_file_alloc(storage);
+    FuriString* tmp = furi_string_alloc();
+    bool success = false;
+
+    infrared_index_reset(index);
+
+    do {
+        uint32_t version;
+        if(!flipper_format_buffered_file_open_existing(ff, path)) break;
+        if(!flipper_format_read_header(ff, tmp, &version)) break;
+
+        Stream* stream = flipper_format_get_raw_stream(ff);
+
+        for(;;) {
+            const size_t offset = stream_tell(stream);
+            if(!infrared_signal_read_name(ff, tmp)) break;
+            infrared_index_push(index, offset, furi_string_get_cstr(tmp));
+        }
+
+        qsort(index->entries, index->count, sizeof(InfraredIndexEntry), infrared_index_entry_compare);
+        success = true;
+    } while(false);
+
+    flipper_format_buffered_file_close(ff);
+    flipper_format_free(ff);
+    furi_string_free(tmp);
+
+    return success;
+}
+
+static bool infrared_index_load(
+    InfraredIndex* index,
+    Storage* storage,
+    const char* index_path,
+    const InfraredIndexHeader* expected) {
+    File* file = storage_file_alloc(storage);
+    bool success = false;
+
+    infrared_index_reset(index);
+
+    do {
+        if(!storage_file_open(file, index_path, FSAM_READ, FSOM_OPEN_EXISTING)) break;
+
+        InfraredIndexHeader header;
+        if(storage_file_read(file, &header, sizeof(header)) != sizeof(header)) break;
+        if(header.magic != expected->magic || header.version != expected->version) break;
+        if(header.source_size != expected->source_size ||
+           header.source_timestamp != expected->source_timestamp) {
+            FURI_LOG_D(TAG, "Stale index: %s", index_path);
+            break;
+        }
+
+        // Every record takes more than a byte of the source file, and the index file holds
+        // exactly what its header says: anything else is corrupt, and is not allocated for.
+        const uint64_t expected_size =
+            sizeof(header) +
+            (uint64_t)header.count * (sizeof(uint32_t) + sizeof(InfraredIndexEntry));
+        if(header.count > header.source_size || storage_file_size(file) != expected_size) {
+            FURI_LOG_W(TAG, "Corrupt index: %s", index_path);
+            break;
+        }
+
+        infrared_index_reserve(index, header.count);
+
+        const size_t offsets_size = header.count * sizeof(uint32_t);
+        const size_t entries_size = header.count * sizeof(InfraredIndexEntry);
+        if(storage_file_read(file, index->offsets, offsets_size) != offsets_size) break;
+        if(storage_file_read(file, index->entries, entries_size) != entries_size) break;
+
+        bool is_valid = true;
+        for(size_t i = 0; i < header.count && is_valid; ++i) {
+            is_valid = index->offsets[i] < header.source_size &&
+                       index->entries[i].ordinal < header.count &&
+                       (i == 0 || infrared_index_entry_compare(
+                                      &index->entries[i - 1], &index->entries[i]) < 0);
+        }
+        if(!is_valid) {
+            FURI_LOG_W(TAG, "Corrupt index: %s", index_path);
+            break;
+        }
+
+        index->count = header.count;
+        success = true;
+    } while(false);
+
+    if(!success) infrared_index_reset(index);
+
+    storage_file_close(file);
+    storage_file_free(file);
+
+    return success;
+}
+
+static bool infrared_index_save(
+    const InfraredIndex* index,
+    Storage* storage,
+    const char* index_path,
+    const InfraredIndexHeader* header) {
+    File* file = storage_file_alloc(storage);
+    bool success = false;
+
+    do {
+        if(!storage_file_open(file, index_path, FSAM_WRITE, FSOM_CREATE_ALWAYS)) break;
+
+        const size_t offsets_size = index->count * sizeof(uint32_t);
+        const size_t entries_size = index->count * sizeof(InfraredIndexEntry);
+        if(storage_file_write(file, header, sizeof(*header)) != sizeof(*header)) break;
+        if(storage_file_write(file, index->offsets, offsets_size) != offsets_size) break;
+        if(storage_file_write(file, index->entries, entries_size) != entries_size) break;
+
+        success = true;
+    } while(false);
+
+    storage_file_close(file);
+    storage_file_free(file);
+
+    if(!success) {
+        storage_common_remove(storage, index_path);
+    }
+
+    return success;
+}
+
+InfraredIndex* infrared_index_alloc(void) {
+    InfraredIndex* index = malloc(sizeof(InfraredIndex));
+
+    index->count = 0;
+    index->capacity = 0;
+    index->offsets = NULL;
+    index->entries = NULL;
+
+    return index;
+}
+
+void infrared_index_free(InfraredIndex* index) {
+    infrared_index_reset(index);
+    free(index);
+}
+
+bool infrared_index_open(InfraredIndex* index, Storage* storage, const char* path) {
+    FuriString* index_path = furi_string_alloc_printf("%s%s", path, INFRARED_INDEX_EXTENSION);
+    bool success = false;
+
+    do {
+        FileInfo info;
+        InfraredIndexHeader header = {
+            .magic = INFRARED_INDEX_MAGIC,
+            .version = INFRARED_INDEX_VERSION,
+        };
+
+        if(storage_common_stat(storage, path, &info) != FSE_OK) break;
+        if(storage_common_timestamp(storage, path, &header.source_timestamp) != FSE_OK) break;
+        header.source_size = info.size;
+
+        if(infrared_index_load(index, storage, furi_string_get_cstr(index_path), &header)) {
+            success = true;
+            break;
+        }
+
+        if(!infrared_index_build(index, storage, path)) break;
+
+        header.count = index->count;
+        if(!infrared_index_save(index, storage, furi_string_get_cstr(index_path), &header)) {
+            FURI_LOG_W(TAG, "Failed to save index: %s", furi_string_get_cstr(index_path));
+        }
+
+        success = true;
+    } while(false);
+
+    furi_string_free(index_path);
+    return success;
+}
+
+size_t infrared_index_get_count(const InfraredIndex* index) {
+    return index->count;
+}
+
+bool infrared_index_get_offset(const InfraredIndex* index, size_t ordinal, size_t* offset) {
+    if(ordinal >= index->count) return false;
+
+    *offset = index->offsets[ordinal];
+    return true;
+}
+
+bool infrared_index_find_name(
+    const InfraredIndex* index,
+    const char* name,
+    size_t* cursor,
+    size_t* ordinal) {
+    const uint32_t hash = infrared_index_hash(name);
+
+    // Lower bound of the hash in the sorted entries.
+    size_t first = 0;
+    size_t last = index->count;
+    while(first < last) {
+        const size_t middle = first + (last - first) / 2;
+        if(index->entries[middle].hash < hash) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+
+    const size_t position = first + *cursor;
+    if(position >= index->count || index->entries[position].hash != hash) return false;
+
+    *ordinal = index->entries[position].ordinal;
+    (*cursor)++;
+    return true;
+}
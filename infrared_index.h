@@ -0,0 +1,92 @@
+/**
+ * @file infrared_index.h
+ * @brief Persistent offset index for infrared signal files.
+ *
+ * An index maps signal names (by hash) and signal ordinals to the byte offset
+ * of the corresponding record in a FlipperFormat infrared file, so that a
+ * signal can be read without scanning every record before it.
+ *
+ * The index is stored next to the signal file as a sidecar (the file path with
+ * INFRARED_INDEX_EXTENSION appended). It records the size and modification time
+ * of the file it was built from and is rebuilt automatically whenever those
+ * no longer match.
+ */
+#pragma once
+
+#include <storage/storage.h>
+
+#define INFRARED_INDEX_EXTENSION ".idx"
+
+/**
+ * @brief InfraredIndex opaque type declaration.
+ */
+typedef struct InfraredIndex InfraredIndex;
+
+/**
+ * @brief Create a new, empty InfraredIndex instance.
+ *
+ * @returns pointer to the instance created.
+ */
+InfraredIndex* infrared_index_alloc(void);
+
+/**
+ * @brief Delete an InfraredIndex instance.
+ *
+ * @param[in,out] index pointer to the instance to be deleted.
+ */
+void infrared_index_free(InfraredIndex* index);
+
+/**
+ * @brief Make an InfraredIndex instance describe a signal file.
+ *
+ * The sidecar index is loaded if it exists, matches the current size and
+ * modification time of the signal file and is consistent: its size, offsets
+ * and order are checked before it is used. Otherwise the signal file is scanned
+ * once and a new sidecar is written (failure to write it is not an error).
+ *
+ * @param[in,out] index pointer to the instance to be filled.
+ * @param[in] storage pointer to the storage record.
+ * @param[in] path pointer to a zero-terminated string containing the signal file path.
+ * @returns true if the index is ready for use, false otherwise (e.g. the file could not be read).
+ */
+bool infrared_index_open(InfraredIndex* index, Storage* storage, const char* path);
+
+/**
+ * @brief Get the number of signals described by an InfraredIndex instance.
+ *
+ * @param[in] index pointer to the instance to be queried.
+ * @returns number of signals in the indexed file.
+ */
+size_t infrared_index_get_count(const InfraredIndex* index);
+
+/**
+ * @brief Get the byte offset of a signal record by its ordinal.
+ *
+ * The offset is the stream position from which infrared_signal_read() will read
+ * the requested signal.
+ *
+ * @param[in] index pointer to the instance to be queried.
+ * @param[in] ordinal zero-based position of the signal in the file.
+ * @param[out] offset pointer to the variable to hold the byte offset.
+ * @returns true if the ordinal is in range, false otherwise.
+ */
+bool infrared_index_get_offset(const InfraredIndex* index, size_t ordinal, size_t* offset);
+
+/**
+ * @brief Find signals whose name hash matches the given name.
+ *
+ * Names are compared by hash only, so the caller must confirm the name after
+ * reading the record. Call repeatedly with the same cursor (initialised to 0)
+ * to iterate over all candidates, in file order.
+ *
+ * @param[in] index pointer to the instance to be queried.
+ * @param[in] name pointer to a zero-terminated string containing the signal name.
+ * @param[in,out] cursor pointer to the iteration state, must be 0 on the first call.
+ * @param[out] ordinal pointer to the variable to hold the candidate ordinal.
+ * @returns true if a candidate was found, false if there are no more candidates.
+ */
+bool infrared_index_find_name(
+    const InfraredIndex* index,
+    const char* name,
+    size_t* cursor,
+    size_t* ordinal);
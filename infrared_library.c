@@ -0,0 +1,623 @@
+#include "infrared_library.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <core/check.h>
+#include <flipper_format/flipper_format.h>
+#include <infrared_worker.h>
+
+#include "infrared_library_writer.h"
+
+#define TAG "InfraredLibrary"
+
+#define INFRARED_LIBRARY_MAGIC (0x424C5249UL) // "IRLB"
+#define INFRARED_LIBRARY_VERSION (1U)
+
+#define INFRARED_LIBRARY_SECTION_BUFFER_SIZE (256U)
+
+// Larger files are refused before anything is allocated for them.
+#define INFRARED_LIBRARY_SIZE_MAX (512UL * 1024UL)
+
+typedef enum {
+    InfraredLibrarySignalTypeParsed = 0,
+    InfraredLibrarySignalTypeRaw = 1,
+} InfraredLibrarySignalType;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t signal_count;
+    uint32_t toc_offset;
+    uint32_t message_count;
+    uint32_t messages_offset;
+    uint32_t raw_count;
+    uint32_t raws_offset;
+    uint32_t timings_count;
+    uint32_t timings_offset;
+    uint32_t names_size;
+    uint32_t names_offset;
+} InfraredLibraryHeader;
+
+typedef struct {
+    uint32_t name_offset; /**< Offset of the name in the names section. */
+    uint32_t type; /**< One of InfraredLibrarySignalType. */
+    uint32_t record; /**< Index into the messages or the raws section, depending on type. */
+} InfraredLibraryTocEntry;
+
+typedef struct {
+    int32_t protocol;
+    uint32_t address;
+    uint32_t command;
+} InfraredLibraryMessage;
+
+typedef struct {
+    uint32_t frequency;
+    float duty_cycle;
+    uint32_t timings_start; /**< Index of the first timing in the timings section. */
+    uint32_t timings_size;
+} InfraredLibraryRaw;
+
+struct InfraredLibrary {
+    const uint8_t* data;
+    size_t size;
+    bool owns_data;
+    const InfraredLibraryHeader* header;
+    const InfraredLibraryTocEntry* toc;
+    const InfraredLibraryMessage* messages;
+    const InfraredLibraryRaw* raws;
+    const uint32_t* timings;
+    const char* names;
+};
+
+static void infrared_library_reset(InfraredLibrary* library) {
+    if(library->owns_data) {
+        free((void*)library->data);
+    }
+
+    memset(library, 0, sizeof(InfraredLibrary));
+}
+
+static bool infrared_library_check_section(
+    const InfraredLibrary* library,
+    uint32_t offset,
+    uint32_t count,
+    size_t element_size) {
+    if(offset % sizeof(uint32_t)) return false;
+    if(offset > library->size) return false;
+    return count <= (library->size - offset) / element_size;
+}
+
+static bool infrared_library_is_value_valid(uint32_t value, uint32_t length) {
+    return length >= 32U || (value >> length) == 0;
+}
+
+// Records are checked as infrared_signal_is_valid() would, since they are handed out unchecked.
+static bool infrared_library_is_message_valid(const InfraredLibraryMessage* record) {
+    const InfraredProtocol protocol = record->protocol;
+
+    return infrared_is_protocol_valid(protocol) &&
+           infrared_library_is_value_valid(
+               record->address, infrared_get_protocol_address_length(protocol)) &&
+           infrared_library_is_value_valid(
+               record->command, infrared_get_protocol_command_length(protocol));
+}
+
+static bool infrared_library_is_raw_valid(
+    const InfraredLibraryRaw* record,
+    const InfraredLibraryHeader* header) {
+    return record->frequency >= INFRARED_MIN_FREQUENCY &&
+           record->frequency <= INFRARED_MAX_FREQUENCY && record->duty_cycle > 0 &&
+           record->duty_cycle <= 1 && record->timings_size > 0 &&
+           record->timings_size <= MAX_TIMINGS_AMOUNT &&
+           record->timings_start <= header->timings_count &&
+           record->timings_size <= header->timings_count - record->timings_start;
+}
+
+static bool infrared_library_validate(const InfraredLibrary* library) {
+    const InfraredLibraryHeader* header = library->header;
+
+    if(header->magic != INFRARED_LIBRARY_MAGIC) {
+        FURI_LOG_E(TAG, "Not a signal library");
+        return false;
+    } else if(header->version != INFRARED_LIBRARY_VERSION) {
+        FURI_LOG_E(TAG, "Unsupported library version: %lu", header->version);
+        return false;
+    }
+
+    if(!infrared_library_check_section(
+           library, header->toc_offset, header->signal_count, sizeof(InfraredLibraryTocEntry)) ||
+       !infrared_library_check_section(
+           library,
+           header->messages_offset,
+           header->message_count,
+           sizeof(InfraredLibraryMessage)) ||
+       !infrared_library_check_section(
+           library, header->raws_offset, header->raw_count, sizeof(InfraredLibraryRaw)) ||
+       !infrared_library_check_section(
+           library, header->timings_offset, header->timings_count, sizeof(uint32_t)) ||
+       !infrared_library_check_section(library, header->names_offset, header->names_size, 1)) {
+        FURI_LOG_E(TAG, "Library section out of bounds");
+        return false;
+    }
+
+    // Names must be terminated so that they can be handed out as C strings.
+    if(header->names_size == 0 ||
+       library->data[header->names_offset + header->names_size - 1] != '\0') {
+        FURI_LOG_E(TAG, "Malformed name table");
+        return false;
+    }
+
+    for(uint32_t i = 0; i < header->signal_count; ++i) {
+        const InfraredLibraryTocEntry* entry =
+            (const InfraredLibraryTocEntry*)(library->data + header->toc_offset) + i;
+
+        bool is_valid;
+
+        if(entry->name_offset >= header->names_size) {
+            is_valid = false;
+        } else if(entry->type == InfraredLibrarySignalTypeParsed) {
+            is_valid = entry->record < header->message_count &&
+                       infrared_library_is_message_valid(
+                           (const InfraredLibraryMessage*)(library->data +
+                                                           header->messages_offset) +
+                           entry->record);
+        } else if(entry->type == InfraredLibrarySignalTypeRaw) {
+            is_valid = entry->record < header->raw_count &&
+                       infrared_library_is_raw_valid(
+                           (const InfraredLibraryRaw*)(library->data + header->raws_offset) +
+                               entry->record,
+                           header);
+        } else {
+            is_valid = false;
+        }
+
+        if(!is_valid) {
+            FURI_LOG_E(TAG, "Malformed signal record: %lu", i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool infrared_library_attach(InfraredLibrary* library) {
+    if(library->size < sizeof(InfraredLibraryHeader)) return false;
+    if((uintptr_t)library->data % sizeof(uint32_t)) return false;
+
+    library->header = (const InfraredLibraryHeader*)library->data;
+    if(!infrared_library_validate(library)) return false;
+
+    const InfraredLibraryHeader* header = library->header;
+    library->toc = (const InfraredLibraryTocEntry*)(library->data + header->toc_offset);
+    library->messages = (const InfraredLibraryMessage*)(library->data + header->messages_offset);
+    library->raws = (const InfraredLibraryRaw*)(library->data + header->raws_offset);
+    library->timings = (const uint32_t*)(library->data + header->timings_offset);
+    library->names = (const char*)(library->data + header->names_offset);
+
+    return true;
+}
+
+InfraredLibrary* infrared_library_alloc(void) {
+    InfraredLibrary* library = malloc(sizeof(InfraredLibrary));
+    memset(library, 0, sizeof(InfraredLibrary));
+    return library;
+}
+
+void infrared_library_free(InfraredLibrary* library) {
+    infrared_library_reset(library);
+    free(library);
+}
+
+bool infrared_library_load(InfraredLibrary* library, Storage* storage, const char* path) {
+    infrared_library_reset(library);
+
+    File* file = storage_file_alloc(storage);
+    bool success = false;
+
+    do {
+        if(!storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) break;
+
+        const uint64_t file_size = storage_file_size(file);
+        if(file_size > INFRARED_LIBRARY_SIZE_MAX) {
+            FURI_LOG_E(TAG, "Library too large: %llu bytes", file_size);
+            break;
+        }
+
+        const size_t size = file_size;
+        uint8_t* data = malloc(size);
+
+        library->data = data;
+        library->size = size;
+        library->owns_data = true;
+
+        if(storage_file_read(file, data, size) != size) break;
+        if(!infrared_library_attach(library)) break;
+
+        success = true;
+    } while(false);
+
+    storage_file_close(file);
+    storage_file_free(file);
+
+    if(!success) {
+        FURI_LOG_E(TAG, "Failed to load library: %s", path);
+        infrared_library_reset(library);
+    }
+
+    return success;
+}
+
+bool infrared_library_load_buffer(InfraredLibrary* library, const void* data, size_t size) {
+    infrared_library_reset(library);
+
+    library->data = data;
+    library->size = size;
+    library->owns_data = false;
+
+    if(!infrared_library_attach(library)) {
+        infrared_library_reset(library);
+        return false;
+    }
+
+    return true;
+}
+
+size_t infrared_library_get_count(const InfraredLibrary* library) {
+    return library->header ? library->header->signal_count : 0;
+}
+
+const char* infrared_library_get_name(const InfraredLibrary* library, size_t index) {
+    furi_assert(index < infrared_library_get_count(library));
+    return library->names + library->toc[index].name_offset;
+}
+
+bool infrared_library_find_by_name(
+    const InfraredLibrary* library,
+    const char* name,
+    size_t* index) {
+    const size_t count = infrared_library_get_count(library);
+
+    for(size_t i = 0; i < count; ++i) {
+        if(strcmp(library->names + library->toc[i].name_offset, name) == 0) {
+            *index = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool infrared_library_get_signal(
+    const InfraredLibrary* library,
+    size_t index,
+    InfraredSignal* signal) {
+    if(index >= infrared_library_get_count(library)) return false;
+
+    const InfraredLibraryTocEntry* entry = &library->toc[index];
+
+    if(entry->type == InfraredLibrarySignalTypeRaw) {
+        const InfraredLibraryRaw* raw = &library->raws[entry->record];
+        infrared_signal_borrow_raw_signal(
+            signal,
+            library->timings + raw->timings_start,
+            raw->timings_size,
+            raw->frequency,
+            raw->duty_cycle);
+    } else {
+        const InfraredLibraryMessage* record = &library->messages[entry->record];
+        const InfraredMessage message = {
+            .protocol = record->protocol,
+            .address = record->address,
+            .command = record->command,
+            .repeat = false,
+        };
+        infrared_signal_set_message(signal, &message);
+    }
+
+    return true;
+}
+
+/*
+ * Conversion from text. Each section of the output file is written through a
+ * small buffer of its own, flushed at the section's write position, so the
+ * text file only has to be parsed twice regardless of its size.
+ */
+
+typedef struct {
+    uint32_t position;
+    size_t used;
+    uint8_t buffer[INFRARED_LIBRARY_SECTION_BUFFER_SIZE];
+} InfraredLibrarySection;
+
+typedef enum {
+    InfraredLibrarySectionToc,
+    InfraredLibrarySectionMessages,
+    InfraredLibrarySectionRaws,
+    InfraredLibrarySectionTimings,
+    InfraredLibrarySectionNames,
+    InfraredLibrarySectionCount,
+} InfraredLibrarySectionId;
+
+static bool infrared_library_section_flush(InfraredLibrarySection* section, File* file) {
+    if(section->used == 0) return true;
+
+    if(!storage_file_seek(file, section->position, true)) return false;
+    if(storage_file_write(file, section->buffer, section->used) != section->used) return false;
+
+    section->position += section->used;
+    section->used = 0;
+    return true;
+}
+
+static bool infrared_library_section_write(
+    InfraredLibrarySection* section,
+    File* file,
+    const void* data,
+    size_t size) {
+    const uint8_t* bytes = data;
+
+    while(size > 0) {
+        if(section->used == sizeof(section->buffer)) {
+            if(!infrared_library_section_flush(section, file)) return false;
+        }
+
+        const size_t chunk = MIN(size, sizeof(section->buffer) - section->used);
+        memcpy(section->buffer + section->used, bytes, chunk);
+        section->used += chunk;
+        bytes += chunk;
+        size -= chunk;
+    }
+
+    return true;
+}
+
+static bool infrared_library_open_text(FlipperFormat* ff, const char* path, FuriString* tmp) {
+    uint32_t version;
+    return flipper_format_buffered_file_open_existing(ff, path) &&
+           flipper_format_read_header(ff, tmp, &version);
+}
+
+static inline uint32_t infrared_library_align(uint32_t offset) {
+    return (offset + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+}
+
+static bool infrared_library_measure(
+    Storage* storage,
+    const char* text_path,
+    InfraredLibraryHeader* header) {
+    FlipperFormat* ff = flipper_format_buffered_file_alloc(storage);
+    InfraredSignal* signal = infrared_signal_alloc();
+    FuriString* name = furi_string_alloc();
+    bool success = false;
+
+    memset(header, 0, sizeof(InfraredLibraryHeader));
+
+    if(infrared_library_open_text(ff, text_path, name)) {
+        success = true;
+
+        // A missing name is the end of the file, a body that does not parse is an error.
+        while(infrared_signal_read_name(ff, name)) {
+            if(!infrared_signal_read_body(signal, ff)) {
+                FURI_LOG_E(TAG, "Malformed signal %s", furi_string_get_cstr(name));
+                success = false;
+                break;
+            }
+
+            header->signal_count++;
+            header->names_size += furi_string_size(name) + 1;
+
+            if(infrared_signal_is_raw(signal)) {
+                header->raw_count++;
+                header->timings_count += infrared_signal_get_raw_signal(signal)->timings_size;
+            } else {
+                header->message_count++;
+            }
+        }
+    }
+
+    flipper_format_buffered_file_close(ff);
+    flipper_format_free(ff);
+    infrared_signal_free(signal);
+    furi_string_free(name);
+
+    if(!success) return false;
+
+    header->magic = INFRARED_LIBRARY_MAGIC;
+    header->version = INFRARED_LIBRARY_VERSION;
+    header->toc_offset = sizeof(InfraredLibraryHeader);
+    header->messages_offset =
+        header->toc_offset + header->signal_count * sizeof(InfraredLibraryTocEntry);
+    header->raws_offset =
+        header->messages_offset + header->message_count * sizeof(InfraredLibraryMessage);
+    header->timings_offset = header->raws_offset + header->raw_count * sizeof(InfraredLibraryRaw);
+    header->names_offset = header->timings_offset + header->timings_count * sizeof(uint32_t);
+
+    // Keep an empty library valid: the name table always has a terminator.
+    if(header->names_size == 0) header->names_size = 1;
+
+    return true;
+}
+
+static bool infrared_library_fill(
+    Storage* storage,
+    const char* text_path,
+    const InfraredLibraryHeader* header,
+    File* file) {
+    FlipperFormat* ff = flipper_format_buffered_file_alloc(storage);
+    InfraredSignal* signal = infrared_signal_alloc();
+    FuriString* name = furi_string_alloc();
+    InfraredLibrarySection* sections =
+        malloc(sizeof(InfraredLibrarySection) * InfraredLibrarySectionCount);
+    bool success = false;
+
+    sections[InfraredLibrarySectionToc].position = header->toc_offset;
+    sections[InfraredLibrarySectionMessages].position = header->messages_offset;
+    sections[InfraredLibrarySectionRaws].position = header->raws_offset;
+    sections[InfraredLibrarySectionTimings].position = header->timings_offset;
+    sections[InfraredLibrarySectionNames].position = header->names_offset;
+
+    for(size_t i = 0; i < InfraredLibrarySectionCount; ++i) {
+        sections[i].used = 0;
+    }
+
+    do {
+        if(!infrared_library_open_text(ff, text_path, name)) break;
+
+        InfraredLibraryTocEntry entry = {0};
+        uint32_t signal_count = 0;
+        uint32_t message_count = 0;
+        uint32_t raw_count = 0;
+        uint32_t timings_start = 0;
+        bool write_success = true;
+
+        while(write_success && infrared_signal_read_name(ff, name)) {
+            if(!infrared_signal_read_body(signal, ff)) {
+                write_success = false;
+                break;
+            }
+
+            if(infrared_signal_is_raw(signal)) {
+                const InfraredRawSignal* raw = infrared_signal_get_raw_signal(signal);
+                const InfraredLibraryRaw record = {
+                    .frequency = raw->frequency,
+                    .duty_cycle = raw->duty_cycle,
+                    .timings_start = timings_start,
+                    .timings_size = raw->timings_size,
+                };
+
+                entry.type = InfraredLibrarySignalTypeRaw;
+                entry.record = raw_count++;
+                timings_start += raw->timings_size;
+
+                write_success = infrared_library_section_write(
+                                    &sections[InfraredLibrarySectionRaws],
+                                    file,
+                                    &record,
+                                    sizeof(record)) &&
+                                infrared_library_section_write(
+                                    &sections[InfraredLibrarySectionTimings],
+                                    file,
+                                    raw->timings,
+                                    raw->timings_size * sizeof(uint32_t));
+            } else {
+                const InfraredMessage* message = infrared_signal_get_message(signal);
+                const InfraredLibraryMessage record = {
+                    .protocol = message->protocol,
+                    .address = message->address,
+                    .command = message->command,
+                };
+
+                entry.type = InfraredLibrarySignalTypeParsed;
+                entry.record = message_count++;
+
+                write_success = infrared_library_section_write(
+                    &sections[InfraredLibrarySectionMessages], file, &record, sizeof(record));
+            }
+
+            write_success = write_success &&
+                            infrared_library_section_write(
+                                &sections[InfraredLibrarySectionToc], file, &entry, sizeof(entry)) &&
+                            infrared_library_section_write(
+                                &sections[InfraredLibrarySectionNames],
+                                file,
+                                furi_string_get_cstr(name),
+                                furi_string_size(name) + 1);
+
+            entry.name_offset += furi_string_size(name) + 1;
+            signal_count++;
+        }
+
+        // The file must not have changed between the two passes.
+        if(!write_success || signal_count != header->signal_count) break;
+
+        if(header->signal_count == 0) {
+            const char terminator = '\0';
+            if(!infrared_library_section_write(
+                   &sections[InfraredLibrarySectionNames], file, &terminator, 1)) {
+                break;
+            }
+        }
+
+        bool flush_success = true;
+        for(size_t i = 0; i < InfraredLibrarySectionCount; ++i) {
+            flush_success = flush_success && infrared_library_section_flush(&sections[i], file);
+        }
+
+        success = flush_success;
+    } while(false);
+
+    flipper_format_buffered_file_close(ff);
+    flipper_format_free(ff);
+    infrared_signal_free(signal);
+    furi_string_free(name);
+    free(sections);
+
+    return success;
+}
+
+bool infrared_library_convert_from_text(
+    Storage* storage,
+    const char* text_path,
+    const char* library_path) {
+    InfraredLibraryHeader header;
+    File* file = storage_file_alloc(storage);
+    bool success = false;
+
+    do {
+        if(!infrared_library_measure(storage, text_path, &header)) break;
+        if(!storage_file_open(file, library_path, FSAM_WRITE, FSOM_CREATE_ALWAYS)) break;
+        if(!infrared_library_fill(storage, text_path, &header, file)) break;
+
+        // Pad the end of the name table so that the file size stays aligned.
+        const uint32_t end = header.names_offset + header.names_size;
+        const uint32_t padding = infrared_library_align(end) - end;
+        const uint32_t zero = 0;
+        if(!storage_file_seek(file, end, true)) break;
+        if(storage_file_write(file, &zero, padding) != padding) break;
+
+        if(!storage_file_seek(file, 0, true)) break;
+        if(storage_file_write(file, &header, sizeof(header)) != sizeof(header)) break;
+
+        success = true;
+    } while(false);
+
+    storage_file_close(file);
+    storage_file_free(file);
+
+    if(!success) {
+        FURI_LOG_E(TAG, "Failed to convert %s", text_path);
+        storage_common_remove(storage, library_path);
+    }
+
+    return success;
+}
+
+bool infrared_library_save_text(
+    const InfraredLibrary* library,
+    Storage* storage,
+    const char* text_path) {
+    InfraredLibraryWriter* writer =
+        infrared_library_writer_alloc(storage, INFRARED_LIBRARY_WRITER_BUFFER_SIZE);
+    InfraredSignal* signal = infrared_signal_alloc();
+    bool success = false;
+
+    do {
+        if(!infrared_library_writer_begin(writer, text_path)) break;
+
+        const size_t count = infrared_library_get_count(library);
+        size_t i;
+
+        for(i = 0; i < count; ++i) {
+            if(!infrared_library_get_signal(library, i, signal)) break;
+            if(!infrared_library_writer_add(writer, signal, infrared_library_get_name(library, i)))
+                break;
+        }
+
+        success = (i == count) && infrared_library_writer_commit(writer);
+    } while(false);
+
+    infrared_library_writer_free(writer);
+    infrared_signal_free(signal);
+
+    return success;
+}
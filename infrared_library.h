@@ -0,0 +1,152 @@
+/**
+ * @file infrared_library.h
+ * @brief Compact binary infrared signal library.
+ *
+ * A binary library holds the same information as a text signal file, laid out
+ * so that it can be used directly from memory without any parsing:
+ * - a fixed-size header,
+ * - a table of contents with one fixed-size entry per signal,
+ * - parsed signals packed as fixed-size message records,
+ * - raw signal descriptors, with all raw timings stored contiguously,
+ * - a table of zero-terminated signal names.
+ *
+ * All multi-byte values are little-endian and every section is 4-byte aligned.
+ * A library is either read from a file in one bulk read, or used in place from
+ * a caller-provided buffer (e.g. a memory-mapped file or a table in flash).
+ */
+#pragma once
+
+#include <storage/storage.h>
+
+#include "infrared_signal.h"
+
+#define INFRARED_LIBRARY_EXTENSION ".irb"
+
+/**
+ * @brief InfraredLibrary opaque type declaration.
+ */
+typedef struct InfraredLibrary InfraredLibrary;
+
+/**
+ * @brief Create a new, empty InfraredLibrary instance.
+ *
+ * @returns pointer to the instance created.
+ */
+InfraredLibrary* infrared_library_alloc(void);
+
+/**
+ * @brief Delete an InfraredLibrary instance.
+ *
+ * @param[in,out] library pointer to the instance to be deleted.
+ */
+void infrared_library_free(InfraredLibrary* library);
+
+/**
+ * @brief Load a binary library file into an InfraredLibrary instance.
+ *
+ * The whole file is read into a single buffer owned by the instance, so files
+ * over 512 KiB are refused without being read. Every signal record is checked
+ * as infrared_signal_is_valid() would check it. Any previously loaded library
+ * is released.
+ *
+ * @param[in,out] library pointer to the instance to be loaded into.
+ * @param[in] storage pointer to the storage record.
+ * @param[in] path pointer to a zero-terminated string containing the library file path.
+ * @returns true if the library was successfully loaded, false otherwise.
+ */
+bool infrared_library_load(InfraredLibrary* library, Storage* storage, const char* path);
+
+/**
+ * @brief Use a binary library held in an external buffer.
+ *
+ * The buffer is validated but not copied: it must be 4-byte aligned and must
+ * outlive the instance (or the next load into it). Any previously loaded library
+ * is released.
+ *
+ * @param[in,out] library pointer to the instance to be set up.
+ * @param[in] data pointer to the library contents.
+ * @param[in] size size of the library contents, in bytes.
+ * @returns true if the buffer holds a valid library, false otherwise.
+ */
+bool infrared_library_load_buffer(InfraredLibrary* library, const void* data, size_t size);
+
+/**
+ * @brief Get the number of signals in an InfraredLibrary instance.
+ *
+ * @param[in] library pointer to the instance to be queried.
+ * @returns number of signals in the library.
+ */
+size_t infrared_library_get_count(const InfraredLibrary* library);
+
+/**
+ * @brief Get the name of a signal in an InfraredLibrary instance.
+ *
+ * @param[in] library pointer to the instance to be queried.
+ * @param[in] index index of the signal, must be less than infrared_library_get_count().
+ * @returns pointer to a zero-terminated string held by the library.
+ */
+const char* infrared_library_get_name(const InfraredLibrary* library, size_t index);
+
+/**
+ * @brief Find a signal in an InfraredLibrary instance by name.
+ *
+ * @param[in] library pointer to the instance to be queried.
+ * @param[in] name pointer to a zero-terminated string containing the signal name.
+ * @param[out] index pointer to the variable to hold the signal index.
+ * @returns true if the signal was found, false otherwise.
+ */
+bool infrared_library_find_by_name(
+    const InfraredLibrary* library,
+    const char* name,
+    size_t* index);
+
+/**
+ * @brief Set an InfraredSignal instance to hold a signal from an InfraredLibrary instance.
+ *
+ * No copy is made: raw signals reference the timings held by the library (see
+ * infrared_signal_borrow_raw_signal()), so the signal must not be used after the
+ * library is freed or reloaded.
+ *
+ * @param[in] library pointer to the instance to be queried.
+ * @param[in] index index of the signal, must be less than infrared_library_get_count().
+ * @param[in,out] signal pointer to the instance to be set.
+ * @returns true if the signal was successfully retrieved, false otherwise.
+ */
+bool infrared_library_get_signal(
+    const InfraredLibrary* library,
+    size_t index,
+    InfraredSignal* signal);
+
+/**
+ * @brief Convert a text signal file into a binary library file.
+ *
+ * The text file is read twice: once to size the library sections and once to
+ * fill them. Any existing file at the destination path is overwritten. The
+ * conversion fails on a signal that cannot be parsed rather than stopping there.
+ *
+ * @param[in] storage pointer to the storage record.
+ * @param[in] text_path pointer to a zero-terminated string containing the source file path.
+ * @param[in] library_path pointer to a zero-terminated string containing the destination file path.
+ * @returns true if the conversion succeeded, false otherwise.
+ */
+bool infrared_library_convert_from_text(
+    Storage* storage,
+    const char* text_path,
+    const char* library_path);
+
+/**
+ * @brief Save the contents of an InfraredLibrary instance as a text signal file.
+ *
+ * Signals are written in library order through an InfraredLibraryWriter, so
+ * any existing file at the destination path is only replaced once the new one
+ * is complete.
+ *
+ * @param[in] library pointer to the instance to be saved.
+ * @param[in] storage pointer to the storage record.
+ * @param[in] text_path pointer to a zero-terminated string containing the destination file path.
+ * @returns true if the file was successfully written, false otherwise.
+ */
+bool infrared_library_save_text(
+    const InfraredLibrary* library,
+    Storage* storage,
+    const char* text_path);
@@ -0,0 +1,282 @@
+#include "infrared_library_writer.h"
+
+#include <furi.h>
+
+#define TAG "InfraredLibraryWriter"
+
+#define INFRARED_LIBRARY_WRITER_FILE_TYPE "IR signals file"
+#define INFRARED_LIBRARY_WRITER_FILE_VERSION (1U)
+
+struct InfraredLibraryWriter {
+    Storage* storage;
+    File* file;
+    FuriString* path;
+    FuriString* temp_path;
+    FuriString* backup_path;
+
+    char* buffer;
+    size_t buffer_size;
+    size_t buffer_used;
+
+    bool is_open;
+    bool has_failed; /**< A write failed, the file cannot be committed. */
+
+    size_t signal_count;
+    size_t byte_count;
+    size_t write_count;
+    uint32_t start_tick;
+    uint32_t end_tick;
+};
+
+static bool infrared_library_writer_flush(InfraredLibraryWriter* writer) {
+    if(writer->buffer_used == 0) return true;
+
+    const size_t written = storage_file_write(writer->file, writer->buffer, writer->buffer_used);
+    writer->write_count++;
+
+    if(written != writer->buffer_used) {
+        FURI_LOG_E(TAG, "Write of %zu bytes failed", writer->buffer_used);
+        writer->has_failed = true;
+    }
+
+    writer->buffer_used = 0;
+    return !writer->has_failed;
+}
+
+// Move the temporary file over the destination, keeping the previous file as a backup until it is.
+static bool infrared_library_writer_replace(InfraredLibraryWriter* writer) {
+    Storage* storage = writer->storage;
+    const char* path = furi_string_get_cstr(writer->path);
+    const char* temp_path = furi_string_get_cstr(writer->temp_path);
+    const char* backup_path = furi_string_get_cstr(writer->backup_path);
+
+    const bool has_previous = storage_file_exists(storage, path);
+    bool success = false;
+
+    do {
+        if(has_previous) {
+            if(!storage_simply_remove(storage, backup_path)) break;
+            if(storage_common_rename(storage, path, backup_path) != FSE_OK) break;
+        }
+
+        if(storage_common_rename(storage, temp_path, path) != FSE_OK) {
+            // Put the previous file back where it was.
+            if(has_previous) storage_common_rename(storage, backup_path, path);
+            break;
+        }
+
+        if(has_previous) storage_simply_remove(storage, backup_path);
+        success = true;
+    } while(false);
+
+    return success;
+}
+
+bool infrared_library_writer_recover(Storage* storage, const char* path) {
+    FuriString* temp_path =
+        furi_string_alloc_printf("%s%s", path, INFRARED_LIBRARY_WRITER_TEMP_SUFFIX);
+    FuriString* backup_path =
+        furi_string_alloc_printf("%s%s", path, INFRARED_LIBRARY_WRITER_BACKUP_SUFFIX);
+    const char* temp = furi_string_get_cstr(temp_path);
+    const char* backup = furi_string_get_cstr(backup_path);
+
+    if(!storage_file_exists(storage, path) && storage_file_exists(storage, backup)) {
+        // The previous file was moved aside: the temporary file was complete by then.
+        if(storage_common_rename(storage, temp, path) == FSE_OK) {
+            FURI_LOG_W(TAG, "Completed the interrupted replacement of %s", path);
+        } else if(storage_common_rename(storage, backup, path) == FSE_OK) {
+            FURI_LOG_W(TAG, "Restored %s from its backup", path);
+        }
+    }
+
+    // Whatever is left beside the file is either stale or possibly incomplete.
+    storage_simply_remove(storage, temp);
+    if(storage_file_exists(storage, path)) storage_simply_remove(storage, backup);
+
+    furi_string_free(temp_path);
+    furi_string_free(backup_path);
+
+    return storage_file_exists(storage, path);
+}
+
+InfraredLibraryWriter* infrared_library_writer_alloc(Storage* storage, size_t buffer_size) {
+    furi_check(buffer_size > 0);
+
+    InfraredLibraryWriter* writer = malloc(sizeof(InfraredLibraryWriter));
+
+    writer->storage = storage;
+    writer->file = storage_file_alloc(storage);
+    writer->path = furi_string_alloc();
+    writer->temp_path = furi_string_alloc();
+    writer->backup_path = furi_string_alloc();
+
+    writer->buffer = malloc(buffer_size);
+    writer->buffer_size = buffer_size;
+    writer->buffer_used = 0;
+
+    writer->is_open = false;
+    writer->has_failed = false;
+
+    writer->signal_count = 0;
+    writer->byte_count = 0;
+    writer->write_count = 0;
+    writer->start_tick = 0;
+    writer->end_tick = 0;
+
+    return writer;
+}
+
+void infrared_library_writer_free(InfraredLibraryWriter* writer) {
+    infrared_library_writer_abort(writer);
+
+    storage_file_free(writer->file);
+    furi_string_free(writer->path);
+    furi_string_free(writer->temp_path);
+    furi_string_free(writer->backup_path);
+    free(writer->buffer);
+    free(writer);
+}
+
+bool infrared_library_writer_begin(InfraredLibraryWriter* writer, const char* path) {
+    furi_check(!writer->is_open);
+
+    furi_string_set_str(writer->path, path);
+    furi_string_printf(writer->temp_path, "%s%s", path, INFRARED_LIBRARY_WRITER_TEMP_SUFFIX);
+    furi_string_printf(writer->backup_path, "%s%s", path, INFRARED_LIBRARY_WRITER_BACKUP_SUFFIX);
+
+    writer->buffer_used = 0;
+    writer->has_failed = false;
+    writer->signal_count = 0;
+    writer->byte_count = 0;
+    writer->write_count = 0;
+    writer->start_tick = furi_get_tick();
+    writer->end_tick = writer->start_tick;
+
+    // A backup left by an interrupted commit would otherwise get in the way of the next one.
+    infrared_library_writer_recover(writer->storage, path);
+
+    const char* temp_path = furi_string_get_cstr(writer->temp_path);
+    if(!storage_file_open(writer->file, temp_path, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        FURI_LOG_E(TAG, "Cannot create %s", temp_path);
+        return false;
+    }
+    writer->is_open = true;
+
+    const int length = snprintf(
+        writer->buffer,
+        writer->buffer_size,
+        "Filetype: %s\nVersion: %u\n",
+        INFRARED_LIBRARY_WRITER_FILE_TYPE,
+        INFRARED_LIBRARY_WRITER_FILE_VERSION);
+    furi_check(length > 0 && (size_t)length < writer->buffer_size);
+
+    writer->buffer_used = length;
+    writer->byte_count = length;
+
+    return true;
+}
+
+bool infrared_library_writer_add(
+    InfraredLibraryWriter* writer,
+    const InfraredSignal* signal,
+    const char* name) {
+    furi_check(writer->is_open);
+    if(writer->has_failed) return false;
+
+    size_t free_size = writer->buffer_size - writer->buffer_used;
+    size_t length =
+        infrared_signal_format(signal, name, writer->buffer + writer->buffer_used, free_size);
+
+    // Did not fit: write out what is buffered and format again into the whole buffer.
+    if(length >= free_size) {
+        if(!infrared_library_writer_flush(writer)) return false;
+
+        if(length >= writer->buffer_size) {
+            // The signal is larger than the whole buffer: make room for it for good.
+            FURI_LOG_D(TAG, "Growing the buffer to %zu bytes", length + 1);
+            free(writer->buffer);
+            writer->buffer_size = length + 1;
+            writer->buffer = malloc(writer->buffer_size);
+        }
+
+        free_size = writer->buffer_size;
+        length = infrared_signal_format(signal, name, writer->buffer, free_size);
+        furi_check(length < free_size);
+    }
+
+    writer->buffer_used += length;
+    writer->byte_count += length;
+    writer->signal_count++;
+
+    return true;
+}
+
+bool infrared_library_writer_commit(InfraredLibraryWriter* writer) {
+    furi_check(writer->is_open);
+
+    bool success = false;
+
+    do {
+        if(!infrared_library_writer_flush(writer)) break;
+        // The file must be on storage before it replaces the previous one.
+        if(!storage_file_sync(writer->file)) {
+            FURI_LOG_E(TAG, "Sync failed");
+            break;
+        }
+        if(!storage_file_close(writer->file)) break;
+        writer->is_open = false;
+
+        if(!infrared_library_writer_replace(writer)) {
+            FURI_LOG_E(TAG, "Cannot replace %s", furi_string_get_cstr(writer->path));
+            break;
+        }
+
+        success = true;
+    } while(false);
+
+    writer->end_tick = furi_get_tick();
+
+    if(success) {
+        FURI_LOG_I(
+            TAG,
+            "Wrote %zu signals, %zu bytes in %zu writes, in %lu ms",
+            writer->signal_count,
+            writer->byte_count,
+            writer->write_count,
+            writer->end_tick - writer->start_tick);
+    } else {
+        // The destination is untouched, only the temporary file is left to clean up.
+        if(writer->is_open) storage_file_close(writer->file);
+        writer->is_open = false;
+        storage_simply_remove(writer->storage, furi_string_get_cstr(writer->temp_path));
+    }
+
+    return success;
+}
+
+void infrared_library_writer_abort(InfraredLibraryWriter* writer) {
+    if(!writer->is_open) return;
+
+    storage_file_close(writer->file);
+    storage_simply_remove(writer->storage, furi_string_get_cstr(writer->temp_path));
+
+    writer->is_open = false;
+    writer->buffer_used = 0;
+    writer->end_tick = furi_get_tick();
+}
+
+void infrared_library_writer_get_stats(
+    const InfraredLibraryWriter* writer,
+    InfraredLibraryWriterStats* stats) {
+    const uint32_t end_tick = writer->is_open ? furi_get_tick() : writer->end_tick;
+    const uint32_t duration_ms =
+        (uint64_t)(end_tick - writer->start_tick) * 1000 / furi_kernel_get_tick_frequency();
+
+    stats->signal_count = writer->signal_count;
+    stats->byte_count = writer->byte_count;
+    stats->write_count = writer->write_count;
+    stats->duration_ms = duration_ms;
+    stats->signals_per_second =
+        duration_ms ? (uint64_t)writer->signal_count * 1000 / duration_ms : 0;
+    stats->bytes_per_second = duration_ms ? (uint64_t)writer->byte_count * 1000 / duration_ms : 0;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file infrared_library_writer.h
+ * @brief Buffered writer of whole text signal files.
+ *
+ * Writing a signal file with infrared_signal_save() takes several small
+ * FlipperFormat writes per signal. The writer instead formats signals with
+ * infrared_signal_format() into one large buffer and only writes to storage when
+ * the buffer is full, so that saving a library costs a few large writes.
+ *
+ * The file is written under a temporary name next to the destination, then
+ * synced and renamed over it once complete. As storage does not rename over an
+ * existing file, the previous file is first moved aside with the
+ * INFRARED_LIBRARY_WRITER_BACKUP_SUFFIX suffix and removed once the new one is in
+ * place. If power is lost between the two renames, the destination is missing
+ * until infrared_library_writer_recover() puts the complete temporary file, or
+ * else the backup, in its place. infrared_library_writer_begin() does so for its
+ * destination; readers leave the files alone, and a missing file with a backup
+ * beside it is theirs to report. With that, the destination holds either the
+ * previous contents or the new ones in full once it is written again.
+ */
+#pragma once
+
+#include <storage/storage.h>
+
+#include "infrared_signal.h"
+
+#define INFRARED_LIBRARY_WRITER_TEMP_SUFFIX ".tmp"
+#define INFRARED_LIBRARY_WRITER_BACKUP_SUFFIX ".bak"
+
+// Default write buffer size, large enough for any raw signal.
+#define INFRARED_LIBRARY_WRITER_BUFFER_SIZE (16U * 1024U)
+
+/**
+ * @brief Figures on the file being written, or the last one written.
+ */
+typedef struct {
+    size_t signal_count; /**< Signals added. */
+    size_t byte_count; /**< Bytes of text, header included. */
+    size_t write_count; /**< Writes made to storage. */
+    uint32_t duration_ms; /**< Time from begin to commit, or to now if not committed yet. */
+    uint32_t signals_per_second; /**< 0 if the duration is too short to tell. */
+    uint32_t bytes_per_second; /**< 0 if the duration is too short to tell. */
+} InfraredLibraryWriterStats;
+
+/**
+ * @brief Finish or undo an interrupted replacement of a file.
+ *
+ * If the file is missing but its backup is there, the replacement stopped between
+ * the two renames: the temporary file, complete since it was synced before, is
+ * moved in place, or the backup if there is no temporary file. Any temporary file
+ * or backup left beside an existing file is removed, as is a temporary file
+ * without a backup, which may be incomplete.
+ *
+ * Called by infrared_library_writer_begin() for its destination.
+ *
+ * @param[in] storage pointer to the storage record.
+ * @param[in] path pointer to a zero-terminated string containing the file path.
+ * @returns true if the file exists afterwards, false otherwise.
+ */
+bool infrared_library_writer_recover(Storage* storage, const char* path);
+
+/**
+ * @brief InfraredLibraryWriter opaque type declaration.
+ */
+typedef struct InfraredLibraryWriter InfraredLibraryWriter;
+
+/**
+ * @brief Create a new InfraredLibraryWriter instance.
+ *
+ * @param[in] storage pointer to the storage record.
+ * @param[in] buffer_size size of the write buffer, in bytes, e.g. INFRARED_LIBRARY_WRITER_BUFFER_SIZE.
+ * @returns pointer to the instance created.
+ */
+InfraredLibraryWriter* infrared_library_writer_alloc(Storage* storage, size_t buffer_size);
+
+/**
+ * @brief Delete an InfraredLibraryWriter instance.
+ *
+ * A file still being written is abandoned as by infrared_library_writer_abort().
+ *
+ * @param[in,out] writer pointer to the instance to be deleted.
+ */
+void infrared_library_writer_free(InfraredLibraryWriter* writer);
+
+/**
+ * @brief Start writing a signal file.
+ *
+ * An interrupted replacement of the destination is first recovered (see
+ * infrared_library_writer_recover()). The file header is written first. The
+ * destination is not touched until infrared_library_writer_commit().
+ *
+ * @param[in,out] writer pointer to an instance not writing a file.
+ * @param[in] path pointer to a zero-terminated string containing the destination file path.
+ * @returns true if the temporary file was created, false otherwise.
+ */
+bool infrared_library_writer_begin(InfraredLibraryWriter* writer, const char* path);
+
+/**
+ * @brief Add a signal to the file being written.
+ *
+ * Once adding a signal failed, every later call fails as well and the file
+ * cannot be committed.
+ *
+ * @param[in,out] writer pointer to an instance writing a file.
+ * @param[in] signal pointer to the signal to be added.
+ * @param[in] name pointer to a zero-terminated string containing the signal name.
+ * @returns true if the signal was added, false otherwise.
+ */
+bool infrared_library_writer_add(
+    InfraredLibraryWriter* writer,
+    const InfraredSignal* signal,
+    const char* name);
+
+/**
+ * @brief Finish the file being written and replace the destination with it.
+ *
+ * On failure the destination keeps its previous contents and the temporary
+ * file is removed.
+ *
+ * @param[in,out] writer pointer to an instance writing a file.
+ * @returns true if the destination now holds every signal added, false otherwise.
+ */
+bool infrared_library_writer_commit(InfraredLibraryWriter* writer);
+
+/**
+ * @brief Abandon the file being written, leaving the destination untouched.
+ *
+ * @param[in,out] writer pointer to the instance, which may not be writing a file.
+ */
+void infrared_library_writer_abort(InfraredLibraryWriter* writer);
+
+/**
+ * @brief Get figures on the file being written, or the last one written.
+ *
+ * @param[in] writer pointer to the instance to be queried.
+ * @param[out] stats pointer to the structure to hold the figures.
+ */
+void infrared_library_writer_get_stats(
+    const InfraredLibraryWriter* writer,
+    InfraredLibraryWriterStats* stats);
@@ -0,0 +1,228 @@
+#include "infrared_sequencer.h"
+
+#include <furi.h>
+#include <stdatomic.h>
+
+#define TAG "InfraredSequencer"
+
+// The sequence is advanced from the transmit worker thread, once a step is sent, and from the
+// timer service thread, once its delay has elapsed, while the caller starts and stops it: the
+// mutex guards everything about the sequence in progress.
+struct InfraredSequencer {
+    InfraredTxWorker* tx_worker;
+    FuriMutex* mutex;
+    InfraredTxPriority priority;
+    FuriTimer* timer;
+    InfraredSequenceStep steps[INFRARED_SEQUENCER_MAX_STEPS];
+    size_t step_count;
+    size_t next_step;
+    // Steps submitted as the current request, and the burst they are sent in if there are several.
+    size_t step_run;
+    InfraredTxHandle handle;
+    InfraredSignalBurstItem burst[INFRARED_SEQUENCER_MAX_STEPS];
+    // Steps sent, and heard back if verified.
+    bool is_step_done[INFRARED_SEQUENCER_MAX_STEPS];
+    size_t done_count;
+    atomic_bool is_running;
+    InfraredSequencerCallback callback;
+    void* context;
+};
+
+static void infrared_sequencer_tx_callback(
+    InfraredTxHandle handle,
+    InfraredTxStatus status,
+    void* context);
+
+// Submit the next steps to the transmit worker, with the mutex held.
+// Returns true if the sequence is over, the completion callback is then up to the caller.
+static bool infrared_sequencer_advance(InfraredSequencer* sequencer) {
+    if(sequencer->next_step == sequencer->step_count) return true;
+
+    const InfraredSequenceStep* steps = &sequencer->steps[sequencer->next_step];
+    const size_t step_count = sequencer->step_count - sequencer->next_step;
+
+    // Take in every following step that can go in the same burst as the first.
+    size_t run = 1;
+    while(run < step_count && steps[run - 1].retries == 0 && steps[run].retries == 0 &&
+          steps[run - 1].delay_ms <= INFRARED_SEQUENCER_BURST_DELAY_MAX_MS &&
+          infrared_signal_is_burst_compatible(steps[0].signal, steps[run].signal)) {
+        ++run;
+    }
+    sequencer->step_run = run;
+
+    // The worker calls back without its own lock held, so it waits for this one to be released.
+    if(run == 1) {
+        sequencer->handle = infrared_tx_worker_submit_verified(
+            sequencer->tx_worker,
+            steps[0].signal,
+            sequencer->priority,
+            steps[0].retries,
+            steps[0].is_repeatable,
+            infrared_sequencer_tx_callback,
+            sequencer);
+    } else {
+        for(size_t i = 0; i < run; ++i) {
+            sequencer->burst[i].signal = steps[i].signal;
+            sequencer->burst[i].gap_us = steps[i].delay_ms * 1000;
+        }
+        sequencer->handle = infrared_tx_worker_submit_burst(
+            sequencer->tx_worker,
+            sequencer->burst,
+            run,
+            sequencer->priority,
+            infrared_sequencer_tx_callback,
+            sequencer);
+    }
+
+    if(sequencer->handle == INFRARED_TX_HANDLE_INVALID) {
+        FURI_LOG_E(TAG, "Failed to submit step %zu, sequence aborted", sequencer->next_step);
+        return true;
+    }
+
+    return false;
+}
+
+// Release the mutex, then call the completion callback if the sequence is over.
+static void infrared_sequencer_release(InfraredSequencer* sequencer, bool is_over) {
+    InfraredSequencerCallback callback = NULL;
+    void* context = NULL;
+    InfraredSequenceStatus status = InfraredSequenceStatusIncomplete;
+
+    if(is_over) {
+        atomic_store(&sequencer->is_running, false);
+        callback = sequencer->callback;
+        context = sequencer->context;
+        if(sequencer->done_count == sequencer->step_count) {
+            status = InfraredSequenceStatusDone;
+        }
+    }
+
+    furi_mutex_release(sequencer->mutex);
+
+    if(callback) {
+        callback(status, context);
+    }
+}
+
+// Called from the transmit worker thread once the current steps have been sent.
+static void infrared_sequencer_tx_callback(
+    InfraredTxHandle handle,
+    InfraredTxStatus status,
+    void* context) {
+    InfraredSequencer* sequencer = context;
+    bool is_over = false;
+
+    furi_check(furi_mutex_acquire(sequencer->mutex, FuriWaitForever) == FuriStatusOk);
+
+    // Requests of a sequence that was stopped may still complete.
+    if(atomic_load(&sequencer->is_running) && handle == sequencer->handle) {
+        if(status == InfraredTxStatusDone) {
+            for(size_t i = 0; i < sequencer->step_run; ++i) {
+                sequencer->is_step_done[sequencer->next_step + i] = true;
+            }
+            sequencer->done_count += sequencer->step_run;
+        }
+
+        sequencer->next_step += sequencer->step_run;
+        const uint32_t delay_ms = sequencer->steps[sequencer->next_step - 1].delay_ms;
+        if(delay_ms > 0) {
+            furi_timer_start(sequencer->timer, furi_ms_to_ticks(delay_ms));
+        } else {
+            is_over = infrared_sequencer_advance(sequencer);
+        }
+    }
+
+    infrared_sequencer_release(sequencer, is_over);
+}
+
+static void infrared_sequencer_timer_callback(void* context) {
+    InfraredSequencer* sequencer = context;
+    bool is_over = false;
+
+    furi_check(furi_mutex_acquire(sequencer->mutex, FuriWaitForever) == FuriStatusOk);
+    if(atomic_load(&sequencer->is_running)) {
+        is_over = infrared_sequencer_advance(sequencer);
+    }
+    infrared_sequencer_release(sequencer, is_over);
+}
+
+InfraredSequencer* infrared_sequencer_alloc(InfraredTxWorker* tx_worker) {
+    furi_assert(tx_worker);
+    InfraredSequencer* sequencer = malloc(sizeof(InfraredSequencer));
+
+    sequencer->tx_worker = tx_worker;
+    sequencer->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    sequencer->priority = InfraredTxPriorityScheduled;
+    sequencer->timer =
+        furi_timer_alloc(infrared_sequencer_timer_callback, FuriTimerTypeOnce, sequencer);
+    sequencer->step_count = 0;
+    sequencer->next_step = 0;
+    sequencer->step_run = 0;
+    sequencer->handle = INFRARED_TX_HANDLE_INVALID;
+    memset(sequencer->is_step_done, 0, sizeof(sequencer->is_step_done));
+    sequencer->done_count = 0;
+    atomic_init(&sequencer->is_running, false);
+    sequencer->callback = NULL;
+    sequencer->context = NULL;
+
+    return sequencer;
+}
+
+void infrared_sequencer_free(InfraredSequencer* sequencer) {
+    infrared_sequencer_stop(sequencer);
+    furi_timer_free(sequencer->timer);
+    furi_mutex_free(sequencer->mutex);
+    free(sequencer);
+}
+
+bool infrared_sequencer_start(
+    InfraredSequencer* sequencer,
+    const InfraredSequenceStep* steps,
+    size_t step_count,
+    InfraredTxPriority priority,
+    InfraredSequencerCallback callback,
+    void* context) {
+    furi_assert(step_count <= INFRARED_SEQUENCER_MAX_STEPS);
+
+    furi_check(furi_mutex_acquire(sequencer->mutex, FuriWaitForever) == FuriStatusOk);
+
+    if(atomic_load(&sequencer->is_running)) {
+        furi_mutex_release(sequencer->mutex);
+        FURI_LOG_W(TAG, "Sequence already in progress");
+        return false;
+    }
+
+    memcpy(sequencer->steps, steps, step_count * sizeof(InfraredSequenceStep));
+    sequencer->step_count = step_count;
+    sequencer->next_step = 0;
+    memset(sequencer->is_step_done, 0, sizeof(sequencer->is_step_done));
+    sequencer->done_count = 0;
+    sequencer->priority = priority;
+    sequencer->callback = callback;
+    sequencer->context = context;
+    atomic_store(&sequencer->is_running, true);
+
+    infrared_sequencer_release(sequencer, infrared_sequencer_advance(sequencer));
+    return true;
+}
+
+void infrared_sequencer_stop(InfraredSequencer* sequencer) {
+    furi_check(furi_mutex_acquire(sequencer->mutex, FuriWaitForever) == FuriStatusOk);
+    atomic_store(&sequencer->is_running, false);
+    furi_timer_stop(sequencer->timer);
+    furi_mutex_release(sequencer->mutex);
+}
+
+bool infrared_sequencer_is_running(const InfraredSequencer* sequencer) {
+    return atomic_load(&sequencer->is_running);
+}
+
+bool infrared_sequencer_is_step_done(const InfraredSequencer* sequencer, size_t step) {
+    furi_assert(step < INFRARED_SEQUENCER_MAX_STEPS);
+
+    furi_check(furi_mutex_acquire(sequencer->mutex, FuriWaitForever) == FuriStatusOk);
+    const bool is_done = sequencer->is_step_done[step];
+    furi_mutex_release(sequencer->mutex);
+
+    return is_done;
+}
@@ -0,0 +1,126 @@
+/**
+ * @file infrared_sequencer.h
+ * @brief Non-blocking multi-step infrared transmission.
+ *
+ * A sequence is a list of steps, each made of a signal to transmit and a delay
+ * to wait before the next step. Signals are sent by a transmit worker and the
+ * sequencer waits using a one-shot timer instead of sleeping, so neither the
+ * caller nor the timer service thread is blocked by a sequence.
+ *
+ * Consecutive steps that are not verified, use the same carrier and are at most
+ * INFRARED_SEQUENCER_BURST_DELAY_MAX_MS apart are sent as one burst instead, in
+ * a single hardware session with the delays timed exactly by the transmitter.
+ * Longer delays are waited out with the timer, leaving the transmitter free for
+ * other requests.
+ *
+ * The sequencer may be started, stopped and queried from any thread: its state
+ * is guarded by a mutex, which is released before the completion callback runs.
+ */
+#pragma once
+
+#include "infrared_signal.h"
+#include "infrared_tx_worker.h"
+
+#define INFRARED_SEQUENCER_MAX_STEPS (32U)
+#define INFRARED_SEQUENCER_BURST_DELAY_MAX_MS (500U)
+
+/**
+ * @brief One step of a sequence.
+ */
+typedef struct {
+    const InfraredSignal* signal; /**< Signal to transmit. */
+    uint32_t delay_ms; /**< Delay after the transmission, before the next step. */
+    size_t retries; /**< Times the signal may be sent again until heard back, 0 not to verify it. */
+    bool is_repeatable; /**< Sending the signal twice does the same as once, so it may be sent again. */
+} InfraredSequenceStep;
+
+/**
+ * @brief Sequence completion status.
+ */
+typedef enum {
+    InfraredSequenceStatusDone, /**< Every step was sent, and heard back if verified. */
+    InfraredSequenceStatusIncomplete, /**< Some steps were not heard back, or the sequence was aborted. */
+} InfraredSequenceStatus;
+
+/**
+ * @brief Sequence completion callback type.
+ *
+ * Called from the timer service thread, from the transmit worker thread or, if the
+ * first step cannot be submitted, from infrared_sequencer_start(). When
+ * the status is InfraredSequenceStatusIncomplete, infrared_sequencer_is_step_done()
+ * tells which steps went through.
+ *
+ * @param[in] status how the sequence completed.
+ * @param[in] context pointer to the user-defined context.
+ */
+typedef void (*InfraredSequencerCallback)(InfraredSequenceStatus status, void* context);
+
+/**
+ * @brief InfraredSequencer opaque type declaration.
+ */
+typedef struct InfraredSequencer InfraredSequencer;
+
+/**
+ * @brief Create a new InfraredSequencer instance.
+ *
+ * @param[in] tx_worker pointer to the transmit worker used to send the steps, must outlive the instance.
+ * @returns pointer to the instance created.
+ */
+InfraredSequencer* infrared_sequencer_alloc(InfraredTxWorker* tx_worker);
+
+/**
+ * @brief Delete an InfraredSequencer instance, stopping any sequence in progress.
+ *
+ * @param[in,out] sequencer pointer to the instance to be deleted.
+ */
+void infrared_sequencer_free(InfraredSequencer* sequencer);
+
+/**
+ * @brief Start a sequence.
+ *
+ * The steps are copied, but the signals they point to must stay valid until the
+ * sequence completes or is stopped. Each step is submitted to the transmit worker
+ * once the previous one has been sent and its delay has elapsed. A verified step
+ * that is not heard back does not stop the sequence. If a step cannot be
+ * submitted, the sequence is aborted and the callback is called right away with
+ * InfraredSequenceStatusIncomplete.
+ *
+ * @param[in,out] sequencer pointer to the instance to be started.
+ * @param[in] steps pointer to an array of steps.
+ * @param[in] step_count number of elements in the steps array, at most INFRARED_SEQUENCER_MAX_STEPS.
+ * @param[in] priority priority of the transmit requests.
+ * @param[in] callback pointer to the function called once the last step's delay has elapsed, may be NULL.
+ * @param[in] context pointer to the user-defined context passed to the callback.
+ * @returns true if the sequence was started, false otherwise (e.g. another one is still running).
+ */
+bool infrared_sequencer_start(
+    InfraredSequencer* sequencer,
+    const InfraredSequenceStep* steps,
+    size_t step_count,
+    InfraredTxPriority priority,
+    InfraredSequencerCallback callback,
+    void* context);
+
+/**
+ * @brief Stop the sequence in progress, if any, without calling its completion callback.
+ *
+ * @param[in,out] sequencer pointer to the instance to be stopped.
+ */
+void infrared_sequencer_stop(InfraredSequencer* sequencer);
+
+/**
+ * @brief Test whether a sequence is in progress.
+ *
+ * @param[in] sequencer pointer to the instance to be tested.
+ * @returns true if a sequence is in progress, false otherwise.
+ */
+bool infrared_sequencer_is_running(const InfraredSequencer* sequencer);
+
+/**
+ * @brief Test whether a step of the last sequence went through.
+ *
+ * @param[in] sequencer pointer to the instance to be tested.
+ * @param[in] step index of the step in the array passed to infrared_sequencer_start().
+ * @returns true if the step was sent, and heard back if verified, false otherwise.
+ */
+bool infrared_sequencer_is_step_done(const InfraredSequencer* sequencer, size_t step);
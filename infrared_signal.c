@@ -1,8 +1,10 @@
-#include "infrared_signal.h"
+#include "infrared_signal_i.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <core/check.h>
+#include <furi_hal_infrared.h>
 #include <infrared_worker.h>
 #include <infrared_transmit.h>
 
@@ -26,22 +28,319 @@
 #define INFRARED_SIGNAL_ADDRESS_KEY "address"
 #define INFRARED_SIGNAL_COMMAND_KEY "command"
 
-struct InfraredSignal {
-    bool is_raw;
-    union {
-        InfraredMessage message;
-        InfraredRawSignal raw;
-    } payload;
-};
+// Upper bound on the size of a pre-encoded parsed signal
+#define INFRARED_SIGNAL_ENCODED_MAX_TIMINGS (256U)
+
+// Upper bound on the number of distinct durations in a dictionary-encoded raw signal
+#define INFRARED_RAW_DICTIONARY_MAX_SYMBOLS (256U)
+
+typedef struct {
+    const InfraredPackedTimings* packed;
+    size_t position;
+    size_t index;
+    uint32_t previous[2]; /**< Varint only: last mark and space, by timing index parity. */
+} InfraredPackedReader;
+
+typedef struct {
+    InfraredPackedReader reader;
+    size_t timings_size;
+    bool level;
+} InfraredPackedTransmission;
+
+typedef struct {
+    const uint32_t* timings; /**< Timing array, NULL if the timings are packed. */
+    const InfraredPackedTimings* packed;
+    size_t timings_size;
+    bool start_from_mark;
+    uint32_t* scratch; /**< Timings encoded for the transmission only, freed after it. */
+} InfraredBurstSource;
+
+typedef struct {
+    const InfraredSignalBurstItem* items;
+    InfraredBurstSource* sources;
+    size_t item_count;
+    size_t item; /**< Item whose timings are being sent. */
+    size_t index; /**< Index of the next timing of the current item. */
+    bool level;
+    InfraredPackedReader reader;
+    // Next timing, read ahead so that timings of the same level can be merged.
+    bool has_next;
+    uint32_t next_duration;
+    bool next_level;
+} InfraredBurstTransmission;
+
+static InfraredSharedBuffer* infrared_shared_buffer_alloc(size_t size) {
+    InfraredSharedBuffer* buffer = malloc(sizeof(InfraredSharedBuffer) + size);
+    atomic_init(&buffer->ref_count, 1);
+    buffer->data = buffer + 1;
+    return buffer;
+}
+
+static InfraredSharedBuffer* infrared_shared_buffer_adopt(void* data) {
+    InfraredSharedBuffer* buffer = malloc(sizeof(InfraredSharedBuffer));
+    atomic_init(&buffer->ref_count, 1);
+    buffer->data = data;
+    return buffer;
+}
+
+static inline InfraredSharedBuffer* infrared_shared_buffer_retain(InfraredSharedBuffer* buffer) {
+    if(buffer) atomic_fetch_add_explicit(&buffer->ref_count, 1, memory_order_relaxed);
+    return buffer;
+}
+
+static void infrared_shared_buffer_release(InfraredSharedBuffer* buffer) {
+    if(!buffer || atomic_fetch_sub_explicit(&buffer->ref_count, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    if(buffer->data != buffer + 1) free(buffer->data);
+    free(buffer);
+}
+
+/*
+ * Raw timings alternate between marks and spaces, and marks (resp. spaces) tend to
+ * repeat a handful of durations. Each timing is therefore stored as the difference to
+ * the previous timing of the same level, zigzag encoded so that small negative
+ * differences stay small, as a little-endian base-128 varint. Pass NULL to only
+ * compute the packed size.
+ */
+static size_t
+    infrared_signal_pack_varint(const uint32_t* timings, size_t timings_size, uint8_t* data) {
+    size_t data_size = 0;
+
+    for(size_t i = 0; i < timings_size; ++i) {
+        const uint32_t previous = i >= 2 ? timings[i - 2] : 0;
+        const int32_t delta = (int32_t)(timings[i] - previous);
+        uint32_t value = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+
+        do {
+            const uint8_t byte = value & 0x7F;
+            value >>= 7;
+            if(data) data[data_size] = byte | (value ? 0x80 : 0);
+            ++data_size;
+        } while(value);
+    }
+
+    return data_size;
+}
+
+static inline bool infrared_signal_is_within_tolerance(uint32_t timing, uint32_t reference) {
+    const uint32_t difference = timing > reference ? timing - reference : reference - timing;
+    return (uint64_t)difference * 100 <= (uint64_t)reference * INFRARED_RAW_DICTIONARY_TOLERANCE;
+}
+
+/*
+ * Captured signals use a handful of distinct durations, plus jitter. Timings within
+ * tolerance of each other are clustered, in order of first appearance, and each
+ * cluster is replaced by its mean. The packed data holds the table of means followed
+ * by one symbol per timing, 4 bits wide (low nibble first) if there are at most 16
+ * clusters, 8 bits otherwise. Fails if there are more than 256 clusters.
+ */
+static bool infrared_signal_pack_dictionary(
+    const uint32_t* timings,
+    size_t timings_size,
+    InfraredPackedTimings* packed) {
+    uint64_t* sums = malloc(INFRARED_RAW_DICTIONARY_MAX_SYMBOLS * sizeof(uint64_t));
+    uint32_t* counts = malloc(INFRARED_RAW_DICTIONARY_MAX_SYMBOLS * sizeof(uint32_t));
+    uint32_t* table = malloc(INFRARED_RAW_DICTIONARY_MAX_SYMBOLS * sizeof(uint32_t));
+    size_t symbol_count = 0;
+    bool success = true;
+
+    for(size_t i = 0; i < timings_size && success; ++i) {
+        size_t symbol = 0;
+        while(symbol < symbol_count &&
+              !infrared_signal_is_within_tolerance(timings[i], table[symbol])) {
+            ++symbol;
+        }
+
+        if(symbol == symbol_count) {
+            if(symbol_count == INFRARED_RAW_DICTIONARY_MAX_SYMBOLS) {
+                success = false;
+                break;
+            }
+            sums[symbol] = 0;
+            counts[symbol] = 0;
+            ++symbol_count;
+        }
+
+        sums[symbol] += timings[i];
+        counts[symbol]++;
+        table[symbol] = sums[symbol] / counts[symbol];
+    }
+
+    if(success) {
+        const bool is_nibble = symbol_count <= 16;
+        const size_t table_size = symbol_count * sizeof(uint32_t);
+        const size_t symbols_size = is_nibble ? (timings_size + 1) / 2 : timings_size;
+
+        packed->encoding = InfraredRawStorageDictionary;
+        packed->data_size = table_size + symbols_size;
+        packed->buffer = infrared_shared_buffer_alloc(packed->data_size);
+        packed->data = packed->buffer->data;
+        packed->symbol_count = symbol_count;
+
+        memcpy(packed->data, table, table_size);
+        uint8_t* symbols = packed->data + table_size;
+        memset(symbols, 0, symbols_size);
+
+        // Assign each timing to its nearest mean, which may have moved since it was clustered.
+        for(size_t i = 0; i < timings_size; ++i) {
+            size_t best = 0;
+            uint32_t best_difference = UINT32_MAX;
+            for(size_t symbol = 0; symbol < symbol_count; ++symbol) {
+                const uint32_t difference = timings[i] > table[symbol] ? timings[i] - table[symbol] :
+                                                                         table[symbol] - timings[i];
+                if(difference < best_difference) {
+                    best = symbol;
+                    best_difference = difference;
+                }
+            }
+
+            if(is_nibble) {
+                symbols[i / 2] |= best << ((i & 1) * 4);
+            } else {
+                symbols[i] = best;
+            }
+        }
+    }
+
+    free(sums);
+    free(counts);
+    free(table);
+
+    return success;
+}
+
+static inline void
+    infrared_packed_reader_init(InfraredPackedReader* reader, const InfraredPackedTimings* packed) {
+    reader->packed = packed;
+    reader->position = packed->encoding == InfraredRawStorageDictionary ?
+                           packed->symbol_count * sizeof(uint32_t) :
+                           0;
+    reader->index = 0;
+    reader->previous[0] = 0;
+    reader->previous[1] = 0;
+}
+
+static inline uint32_t infrared_packed_reader_next(InfraredPackedReader* reader) {
+    const InfraredPackedTimings* packed = reader->packed;
+
+    if(packed->encoding == InfraredRawStorageDictionary) {
+        const uint32_t* table = (const uint32_t*)packed->data;
+        const uint8_t* symbols = packed->data + reader->position;
+        const size_t index = reader->index++;
+
+        if(packed->symbol_count <= 16) {
+            return table[(symbols[index / 2] >> ((index & 1) * 4)) & 0x0F];
+        } else {
+            return table[symbols[index]];
+        }
+    }
+
+    uint32_t value = 0;
+
+    for(uint32_t shift = 0;; shift += 7) {
+        const uint8_t byte = packed->data[reader->position++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if(!(byte & 0x80)) break;
+    }
+
+    const uint32_t delta = (value >> 1) ^ (0U - (value & 1));
+    const uint32_t timing = reader->previous[reader->index & 1] + delta;
+
+    reader->previous[reader->index & 1] = timing;
+    reader->index++;
+
+    return timing;
+}
+
+static void infrared_signal_pack_timings(
+    const uint32_t* timings,
+    size_t timings_size,
+    InfraredRawStorage encoding,
+    InfraredPackedTimings* packed) {
+    if(encoding == InfraredRawStorageDictionary &&
+       infrared_signal_pack_dictionary(timings, timings_size, packed)) {
+        return;
+    }
+
+    // Too many distinct durations for a dictionary: fall back to lossless packing.
+    packed->encoding = InfraredRawStorageVarint;
+    packed->data_size = infrared_signal_pack_varint(timings, timings_size, NULL);
+    packed->buffer = infrared_shared_buffer_alloc(packed->data_size);
+    packed->data = packed->buffer->data;
+    packed->symbol_count = 0;
+    infrared_signal_pack_varint(timings, timings_size, packed->data);
+}
+
+static void infrared_signal_unpack_timings(
+    const InfraredPackedTimings* packed,
+    uint32_t* timings,
+    size_t timings_size) {
+    InfraredPackedReader reader;
+    infrared_packed_reader_init(&reader, packed);
+
+    for(size_t i = 0; i < timings_size; ++i) {
+        timings[i] = infrared_packed_reader_next(&reader);
+    }
+}
+
+// Give packed timings an expanded copy, held by the instance until it holds another signal.
+static void infrared_signal_expand_packed(InfraredSignal* signal) {
+    if(!signal->packed.data || signal->payload.raw.timings) return;
+
+    const size_t timings_size = signal->payload.raw.timings_size;
+    signal->timings_buffer = infrared_shared_buffer_alloc(timings_size * sizeof(uint32_t));
+    signal->payload.raw.timings = signal->timings_buffer->data;
+    infrared_signal_unpack_timings(&signal->packed, signal->payload.raw.timings, timings_size);
+}
+
+// Called from the IR transmitter interrupt: must not block nor allocate.
+static FuriHalInfraredTxGetDataState
+    infrared_signal_packed_tx_callback(void* context, uint32_t* duration, bool* level) {
+    InfraredPackedTransmission* transmission = context;
+
+    *duration = infrared_packed_reader_next(&transmission->reader);
+    *level = transmission->level;
+    transmission->level = !transmission->level;
+
+    return transmission->reader.index >= transmission->timings_size ?
+               FuriHalInfraredTxGetDataStateLastDone :
+               FuriHalInfraredTxGetDataStateOk;
+}
+
+static void infrared_signal_clear_packed(InfraredSignal* signal) {
+    infrared_shared_buffer_release(signal->packed.buffer);
+    signal->packed.buffer = NULL;
+    signal->packed.data = NULL;
+    signal->packed.data_size = 0;
+    signal->packed.symbol_count = 0;
+}
 
 static void infrared_signal_clear_timings(InfraredSignal* signal) {
     if(signal->is_raw) {
-        free(signal->payload.raw.timings);
+        infrared_shared_buffer_release(signal->timings_buffer);
+        infrared_signal_clear_packed(signal);
         signal->payload.raw.timings_size = 0;
         signal->payload.raw.timings = NULL;
+        signal->timings_buffer = NULL;
     }
 }
 
+static void infrared_signal_clear_encoded(InfraredSignal* signal) {
+    free(signal->encoded.timings);
+    signal->encoded.timings = NULL;
+    signal->encoded.timings_size = 0;
+}
+
+static bool infrared_signal_is_encoded_for(
+    const InfraredSignal* signal,
+    const InfraredMessage* message) {
+    const InfraredMessage* key = &signal->encoded.message;
+    return signal->encoded.timings && (key->protocol == message->protocol) &&
+           (key->address == message->address) && (key->command == message->command);
+}
+
 static bool infrared_signal_is_message_valid(const InfraredMessage* message) {
     if(!infrared_is_protocol_valid(message->protocol)) {
         FURI_LOG_E(TAG, "Unknown protocol");
@@ -101,6 +400,46 @@ static bool infrared_signal_is_raw_valid(const InfraredRawSignal* raw) {
     return true;
 }
 
+/*
+ * Run raw timings through the protocol decoders. The timings are a clean capture of
+ * a message if they decode to a valid message, every further frame is the same
+ * message or one of its repeats, and the carrier frequency is the protocol's.
+ */
+static bool infrared_signal_decode_timings(
+    const uint32_t* timings,
+    size_t timings_size,
+    uint32_t frequency,
+    InfraredMessage* message) {
+    InfraredDecoderHandler* decoder = infrared_alloc_decoder();
+    bool has_message = false;
+    bool success = true;
+
+    for(size_t i = 0; i <= timings_size && success; ++i) {
+        const InfraredMessage* decoded = i < timings_size ?
+                                             infrared_decode(decoder, !(i & 1), timings[i]) :
+                                             infrared_check_decoder_ready(decoder);
+        if(!decoded) continue;
+
+        if(!has_message) {
+            *message = *decoded;
+            message->repeat = false;
+            has_message = !decoded->repeat;
+            success = has_message;
+        } else if(
+            decoded->protocol != message->protocol || decoded->address != message->address ||
+            decoded->command != message->command) {
+            success = false;
+        }
+    }
+
+    infrared_free_decoder(decoder);
+
+    return success && has_message &&
+           infrared_signal_is_within_tolerance(
+               frequency, infrared_get_protocol_frequency(message->protocol)) &&
+           infrared_signal_is_message_valid(message);
+}
+
 static inline bool
     infrared_signal_save_message(const InfraredMessage* message, FlipperFormat* ff) {
     const char* protocol_name = infrared_get_protocol_name(message->protocol);
@@ -131,7 +470,7 @@ static inline bool infrared_signal_read_message(InfraredSignal* signal, FlipperF
     do {
         if(!flipper_format_read_string(ff, INFRARED_SIGNAL_PROTOCOL_KEY, buf)) break;
 
-        InfraredMessage message;
+        InfraredMessage message = {0};
         message.protocol = infrared_get_protocol_by_name(furi_string_get_cstr(buf));
 
         if(!flipper_format_read_hex(ff, INFRARED_SIGNAL_ADDRESS_KEY, (uint8_t*)&message.address, 4))
@@ -168,8 +507,15 @@ static inline bool infrared_signal_read_raw(InfraredSignal* signal, FlipperForma
             free(timings);
             break;
         }
-        infrared_signal_set_raw_signal(signal, timings, timings_size, frequency, duty_cycle);
-        free(timings);
+
+        InfraredMessage message;
+        if(signal->promotes_raw &&
+           infrared_signal_decode_timings(timings, timings_size, frequency, &message)) {
+            free(timings);
+            infrared_signal_set_message(signal, &message);
+        } else {
+            infrared_signal_adopt_raw_signal(signal, timings, timings_size, frequency, duty_cycle);
+        }
 
         success = true;
     } while(false);
@@ -177,6 +523,47 @@ static inline bool infrared_signal_read_raw(InfraredSignal* signal, FlipperForma
     return success;
 }
 
+static void infrared_signal_set_packed_raw_signal(
+    InfraredSignal* signal,
+    const uint32_t* timings,
+    size_t timings_size,
+    uint32_t frequency,
+    float duty_cycle) {
+    // Pack before clearing: the timings may be the expanded copy held by the instance.
+    InfraredPackedTimings packed;
+    infrared_signal_pack_timings(timings, timings_size, signal->raw_storage, &packed);
+
+    infrared_signal_clear_timings(signal);
+    infrared_signal_clear_encoded(signal);
+
+    signal->is_raw = true;
+
+    signal->payload.raw.timings_size = timings_size;
+    signal->payload.raw.frequency = frequency;
+    signal->payload.raw.duty_cycle = duty_cycle;
+    signal->payload.raw.timings = NULL;
+
+    signal->packed = packed;
+}
+
+// Make an instance hold the same raw signal as another one, sharing its buffers.
+static void infrared_signal_share_raw_signal(
+    InfraredSignal* signal,
+    const InfraredSignal* other,
+    bool shares_packed) {
+    infrared_signal_clear_timings(signal);
+    infrared_signal_clear_encoded(signal);
+
+    signal->is_raw = true;
+    signal->payload.raw = other->payload.raw;
+    signal->timings_buffer = infrared_shared_buffer_retain(other->timings_buffer);
+
+    if(shares_packed) {
+        signal->packed = other->packed;
+        infrared_shared_buffer_retain(signal->packed.buffer);
+    }
+}
+
 bool infrared_signal_read_body(InfraredSignal* signal, FlipperFormat* ff) {
     FuriString* tmp = furi_string_alloc();
 
@@ -205,13 +592,27 @@ InfraredSignal* infrared_signal_alloc(void) {
     InfraredSignal* signal = malloc(sizeof(InfraredSignal));
 
     signal->is_raw = false;
+    signal->promotes_raw = false;
+    signal->raw_storage = InfraredRawStorageFull;
     signal->payload.message.protocol = InfraredProtocolUnknown;
 
+    signal->timings_buffer = NULL;
+
+    signal->packed.encoding = InfraredRawStorageVarint;
+    signal->packed.buffer = NULL;
+    signal->packed.data = NULL;
+    signal->packed.data_size = 0;
+    signal->packed.symbol_count = 0;
+
+    signal->encoded.timings = NULL;
+    signal->encoded.timings_size = 0;
+
     return signal;
 }
 
 void infrared_signal_free(InfraredSignal* signal) {
     infrared_signal_clear_timings(signal);
+    infrared_signal_clear_encoded(signal);
     free(signal);
 }
 
@@ -225,7 +626,24 @@ bool infrared_signal_is_valid(const InfraredSignal* signal) {
 }
 
 void infrared_signal_set_signal(InfraredSignal* signal, const InfraredSignal* other) {
-    if(other->is_raw) {
+    if(signal == other) return;
+
+    if(other->is_raw && other->packed.data) {
+        const InfraredRawSignal* raw = &other->payload.raw;
+        const InfraredPackedTimings* packed = &other->packed;
+
+        if(signal->raw_storage == packed->encoding) {
+            infrared_signal_share_raw_signal(signal, other, true);
+        } else {
+            uint32_t* timings = malloc(raw->timings_size * sizeof(uint32_t));
+            infrared_signal_unpack_timings(packed, timings, raw->timings_size);
+            infrared_signal_adopt_raw_signal(
+                signal, timings, raw->timings_size, raw->frequency, raw->duty_cycle);
+        }
+    } else if(
+        other->is_raw && other->timings_buffer && signal->raw_storage == InfraredRawStorageFull) {
+        infrared_signal_share_raw_signal(signal, other, false);
+    } else if(other->is_raw) {
         const InfraredRawSignal* raw = &other->payload.raw;
         infrared_signal_set_raw_signal(
             signal, raw->timings, raw->timings_size, raw->frequency, raw->duty_cycle);
@@ -235,32 +653,249 @@ void infrared_signal_set_signal(InfraredSignal* signal, const InfraredSignal* ot
     }
 }
 
+static inline uint32_t infrared_signal_next_timing(
+    const InfraredSignal* signal,
+    InfraredPackedReader* reader,
+    size_t index) {
+    return signal->packed.data ? infrared_packed_reader_next(reader) :
+                                 signal->payload.raw.timings[index];
+}
+
+bool infrared_signal_equals(const InfraredSignal* signal, const InfraredSignal* other) {
+    if(signal->is_raw != other->is_raw) return false;
+
+    if(!signal->is_raw) {
+        const InfraredMessage* message = &signal->payload.message;
+        const InfraredMessage* other_message = &other->payload.message;
+        return message->protocol == other_message->protocol &&
+               message->address == other_message->address &&
+               message->command == other_message->command;
+    }
+
+    const InfraredRawSignal* raw = &signal->payload.raw;
+    const InfraredRawSignal* other_raw = &other->payload.raw;
+
+    if(raw->frequency != other_raw->frequency || raw->duty_cycle != other_raw->duty_cycle ||
+       raw->timings_size != other_raw->timings_size) {
+        return false;
+    }
+
+    const InfraredPackedTimings* packed = &signal->packed;
+    const InfraredPackedTimings* other_packed = &other->packed;
+
+    // Same durations in the same order: the indices match byte for byte.
+    if(packed->data && other_packed->data && packed->encoding == InfraredRawStorageDictionary &&
+       other_packed->encoding == InfraredRawStorageDictionary &&
+       packed->symbol_count == other_packed->symbol_count) {
+        const uint32_t* table = (const uint32_t*)packed->data;
+        const uint32_t* other_table = (const uint32_t*)other_packed->data;
+        const size_t table_size = packed->symbol_count * sizeof(uint32_t);
+
+        size_t symbol = 0;
+        while(symbol < packed->symbol_count &&
+              infrared_signal_is_within_tolerance(table[symbol], other_table[symbol])) {
+            ++symbol;
+        }
+
+        if(symbol == packed->symbol_count &&
+           memcmp(packed->data + table_size,
+                  other_packed->data + table_size,
+                  packed->data_size - table_size) == 0) {
+            return true;
+        }
+    }
+
+    InfraredPackedReader reader = {0}, other_reader = {0};
+    if(packed->data) infrared_packed_reader_init(&reader, packed);
+    if(other_packed->data) infrared_packed_reader_init(&other_reader, other_packed);
+
+    for(size_t i = 0; i < raw->timings_size; ++i) {
+        const uint32_t timing = infrared_signal_next_timing(signal, &reader, i);
+        const uint32_t other_timing = infrared_signal_next_timing(other, &other_reader, i);
+        if(!infrared_signal_is_within_tolerance(timing, other_timing)) return false;
+    }
+
+    return true;
+}
+
+bool infrared_signal_matches(
+    const InfraredSignal* signal,
+    const InfraredMessage* message,
+    const uint32_t* timings,
+    size_t timings_size) {
+    if(!signal->is_raw) {
+        const InfraredMessage* expected = &signal->payload.message;
+        return message && message->protocol == expected->protocol &&
+               message->address == expected->address && message->command == expected->command;
+    }
+
+    const InfraredRawSignal* raw = &signal->payload.raw;
+    if(timings_size < raw->timings_size) return false;
+
+    InfraredPackedReader reader = {0};
+    if(signal->packed.data) infrared_packed_reader_init(&reader, &signal->packed);
+
+    for(size_t i = 0; i < raw->timings_size; ++i) {
+        const uint32_t timing = infrared_signal_next_timing(signal, &reader, i);
+        if(!infrared_signal_is_within_tolerance(timings[i], timing)) return false;
+    }
+
+    return true;
+}
+
 void infrared_signal_set_raw_signal(
+    InfraredSignal* signal,
+    const uint32_t* timings,
+    size_t timings_size,
+    uint32_t frequency,
+    float duty_cycle) {
+    if(signal->raw_storage != InfraredRawStorageFull) {
+        infrared_signal_set_packed_raw_signal(
+            signal, timings, timings_size, frequency, duty_cycle);
+        return;
+    }
+
+    // Copy before clearing: the timings may be the ones held by the instance.
+    InfraredSharedBuffer* buffer = infrared_shared_buffer_alloc(timings_size * sizeof(uint32_t));
+    memcpy(buffer->data, timings, timings_size * sizeof(uint32_t));
+
+    infrared_signal_clear_timings(signal);
+    infrared_signal_clear_encoded(signal);
+
+    signal->is_raw = true;
+    signal->timings_buffer = buffer;
+
+    signal->payload.raw.timings_size = timings_size;
+    signal->payload.raw.frequency = frequency;
+    signal->payload.raw.duty_cycle = duty_cycle;
+    signal->payload.raw.timings = buffer->data;
+}
+
+void infrared_signal_adopt_raw_signal(
+    InfraredSignal* signal,
+    uint32_t* timings,
+    size_t timings_size,
+    uint32_t frequency,
+    float duty_cycle) {
+    if(signal->raw_storage != InfraredRawStorageFull) {
+        infrared_signal_set_packed_raw_signal(
+            signal, timings, timings_size, frequency, duty_cycle);
+        free(timings);
+        return;
+    }
+
+    infrared_signal_clear_timings(signal);
+    infrared_signal_clear_encoded(signal);
+
+    signal->is_raw = true;
+    signal->timings_buffer = infrared_shared_buffer_adopt(timings);
+
+    signal->payload.raw.timings_size = timings_size;
+    signal->payload.raw.frequency = frequency;
+    signal->payload.raw.duty_cycle = duty_cycle;
+    signal->payload.raw.timings = timings;
+}
+
+void infrared_signal_borrow_raw_signal(
     InfraredSignal* signal,
     const uint32_t* timings,
     size_t timings_size,
     uint32_t frequency,
     float duty_cycle) {
     infrared_signal_clear_timings(signal);
+    infrared_signal_clear_encoded(signal);
 
     signal->is_raw = true;
 
     signal->payload.raw.timings_size = timings_size;
     signal->payload.raw.frequency = frequency;
     signal->payload.raw.duty_cycle = duty_cycle;
+    // The timings are never written to through a borrowed signal.
+    signal->payload.raw.timings = (uint32_t*)timings;
+}
+
+void infrared_signal_set_raw_storage(InfraredSignal* signal, InfraredRawStorage storage) {
+    signal->raw_storage = storage;
+
+    // Borrowed timings are left as they are.
+    if(!signal->is_raw || (!signal->timings_buffer && !signal->packed.data)) return;
+
+    const InfraredRawSignal* raw = &signal->payload.raw;
+
+    if(storage != InfraredRawStorageFull && !signal->packed.data) {
+        infrared_signal_set_packed_raw_signal(
+            signal, raw->timings, raw->timings_size, raw->frequency, raw->duty_cycle);
+    } else if(storage != InfraredRawStorageFull && signal->packed.encoding != storage) {
+        // Repack through a temporary copy, leaving no expanded timings behind.
+        uint32_t* timings = malloc(raw->timings_size * sizeof(uint32_t));
+        const size_t timings_size =
+            infrared_signal_get_raw_timings(signal, timings, raw->timings_size);
+        infrared_signal_set_packed_raw_signal(
+            signal, timings, timings_size, raw->frequency, raw->duty_cycle);
+        free(timings);
+    } else if(storage == InfraredRawStorageFull && signal->packed.data) {
+        infrared_signal_expand_packed(signal);
+        infrared_signal_clear_packed(signal);
+    }
+}
+
+InfraredRawStorage infrared_signal_get_raw_storage(const InfraredSignal* signal) {
+    return signal->raw_storage;
+}
 
-    signal->payload.raw.timings = malloc(timings_size * sizeof(uint32_t));
-    memcpy(signal->payload.raw.timings, timings, timings_size * sizeof(uint32_t));
+void infrared_signal_set_raw_promotion(InfraredSignal* signal, bool enable) {
+    signal->promotes_raw = enable;
 }
 
-const InfraredRawSignal* infrared_signal_get_raw_signal(const InfraredSignal* signal) {
+bool infrared_signal_get_raw_promotion(const InfraredSignal* signal) {
+    return signal->promotes_raw;
+}
+
+bool infrared_signal_promote_raw(InfraredSignal* signal) {
+    if(!signal->is_raw) return false;
+
+    const InfraredRawSignal* raw = infrared_signal_get_raw_signal(signal);
+
+    InfraredMessage message;
+    if(!infrared_signal_decode_timings(raw->timings, raw->timings_size, raw->frequency, &message)) {
+        return false;
+    }
+
+    infrared_signal_set_message(signal, &message);
+    return true;
+}
+
+const InfraredRawSignal* infrared_signal_get_raw_signal(InfraredSignal* signal) {
     furi_assert(signal->is_raw);
+    infrared_signal_expand_packed(signal);
     return &signal->payload.raw;
 }
 
+size_t infrared_signal_get_raw_timings(
+    const InfraredSignal* signal,
+    uint32_t* timings,
+    size_t timings_capacity) {
+    furi_assert(signal->is_raw);
+    const InfraredRawSignal* raw = &signal->payload.raw;
+    furi_check(timings_capacity >= raw->timings_size);
+
+    if(raw->timings) {
+        memcpy(timings, raw->timings, raw->timings_size * sizeof(uint32_t));
+    } else {
+        infrared_signal_unpack_timings(&signal->packed, timings, raw->timings_size);
+    }
+
+    return raw->timings_size;
+}
+
 void infrared_signal_set_message(InfraredSignal* signal, const InfraredMessage* message) {
     infrared_signal_clear_timings(signal);
 
+    // Keep the encoded form only if it still describes the same payload.
+    if(!infrared_signal_is_encoded_for(signal, message)) {
+        infrared_signal_clear_encoded(signal);
+    }
+
     signal->is_raw = false;
     signal->payload.message = *message;
 }
@@ -274,6 +909,15 @@ bool infrared_signal_save(const InfraredSignal* signal, FlipperFormat* ff, const
     if(!flipper_format_write_comment_cstr(ff, "") ||
        !flipper_format_write_string_cstr(ff, INFRARED_SIGNAL_NAME_KEY, name)) {
         return false;
+    } else if(signal->is_raw && signal->packed.data && !signal->payload.raw.timings) {
+        // Expand into a temporary copy, so that the instance stays compact.
+        InfraredRawSignal raw = signal->payload.raw;
+        raw.timings = malloc(raw.timings_size * sizeof(uint32_t));
+        infrared_signal_unpack_timings(&signal->packed, raw.timings, raw.timings_size);
+
+        const bool success = infrared_signal_save_raw(&raw, ff);
+        free(raw.timings);
+        return success;
     } else if(signal->is_raw) {
         return infrared_signal_save_raw(&signal->payload.raw, ff);
     } else {
@@ -281,6 +925,131 @@ bool infrared_signal_save(const InfraredSignal* signal, FlipperFormat* ff, const
     }
 }
 
+// Text being formatted: the length keeps counting once the buffer is full, as with snprintf().
+typedef struct {
+    char* buffer;
+    size_t size;
+    size_t length;
+} InfraredSignalText;
+
+static void infrared_signal_text_append(InfraredSignalText* text, const char* data, size_t size) {
+    // Keep one byte for the terminating zero.
+    if(text->length + 1 < text->size) {
+        memcpy(text->buffer + text->length, data, MIN(size, text->size - 1 - text->length));
+    }
+    text->length += size;
+}
+
+static inline void infrared_signal_text_append_cstr(InfraredSignalText* text, const char* data) {
+    infrared_signal_text_append(text, data, strlen(data));
+}
+
+static void infrared_signal_text_append_key(InfraredSignalText* text, const char* key) {
+    infrared_signal_text_append_cstr(text, key);
+    infrared_signal_text_append(text, ": ", 2);
+}
+
+// Same digits as "%lu", without going through the printf machinery for every timing.
+static void infrared_signal_text_append_uint(InfraredSignalText* text, uint32_t value) {
+    char digits[10];
+    size_t count = 0;
+
+    do {
+        digits[sizeof(digits) - ++count] = '0' + value % 10;
+        value /= 10;
+    } while(value);
+
+    infrared_signal_text_append(text, digits + sizeof(digits) - count, count);
+}
+
+static void infrared_signal_text_append_hex(InfraredSignalText* text, uint32_t value) {
+    static const char hex_digits[] = "0123456789ABCDEF";
+    char hex[11];
+
+    // Four bytes, least significant first, as written by flipper_format_write_hex().
+    for(size_t i = 0; i < 4; ++i) {
+        const uint8_t byte = value >> (i * 8);
+        hex[i * 3] = hex_digits[byte >> 4];
+        hex[i * 3 + 1] = hex_digits[byte & 0x0F];
+        if(i < 3) hex[i * 3 + 2] = ' ';
+    }
+
+    infrared_signal_text_append(text, hex, sizeof(hex));
+}
+
+static void infrared_signal_text_format_message(
+    InfraredSignalText* text,
+    const InfraredMessage* message) {
+    infrared_signal_text_append_key(text, INFRARED_SIGNAL_TYPE_KEY);
+    infrared_signal_text_append_cstr(text, INFRARED_SIGNAL_TYPE_PARSED "\n");
+    infrared_signal_text_append_key(text, INFRARED_SIGNAL_PROTOCOL_KEY);
+    infrared_signal_text_append_cstr(text, infrared_get_protocol_name(message->protocol));
+    infrared_signal_text_append(text, "\n", 1);
+    infrared_signal_text_append_key(text, INFRARED_SIGNAL_ADDRESS_KEY);
+    infrared_signal_text_append_hex(text, message->address);
+    infrared_signal_text_append(text, "\n", 1);
+    infrared_signal_text_append_key(text, INFRARED_SIGNAL_COMMAND_KEY);
+    infrared_signal_text_append_hex(text, message->command);
+    infrared_signal_text_append(text, "\n", 1);
+}
+
+static void infrared_signal_text_format_raw(InfraredSignalText* text, const InfraredSignal* signal) {
+    const InfraredRawSignal* raw = &signal->payload.raw;
+    furi_assert(raw->timings_size <= MAX_TIMINGS_AMOUNT);
+
+    char duty_cycle[16];
+    snprintf(duty_cycle, sizeof(duty_cycle), "%f", (double)raw->duty_cycle);
+
+    infrared_signal_text_append_key(text, INFRARED_SIGNAL_TYPE_KEY);
+    infrared_signal_text_append_cstr(text, INFRARED_SIGNAL_TYPE_RAW "\n");
+    infrared_signal_text_append_key(text, INFRARED_SIGNAL_FREQUENCY_KEY);
+    infrared_signal_text_append_uint(text, raw->frequency);
+    infrared_signal_text_append(text, "\n", 1);
+    infrared_signal_text_append_key(text, INFRARED_SIGNAL_DUTY_CYCLE_KEY);
+    infrared_signal_text_append_cstr(text, duty_cycle);
+    infrared_signal_text_append(text, "\n", 1);
+    infrared_signal_text_append_key(text, INFRARED_SIGNAL_DATA_KEY);
+
+    if(raw->timings) {
+        for(size_t i = 0; i < raw->timings_size; ++i) {
+            if(i) infrared_signal_text_append(text, " ", 1);
+            infrared_signal_text_append_uint(text, raw->timings[i]);
+        }
+    } else {
+        // Packed timings are expanded one at a time, rather than into a temporary copy.
+        InfraredPackedReader reader;
+        infrared_packed_reader_init(&reader, &signal->packed);
+
+        for(size_t i = 0; i < raw->timings_size; ++i) {
+            if(i) infrared_signal_text_append(text, " ", 1);
+            infrared_signal_text_append_uint(text, infrared_packed_reader_next(&reader));
+        }
+    }
+    infrared_signal_text_append(text, "\n", 1);
+}
+
+size_t infrared_signal_format(
+    const InfraredSignal* signal,
+    const char* name,
+    char* buffer,
+    size_t size) {
+    InfraredSignalText text = {.buffer = buffer, .size = size, .length = 0};
+
+    infrared_signal_text_append(&text, "# \n", 3);
+    infrared_signal_text_append_key(&text, INFRARED_SIGNAL_NAME_KEY);
+    infrared_signal_text_append_cstr(&text, name);
+    infrared_signal_text_append(&text, "\n", 1);
+
+    if(signal->is_raw) {
+        infrared_signal_text_format_raw(&text, signal);
+    } else {
+        infrared_signal_text_format_message(&text, &signal->payload.message);
+    }
+
+    if(size) buffer[MIN(text.length, size - 1)] = '\0';
+    return text.length;
+}
+
 bool infrared_signal_read(InfraredSignal* signal, FlipperFormat* ff, FuriString* name) {
     bool success = false;
 
@@ -334,8 +1103,250 @@ bool infrared_signal_search_by_index_and_read(
     return success;
 }
 
+static bool infrared_signal_seek_to_record(
+    FlipperFormat* ff,
+    const InfraredIndex* index,
+    size_t ordinal) {
+    size_t offset;
+    if(!infrared_index_get_offset(index, ordinal, &offset)) return false;
+
+    Stream* stream = flipper_format_get_raw_stream(ff);
+    return stream_seek(stream, offset, StreamOffsetFromStart);
+}
+
+bool infrared_signal_search_by_name_and_read_indexed(
+    InfraredSignal* signal,
+    FlipperFormat* ff,
+    const InfraredIndex* index,
+    const char* name) {
+    bool success = false;
+    FuriString* tmp = furi_string_alloc();
+
+    size_t cursor = 0;
+    size_t ordinal;
+
+    // Several names may share a hash, so confirm the name of each candidate.
+    while(infrared_index_find_name(index, name, &cursor, &ordinal)) {
+        if(!infrared_signal_seek_to_record(ff, index, ordinal)) break;
+        if(!infrared_signal_read_name(ff, tmp)) break;
+        if(furi_string_equal(tmp, name)) {
+            success = infrared_signal_read_body(signal, ff);
+            break;
+        }
+    }
+
+    furi_string_free(tmp);
+    return success;
+}
+
+bool infrared_signal_search_by_index_and_read_indexed(
+    InfraredSignal* signal,
+    FlipperFormat* ff,
+    const InfraredIndex* index,
+    size_t ordinal) {
+    bool success = false;
+    FuriString* tmp = furi_string_alloc();
+
+    do {
+        if(!infrared_signal_seek_to_record(ff, index, ordinal)) break;
+        if(!infrared_signal_read_name(ff, tmp)) break;
+        success = infrared_signal_read_body(signal, ff);
+    } while(false);
+
+    furi_string_free(tmp);
+    return success;
+}
+
+// Read a signal by name, or by ordinal if name is NULL, through the index of the file if it opens.
+static bool infrared_signal_load(
+    InfraredSignal* signal,
+    Storage* storage,
+    const char* path,
+    const char* name,
+    size_t ordinal) {
+    FlipperFormat* ff = flipper_format_buffered_file_alloc(storage);
+    InfraredIndex* index = infrared_index_alloc();
+    FuriString* tmp = furi_string_alloc();
+    bool success = false;
+
+    do {
+        uint32_t version;
+        if(!flipper_format_buffered_file_open_existing(ff, path)) break;
+        if(!flipper_format_read_header(ff, tmp, &version)) break;
+
+        if(infrared_index_open(index, storage, path)) {
+            success = name ?
+                          infrared_signal_search_by_name_and_read_indexed(signal, ff, index, name) :
+                          infrared_signal_search_by_index_and_read_indexed(
+                              signal, ff, index, ordinal);
+        } else {
+            FURI_LOG_W(TAG, "No index for %s, scanning it", path);
+            success = name ? infrared_signal_search_by_name_and_read(signal, ff, name) :
+                             infrared_signal_search_by_index_and_read(signal, ff, ordinal);
+        }
+    } while(false);
+
+    flipper_format_buffered_file_close(ff);
+    flipper_format_free(ff);
+    infrared_index_free(index);
+    furi_string_free(tmp);
+
+    return success;
+}
+
+bool infrared_signal_load_by_name(
+    InfraredSignal* signal,
+    Storage* storage,
+    const char* path,
+    const char* name) {
+    furi_assert(name);
+    return infrared_signal_load(signal, storage, path, name, 0);
+}
+
+bool infrared_signal_load_by_index(
+    InfraredSignal* signal,
+    Storage* storage,
+    const char* path,
+    size_t ordinal) {
+    return infrared_signal_load(signal, storage, path, NULL, ordinal);
+}
+
+/*
+ * Run the protocol encoder over a message, as infrared_send() would, and store
+ * its output as alternating mark/space timings. Returns the number of timings,
+ * or 0 if they do not fit into the given buffer (pass NULL to only count them).
+ */
+static size_t infrared_signal_encode_message(
+    InfraredEncoderHandler* encoder,
+    const InfraredMessage* message,
+    uint32_t* timings,
+    size_t timings_capacity,
+    bool* start_from_mark) {
+    const size_t transmissions = MAX(infrared_get_protocol_min_repeat_count(message->protocol), 1U);
+    size_t timings_size = 0;
+    size_t transmitted = 0;
+    bool last_level = false;
+
+    infrared_reset_encoder(encoder, message);
+
+    while(transmitted < transmissions) {
+        uint32_t duration;
+        bool level;
+        InfraredStatus status = infrared_encode(encoder, &duration, &level);
+
+        if(status == InfraredStatusError) {
+            return 0;
+        } else if(status == InfraredStatusDone) {
+            ++transmitted;
+        }
+
+        if(timings_size == 0) {
+            *start_from_mark = level;
+        } else if(level == last_level) {
+            // Same level twice in a row: extend the current timing.
+            if(timings) timings[timings_size - 1] += duration;
+            continue;
+        }
+
+        if(timings_size == timings_capacity) return 0;
+        if(timings) timings[timings_size] = duration;
+
+        ++timings_size;
+        last_level = level;
+    }
+
+    return timings_size;
+}
+
+bool infrared_signal_encode(InfraredSignal* signal) {
+    furi_assert(!signal->is_raw);
+
+    const InfraredMessage* message = &signal->payload.message;
+    if(infrared_signal_is_encoded_for(signal, message)) return true;
+
+    infrared_signal_clear_encoded(signal);
+    if(!infrared_signal_is_message_valid(message)) return false;
+
+    InfraredEncoderHandler* encoder = infrared_alloc_encoder();
+    bool start_from_mark = true;
+
+    const size_t timings_size = infrared_signal_encode_message(
+        encoder, message, NULL, INFRARED_SIGNAL_ENCODED_MAX_TIMINGS, &start_from_mark);
+
+    if(timings_size > 0) {
+        uint32_t* timings = malloc(timings_size * sizeof(uint32_t));
+        infrared_signal_encode_message(encoder, message, timings, timings_size, &start_from_mark);
+
+        signal->encoded.timings = timings;
+        signal->encoded.timings_size = timings_size;
+        signal->encoded.start_from_mark = start_from_mark;
+        signal->encoded.message = *message;
+    } else {
+        FURI_LOG_W(TAG, "Message is too long to be pre-encoded");
+    }
+
+    infrared_free_encoder(encoder);
+    return timings_size > 0;
+}
+
+static uint32_t infrared_signal_sum_timings(const uint32_t* timings, size_t timings_size) {
+    uint32_t duration = 0;
+    for(size_t i = 0; i < timings_size; ++i) {
+        duration += timings[i];
+    }
+    return duration;
+}
+
+uint32_t infrared_signal_get_duration(const InfraredSignal* signal) {
+    if(signal->is_raw && signal->packed.data && !signal->payload.raw.timings) {
+        InfraredPackedReader reader;
+        infrared_packed_reader_init(&reader, &signal->packed);
+
+        uint32_t duration = 0;
+        for(size_t i = 0; i < signal->payload.raw.timings_size; ++i) {
+            duration += infrared_packed_reader_next(&reader);
+        }
+        return duration;
+    } else if(signal->is_raw) {
+        return infrared_signal_sum_timings(
+            signal->payload.raw.timings, signal->payload.raw.timings_size);
+    } else if(infrared_signal_is_encoded_for(signal, &signal->payload.message)) {
+        return infrared_signal_sum_timings(signal->encoded.timings, signal->encoded.timings_size);
+    }
+
+    // Not pre-encoded: run the encoder into a temporary buffer.
+    const InfraredMessage* message = &signal->payload.message;
+    if(!infrared_signal_is_message_valid(message)) return 0;
+
+    InfraredEncoderHandler* encoder = infrared_alloc_encoder();
+    uint32_t* timings = malloc(INFRARED_SIGNAL_ENCODED_MAX_TIMINGS * sizeof(uint32_t));
+    bool start_from_mark;
+
+    const size_t timings_size = infrared_signal_encode_message(
+        encoder, message, timings, INFRARED_SIGNAL_ENCODED_MAX_TIMINGS, &start_from_mark);
+    const uint32_t duration = infrared_signal_sum_timings(timings, timings_size);
+
+    free(timings);
+    infrared_free_encoder(encoder);
+
+    return duration;
+}
+
 void infrared_signal_transmit(const InfraredSignal* signal) {
-    if(signal->is_raw) {
+    if(signal->is_raw && signal->packed.data) {
+        // Decode the packed timings on the fly, as the transmitter asks for them.
+        const InfraredRawSignal* raw_signal = &signal->payload.raw;
+        InfraredPackedTransmission transmission = {
+            .timings_size = raw_signal->timings_size,
+            .level = true,
+        };
+        infrared_packed_reader_init(&transmission.reader, &signal->packed);
+
+        furi_hal_infrared_async_tx_set_data_isr_callback(
+            infrared_signal_packed_tx_callback, &transmission);
+        furi_hal_infrared_async_tx_start(raw_signal->frequency, raw_signal->duty_cycle);
+        furi_hal_infrared_async_tx_wait_termination();
+    } else if(signal->is_raw) {
         const InfraredRawSignal* raw_signal = &signal->payload.raw;
         infrared_send_raw_ext(
             raw_signal->timings,
@@ -343,8 +1354,181 @@ void infrared_signal_transmit(const InfraredSignal* signal) {
             true,
             raw_signal->frequency,
             raw_signal->duty_cycle);
+    } else if(infrared_signal_is_encoded_for(signal, &signal->payload.message)) {
+        const InfraredEncodedSignal* encoded = &signal->encoded;
+        const InfraredProtocol protocol = signal->payload.message.protocol;
+        infrared_send_raw_ext(
+            encoded->timings,
+            encoded->timings_size,
+            encoded->start_from_mark,
+            infrared_get_protocol_frequency(protocol),
+            infrared_get_protocol_duty_cycle(protocol));
     } else {
         const InfraredMessage* message = &signal->payload.message;
         infrared_send(message, 1);
     }
 }
+
+// Carrier the signal is sent on, false if it is not a valid signal.
+static bool infrared_signal_get_carrier(
+    const InfraredSignal* signal,
+    uint32_t* frequency,
+    float* duty_cycle) {
+    if(signal->is_raw) {
+        *frequency = signal->payload.raw.frequency;
+        *duty_cycle = signal->payload.raw.duty_cycle;
+        return true;
+    } else if(infrared_signal_is_message_valid(&signal->payload.message)) {
+        *frequency = infrared_get_protocol_frequency(signal->payload.message.protocol);
+        *duty_cycle = infrared_get_protocol_duty_cycle(signal->payload.message.protocol);
+        return true;
+    }
+    return false;
+}
+
+bool infrared_signal_is_burst_compatible(
+    const InfraredSignal* signal,
+    const InfraredSignal* other) {
+    uint32_t frequency, other_frequency;
+    float duty_cycle, other_duty_cycle;
+    return infrared_signal_get_carrier(signal, &frequency, &duty_cycle) &&
+           infrared_signal_get_carrier(other, &other_frequency, &other_duty_cycle) &&
+           frequency == other_frequency && duty_cycle == other_duty_cycle;
+}
+
+// Point a burst source at the timings of a signal, encoding them first if need be.
+static bool infrared_burst_source_init(InfraredBurstSource* source, const InfraredSignal* signal) {
+    memset(source, 0, sizeof(InfraredBurstSource));
+    source->start_from_mark = true;
+
+    if(signal->is_raw && signal->packed.data) {
+        source->packed = &signal->packed;
+        source->timings_size = signal->payload.raw.timings_size;
+    } else if(signal->is_raw) {
+        source->timings = signal->payload.raw.timings;
+        source->timings_size = signal->payload.raw.timings_size;
+    } else if(infrared_signal_is_encoded_for(signal, &signal->payload.message)) {
+        source->timings = signal->encoded.timings;
+        source->timings_size = signal->encoded.timings_size;
+        source->start_from_mark = signal->encoded.start_from_mark;
+    } else {
+        InfraredEncoderHandler* encoder = infrared_alloc_encoder();
+        source->scratch = malloc(INFRARED_SIGNAL_ENCODED_MAX_TIMINGS * sizeof(uint32_t));
+        source->timings_size = infrared_signal_encode_message(
+            encoder,
+            &signal->payload.message,
+            source->scratch,
+            INFRARED_SIGNAL_ENCODED_MAX_TIMINGS,
+            &source->start_from_mark);
+        source->timings = source->scratch;
+        infrared_free_encoder(encoder);
+    }
+
+    return source->timings_size > 0;
+}
+
+static void infrared_burst_start_item(InfraredBurstTransmission* transmission) {
+    if(transmission->item == transmission->item_count) return;
+
+    const InfraredBurstSource* source = &transmission->sources[transmission->item];
+    transmission->index = 0;
+    transmission->level = source->start_from_mark;
+    if(source->packed) infrared_packed_reader_init(&transmission->reader, source->packed);
+}
+
+// Next timing of the stream: the timings of each item in turn, each followed by its gap.
+static bool
+    infrared_burst_pull(InfraredBurstTransmission* transmission, uint32_t* duration, bool* level) {
+    while(transmission->item < transmission->item_count) {
+        const InfraredBurstSource* source = &transmission->sources[transmission->item];
+
+        if(transmission->index < source->timings_size) {
+            *duration = source->packed ? infrared_packed_reader_next(&transmission->reader) :
+                                         source->timings[transmission->index];
+            *level = transmission->level;
+            transmission->level = !transmission->level;
+            transmission->index++;
+            return true;
+        }
+
+        uint32_t gap_us = transmission->items[transmission->item].gap_us;
+        // The level flips after each timing: a space next means the item ended with a mark.
+        const bool is_mark_last = !transmission->level;
+        transmission->item++;
+        infrared_burst_start_item(transmission);
+
+        // A mark right after a mark would be sent as one, merging the two items.
+        if(is_mark_last && transmission->level) {
+            gap_us = MAX(gap_us, INFRARED_SIGNAL_BURST_MIN_GAP_US);
+        }
+
+        // The gap after the last item is left to the caller.
+        if(gap_us > 0 && transmission->item < transmission->item_count) {
+            *duration = gap_us;
+            *level = false;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static FuriHalInfraredTxGetDataState
+    infrared_signal_burst_tx_callback(void* context, uint32_t* duration, bool* level) {
+    InfraredBurstTransmission* transmission = context;
+
+    *duration = transmission->next_duration;
+    *level = transmission->next_level;
+
+    // A trailing space, a gap and a leading space in a row make up a single space.
+    while((transmission->has_next = infrared_burst_pull(
+               transmission, &transmission->next_duration, &transmission->next_level)) &&
+          transmission->next_level == *level) {
+        *duration += transmission->next_duration;
+    }
+
+    return transmission->has_next ? FuriHalInfraredTxGetDataStateOk :
+                                    FuriHalInfraredTxGetDataStateLastDone;
+}
+
+bool infrared_signal_transmit_burst(const InfraredSignalBurstItem* items, size_t item_count) {
+    furi_assert(item_count > 0);
+
+    uint32_t frequency;
+    float duty_cycle;
+    if(!infrared_signal_get_carrier(items[0].signal, &frequency, &duty_cycle)) return false;
+
+    InfraredBurstSource* sources = malloc(item_count * sizeof(InfraredBurstSource));
+    bool success = true;
+    for(size_t i = 0; i < item_count; ++i) {
+        // Sources are set up even after a failure so that every scratch buffer can be freed.
+        success &= infrared_burst_source_init(&sources[i], items[i].signal) &&
+                   infrared_signal_is_burst_compatible(items[0].signal, items[i].signal);
+    }
+
+    if(success) {
+        InfraredBurstTransmission transmission = {
+            .items = items,
+            .sources = sources,
+            .item_count = item_count,
+            .item = 0,
+        };
+        infrared_burst_start_item(&transmission);
+        transmission.has_next = infrared_burst_pull(
+            &transmission, &transmission.next_duration, &transmission.next_level);
+
+        furi_hal_infrared_async_tx_set_data_isr_callback(
+            infrared_signal_burst_tx_callback, &transmission);
+        furi_hal_infrared_async_tx_start(frequency, duty_cycle);
+        furi_hal_infrared_async_tx_wait_termination();
+    } else {
+        FURI_LOG_E(TAG, "Signals cannot be sent in one burst");
+    }
+
+    for(size_t i = 0; i < item_count; ++i) {
+        free(sources[i].scratch);
+    }
+    free(sources);
+
+    return success;
+}
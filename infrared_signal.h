@@ -11,6 +11,11 @@
 #include <flipper_format/flipper_format.h>
 #include <infrared/encoder_decoder/infrared.h>
 
+#include "infrared_index.h"
+
+/** Largest difference, in percent, between two timings considered to be the same duration. */
+#define INFRARED_RAW_DICTIONARY_TOLERANCE (10U)
+
 /**
  * @brief InfraredSignal opaque type declaration.
  */
@@ -31,6 +36,15 @@ typedef struct {
     float duty_cycle; /**< Duty cycle of the signal. */
 } InfraredRawSignal;
 
+/**
+ * @brief In-memory representation of raw signal timings.
+ */
+typedef enum {
+    InfraredRawStorageFull, /**< One uint32_t per timing, as in InfraredRawSignal (default). */
+    InfraredRawStorageVarint, /**< Difference to the previous timing of the same level, zigzag and varint encoded. */
+    InfraredRawStorageDictionary, /**< Table of distinct durations and one 4 or 8-bit index per timing, lossy. */
+} InfraredRawStorage;
+
 /**
  * @brief Create a new InfraredSignal instance.
  *
@@ -67,11 +81,51 @@ bool infrared_signal_is_valid(const InfraredSignal* signal);
  * Any instance's previous contents will be automatically deleted before
  * copying the source instance's contents.
  *
+ * Raw timings are reference-counted and never modified in place, so the
+ * destination shares them with the source instead of copying them, unless they
+ * are borrowed (see infrared_signal_borrow_raw_signal()) or held in a different
+ * representation (see infrared_signal_set_raw_storage()). Either instance can
+ * then be changed or deleted, from any thread, without affecting the other.
+ *
  * @param[in,out] signal pointer to the destination instance.
  * @param[in] other pointer to the source instance.
  */
 void infrared_signal_set_signal(InfraredSignal* signal, const InfraredSignal* other);
 
+/**
+ * @brief Test whether two InfraredSignal instances hold the same signal.
+ *
+ * Parsed signals are the same if their protocol, address and command match. Raw
+ * signals are the same if their frequency, duty cycle and number of timings match
+ * and each timing is within INFRARED_RAW_DICTIONARY_TOLERANCE percent of the other.
+ * Dictionary-encoded signals are compared by table and indices, without expansion.
+ *
+ * @param[in] signal pointer to the first instance to be compared.
+ * @param[in] other pointer to the second instance to be compared.
+ * @returns true if both instances hold the same signal, false otherwise.
+ */
+bool infrared_signal_equals(const InfraredSignal* signal, const InfraredSignal* other);
+
+/**
+ * @brief Test whether a received signal is an InfraredSignal instance.
+ *
+ * A parsed signal is received if the decoded message has the same protocol,
+ * address and command, repeats included. A raw signal is received if the
+ * captured timings start with its own, each within INFRARED_RAW_DICTIONARY_TOLERANCE
+ * percent.
+ *
+ * @param[in] signal pointer to the instance expected.
+ * @param[in] message pointer to the message decoded from the received signal, NULL if none.
+ * @param[in] timings pointer to the timings captured, starting with a mark.
+ * @param[in] timings_size number of timings captured.
+ * @returns true if the received signal matches the instance, false otherwise.
+ */
+bool infrared_signal_matches(
+    const InfraredSignal* signal,
+    const InfraredMessage* message,
+    const uint32_t* timings,
+    size_t timings_size);
+
 /**
  * @brief Set an InfraredInstance to hold a raw signal.
  *
@@ -93,15 +147,143 @@ void infrared_signal_set_raw_signal(
     uint32_t frequency,
     float duty_cycle);
 
+/**
+ * @brief Set an InfraredInstance to hold a raw signal, taking ownership of the timings.
+ *
+ * Same as infrared_signal_set_raw_signal(), but the timings array is not copied:
+ * the instance takes ownership of it and will release it with free().
+ *
+ * @param[in,out] signal pointer to the destination instance.
+ * @param[in] timings pointer to a heap-allocated array containing the raw signal timings.
+ * @param[in] timings_size number of elements in the timings array.
+ * @param[in] frequency signal carrier frequency, in Hertz.
+ * @param[in] duty_cycle signal duty cycle, fraction between 0 and 1.
+ */
+void infrared_signal_adopt_raw_signal(
+    InfraredSignal* signal,
+    uint32_t* timings,
+    size_t timings_size,
+    uint32_t frequency,
+    float duty_cycle);
+
+/**
+ * @brief Set an InfraredInstance to hold a raw signal referencing external timings.
+ *
+ * Same as infrared_signal_set_raw_signal(), but the timings array is neither copied
+ * nor owned: it is only referenced and never written to. The array must outlive the
+ * instance or remain valid until the instance is set to hold another signal.
+ *
+ * @param[in,out] signal pointer to the destination instance.
+ * @param[in] timings pointer to a read-only array containing the raw signal timings.
+ * @param[in] timings_size number of elements in the timings array.
+ * @param[in] frequency signal carrier frequency, in Hertz.
+ * @param[in] duty_cycle signal duty cycle, fraction between 0 and 1.
+ */
+void infrared_signal_borrow_raw_signal(
+    InfraredSignal* signal,
+    const uint32_t* timings,
+    size_t timings_size,
+    uint32_t frequency,
+    float duty_cycle);
+
+/**
+ * @brief Set how an InfraredSignal instance keeps raw signal timings in memory.
+ *
+ * With InfraredRawStorageVarint, timings are packed into one to five bytes each,
+ * typically one or two for a captured remote signal, and are transmitted straight
+ * from the packed form.
+ *
+ * With InfraredRawStorageDictionary, timings within INFRARED_RAW_DICTIONARY_TOLERANCE
+ * percent of each other are replaced by their mean and stored as an index into a
+ * table of these means, in half a byte per timing if there are at most 16 of them
+ * and one byte otherwise. This is lossy, but within the tolerance of any decoder.
+ * Signals with more than 256 distinct durations are stored as with
+ * InfraredRawStorageVarint instead.
+ *
+ * The setting applies to every raw signal later set or read
+ * into the instance, and the raw signal currently held, if any, is converted.
+ * Borrowed timings (see infrared_signal_borrow_raw_signal()) are never converted.
+ *
+ * @param[in,out] signal pointer to the instance to be set up.
+ * @param[in] storage representation to be used.
+ */
+void infrared_signal_set_raw_storage(InfraredSignal* signal, InfraredRawStorage storage);
+
+/**
+ * @brief Get how an InfraredSignal instance keeps raw signal timings in memory.
+ *
+ * @param[in] signal pointer to the instance to be queried.
+ * @returns representation set with infrared_signal_set_raw_storage().
+ */
+InfraredRawStorage infrared_signal_get_raw_storage(const InfraredSignal* signal);
+
+/**
+ * @brief Set whether an InfraredSignal instance promotes raw signals it reads.
+ *
+ * When enabled, raw signals read from a file (see infrared_signal_read()) are
+ * passed to infrared_signal_promote_raw() and kept as parsed signals if they turn
+ * out to be a clean capture of a known protocol. Disabled by default.
+ *
+ * @param[in,out] signal pointer to the instance to be set up.
+ * @param[in] enable true to promote raw signals on read, false otherwise.
+ */
+void infrared_signal_set_raw_promotion(InfraredSignal* signal, bool enable);
+
+/**
+ * @brief Get whether an InfraredSignal instance promotes raw signals it reads.
+ *
+ * @param[in] signal pointer to the instance to be queried.
+ * @returns setting made with infrared_signal_set_raw_promotion().
+ */
+bool infrared_signal_get_raw_promotion(const InfraredSignal* signal);
+
+/**
+ * @brief Replace the raw signal held by an InfraredSignal instance with the message it encodes.
+ *
+ * The timings are run through the protocol decoders. The signal is promoted only
+ * if they decode to a valid message, any further frame is the same message or one
+ * of its repeats, and the carrier frequency is within INFRARED_RAW_DICTIONARY_TOLERANCE
+ * percent of the protocol's. A parsed signal takes a few bytes instead of the
+ * whole timing array and is transmitted through the protocol encoder.
+ *
+ * @param[in,out] signal pointer to the instance to be promoted.
+ * @returns true if the instance now holds a parsed signal, false if it was left unchanged.
+ */
+bool infrared_signal_promote_raw(InfraredSignal* signal);
+
 /**
  * @brief Get the raw signal held by an InfraredSignal instance.
  *
+ * If the timings are held in a packed form (see infrared_signal_set_raw_storage()),
+ * this materializes them: the first call allocates an expanded copy, kept beside
+ * the packed form until the instance is set to hold another signal. Use
+ * infrared_signal_get_raw_timings() to read packed timings without changing the
+ * instance.
+ *
  * @warning the instance MUST hold a *raw* signal, otherwise undefined behaviour will occur.
  *
- * @param[in] signal pointer to the instance to be queried.
+ * @param[in,out] signal pointer to the instance to be queried.
  * @returns pointer to the raw signal structure held by the instance.
  */
-const InfraredRawSignal* infrared_signal_get_raw_signal(const InfraredSignal* signal);
+const InfraredRawSignal* infrared_signal_get_raw_signal(InfraredSignal* signal);
+
+/**
+ * @brief Copy the raw signal timings held by an InfraredSignal instance.
+ *
+ * Packed timings are expanded straight into the array: nothing is allocated and
+ * the instance is left untouched, so this may be called on a shared instance.
+ *
+ * @warning the instance MUST hold a *raw* signal, otherwise undefined behaviour will occur.
+ *
+ * @param[in] signal pointer to the instance to be queried.
+ * @param[out] timings pointer to the array to hold the timings.
+ * @param[in] timings_capacity number of elements in the timings array, at least the signal's timings_size.
+ * @returns number of timings copied.
+ */
+size_t infrared_signal_get_raw_timings(
+    const InfraredSignal* signal,
+    uint32_t* timings,
+    size_t timings_capacity);
 
 /**
  * @brief Set an InfraredInstance to hold a parsed signal.
@@ -194,6 +376,84 @@ bool infrared_signal_search_by_index_and_read(
     FlipperFormat* ff,
     size_t index);
 
+/**
+ * @brief Read a signal with a particular name using an index of the file.
+ *
+ * Same behaviour as infrared_signal_search_by_name_and_read(), except that the file is not
+ * scanned: the index is used to seek directly to the record. The index must have been opened
+ * on the same file that ff refers to.
+ *
+ * @param[in,out] signal pointer to the instance to be read into.
+ * @param[in,out] ff pointer to the FlipperFormat file instance to read from.
+ * @param[in] index pointer to the index of the file.
+ * @param[in] name pointer to a zero-terminated string containing the requested signal name.
+ * @returns true if a signal was found and successfully read, false otherwise (e.g. the signal was not found).
+ */
+bool infrared_signal_search_by_name_and_read_indexed(
+    InfraredSignal* signal,
+    FlipperFormat* ff,
+    const InfraredIndex* index,
+    const char* name);
+
+/**
+ * @brief Read a signal with a particular index using an index of the file.
+ *
+ * Same behaviour as infrared_signal_search_by_index_and_read(), except that the file is not
+ * scanned: the index is used to seek directly to the record. The index must have been opened
+ * on the same file that ff refers to.
+ *
+ * @param[in,out] signal pointer to the instance to be read into.
+ * @param[in,out] ff pointer to the FlipperFormat file instance to read from.
+ * @param[in] index pointer to the index of the file.
+ * @param[in] ordinal the requested signal index.
+ * @returns true if a signal was found and successfully read, false otherwise (e.g. the signal was not found).
+ */
+bool infrared_signal_search_by_index_and_read_indexed(
+    InfraredSignal* signal,
+    FlipperFormat* ff,
+    const InfraredIndex* index,
+    size_t ordinal);
+
+/**
+ * @brief Read a signal with a particular name from a signal file.
+ *
+ * The file is looked up through its sidecar index, which is built first if it is
+ * missing or stale (see infrared_index_open()), so that only the requested record
+ * is parsed. If the index cannot be opened, the file is scanned as by
+ * infrared_signal_search_by_name_and_read(). Callers making many lookups in the
+ * same file should keep an InfraredIndex open and use
+ * infrared_signal_search_by_name_and_read_indexed() instead.
+ *
+ * @param[in,out] signal pointer to the instance to be read into.
+ * @param[in] storage pointer to the storage record.
+ * @param[in] path pointer to a zero-terminated string containing the signal file path.
+ * @param[in] name pointer to a zero-terminated string containing the requested signal name.
+ * @returns true if a signal was found and successfully read, false otherwise (e.g. the signal was not found).
+ */
+bool infrared_signal_load_by_name(
+    InfraredSignal* signal,
+    Storage* storage,
+    const char* path,
+    const char* name);
+
+/**
+ * @brief Read a signal with a particular index from a signal file.
+ *
+ * Same behaviour as infrared_signal_load_by_name(), but the signal is looked up by
+ * its position in the file.
+ *
+ * @param[in,out] signal pointer to the instance to be read into.
+ * @param[in] storage pointer to the storage record.
+ * @param[in] path pointer to a zero-terminated string containing the signal file path.
+ * @param[in] ordinal the requested signal index.
+ * @returns true if a signal was found and successfully read, false otherwise (e.g. the signal was not found).
+ */
+bool infrared_signal_load_by_index(
+    InfraredSignal* signal,
+    Storage* storage,
+    const char* path,
+    size_t ordinal);
+
 /**
  * @brief Save a signal contained in an InfraredSignal instance to a FlipperFormat file.
  *
@@ -206,10 +466,103 @@ bool infrared_signal_search_by_index_and_read(
  */
 bool infrared_signal_save(const InfraredSignal* signal, FlipperFormat* ff, const char* name);
 
+/**
+ * @brief Format the signal held by an InfraredSignal instance as text, as infrared_signal_save() writes it.
+ *
+ * Nothing is allocated: packed raw timings are expanded as they are formatted.
+ * As with snprintf(), text that does not fit is cut off and the full length is
+ * returned all the same, so that the caller can retry with a larger buffer.
+ *
+ * @param[in] signal pointer to the instance to be formatted.
+ * @param[in] name pointer to a zero-terminated string containing the signal name.
+ * @param[out] buffer pointer to the buffer to hold the zero-terminated text, may be NULL if size is 0.
+ * @param[in] size size of the buffer, in bytes.
+ * @returns length of the full text, not counting the terminating zero.
+ */
+size_t infrared_signal_format(
+    const InfraredSignal* signal,
+    const char* name,
+    char* buffer,
+    size_t size);
+
+/**
+ * @brief Pre-encode the parsed signal held by an InfraredSignal instance.
+ *
+ * The protocol encoder is run once and its output is kept by the instance as a
+ * timing array. Subsequent calls to infrared_signal_transmit() replay these timings
+ * through the raw transmission path instead of encoding the message again.
+ *
+ * The encoded form is bounded in size and is kept only as long as the held message
+ * does not change: infrared_signal_set_message() with a different protocol, address
+ * or command, or setting a raw signal, discards it. It is not copied by
+ * infrared_signal_set_signal().
+ *
+ * @warning the instance MUST hold a *parsed* signal, otherwise undefined behaviour will occur.
+ *
+ * @param[in,out] signal pointer to the instance to be encoded.
+ * @returns true if the encoded form is available, false otherwise (e.g. invalid or too long message).
+ */
+bool infrared_signal_encode(InfraredSignal* signal);
+
+/**
+ * @brief Get the air time of a signal contained in an InfraredSignal instance.
+ *
+ * This is the sum of the timings sent by infrared_signal_transmit(), trailing
+ * space included.
+ *
+ * @param[in] signal pointer to the instance to be queried.
+ * @returns duration of one transmission in microseconds, or 0 if the signal is invalid.
+ */
+uint32_t infrared_signal_get_duration(const InfraredSignal* signal);
+
+// Shortest space between two signals of a burst when the first ends with a mark and the next starts with one.
+#define INFRARED_SIGNAL_BURST_MIN_GAP_US (20000U)
+
+/**
+ * @brief One signal of a burst, and the time to wait after it.
+ */
+typedef struct {
+    const InfraredSignal* signal; /**< Signal to be transmitted. */
+    uint32_t gap_us; /**< Time between the end of the signal, trailing space included, and the next one. */
+} InfraredSignalBurstItem;
+
+/**
+ * @brief Test whether two signals can be transmitted in the same burst.
+ *
+ * @param[in] signal pointer to the instance holding the first signal.
+ * @param[in] other pointer to the instance holding the second signal.
+ * @returns true if both signals are valid and use the same carrier, false otherwise.
+ */
+bool infrared_signal_is_burst_compatible(
+    const InfraredSignal* signal,
+    const InfraredSignal* other);
+
+/**
+ * @brief Transmit several signals back to back in a single hardware session.
+ *
+ * The timings of all signals and the gaps between them are streamed to the
+ * transmitter as one continuous sequence, so the gaps are timed by the hardware
+ * and are not subject to scheduling jitter. Parsed signals that were not
+ * pre-encoded are encoded before the transmission starts. The gap of the last
+ * item is not transmitted.
+ *
+ * A gap shorter than INFRARED_SIGNAL_BURST_MIN_GAP_US between a signal ending
+ * with a mark and one starting with a mark, 0 included, is lengthened to it:
+ * otherwise the two marks would go out as one and merge the signals into a
+ * single corrupt frame.
+ *
+ * @param[in] items pointer to the array of signals and gaps.
+ * @param[in] item_count number of elements in the items array, at least 1.
+ * @returns true if the signals were sent, false if one of them is invalid or uses another carrier.
+ */
+bool infrared_signal_transmit_burst(const InfraredSignalBurstItem* items, size_t item_count);
+
 /**
  * @brief Transmit a signal contained in an InfraredSignal instance.
  *
  * The transmission happens once per call using the built-in hardware (via HAL calls).
+ * Parsed signals that were pre-encoded with infrared_signal_encode() are sent without
+ * running the protocol encoder.
  *
  * @param[in] signal pointer to the instance holding the signal to be transmitted.
  */
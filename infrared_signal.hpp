@@ -0,0 +1,141 @@
+/**
+ * @file infrared_signal.hpp
+ * @brief C++ wrapper for the infrared signal library.
+ *
+ * infrared::Signal owns an InfraredSignal instance and deletes it when it goes
+ * out of scope. It can be moved but not implicitly copied: copies are made with
+ * copy(), which shares the raw timings of the source (see
+ * infrared_signal_set_signal()) and is therefore cheap.
+ *
+ * A moved-from Signal holds no instance and may only be assigned to or destroyed.
+ */
+#pragma once
+
+extern "C" {
+#include "infrared_signal.h"
+}
+
+#include <utility>
+
+namespace infrared {
+
+class Signal {
+public:
+    /** Create a new, empty signal. */
+    Signal()
+        : signal_(infrared_signal_alloc()) {
+    }
+
+    /** Take ownership of an existing instance, which must not be deleted elsewhere. */
+    explicit Signal(InfraredSignal* signal) noexcept
+        : signal_(signal) {
+    }
+
+    /** Create a parsed signal. */
+    explicit Signal(const InfraredMessage& message)
+        : Signal() {
+        infrared_signal_set_message(signal_, &message);
+    }
+
+    ~Signal() {
+        if(signal_) infrared_signal_free(signal_);
+    }
+
+    Signal(const Signal&) = delete;
+    Signal& operator=(const Signal&) = delete;
+
+    Signal(Signal&& other) noexcept
+        : signal_(std::exchange(other.signal_, nullptr)) {
+    }
+
+    /** Delete the instance held, if any, and take over the one of other. */
+    Signal& operator=(Signal&& other) noexcept {
+        if(this != &other) {
+            if(signal_) infrared_signal_free(signal_);
+            signal_ = std::exchange(other.signal_, nullptr);
+        }
+        return *this;
+    }
+
+    /** Make an independent copy, sharing the raw timings with this signal. */
+    Signal copy() const {
+        Signal result;
+        infrared_signal_set_signal(result.signal_, signal_);
+        return result;
+    }
+
+    /** Give up ownership of the instance, which the caller must then delete. */
+    InfraredSignal* release() noexcept {
+        return std::exchange(signal_, nullptr);
+    }
+
+    InfraredSignal* get() noexcept {
+        return signal_;
+    }
+
+    const InfraredSignal* get() const noexcept {
+        return signal_;
+    }
+
+    explicit operator bool() const noexcept {
+        return signal_ != nullptr;
+    }
+
+    bool is_raw() const {
+        return infrared_signal_is_raw(signal_);
+    }
+
+    bool is_valid() const {
+        return infrared_signal_is_valid(signal_);
+    }
+
+    const InfraredMessage& message() const {
+        return *infrared_signal_get_message(signal_);
+    }
+
+    /** Expands packed timings into a copy kept by the instance, see infrared_signal_get_raw_signal(). */
+    const InfraredRawSignal& raw() {
+        return *infrared_signal_get_raw_signal(signal_);
+    }
+
+    size_t raw_timings(uint32_t* timings, size_t timings_capacity) const {
+        return infrared_signal_get_raw_timings(signal_, timings, timings_capacity);
+    }
+
+    void set_message(const InfraredMessage& message) {
+        infrared_signal_set_message(signal_, &message);
+    }
+
+    void set_raw(const uint32_t* timings, size_t timings_size, uint32_t frequency, float duty_cycle) {
+        infrared_signal_set_raw_signal(signal_, timings, timings_size, frequency, duty_cycle);
+    }
+
+    void set_raw_storage(InfraredRawStorage storage) {
+        infrared_signal_set_raw_storage(signal_, storage);
+    }
+
+    bool read(FlipperFormat* ff, FuriString* name) {
+        return infrared_signal_read(signal_, ff, name);
+    }
+
+    bool save(FlipperFormat* ff, const char* name) const {
+        return infrared_signal_save(signal_, ff, name);
+    }
+
+    void transmit() const {
+        infrared_signal_transmit(signal_);
+    }
+
+    friend bool operator==(const Signal& a, const Signal& b) {
+        return infrared_signal_equals(a.signal_, b.signal_);
+    }
+
+    friend bool operator!=(const Signal& a, const Signal& b) {
+        return !(a == b);
+    }
+
+private:
+    InfraredSignal* signal_;
+};
+
+} // namespace infrared
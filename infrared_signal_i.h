@@ -0,0 +1,102 @@
+/**
+ * @file infrared_signal_i.h
+ * @brief Infrared signal library, internal definitions.
+ *
+ * Exposes the layout of InfraredSignal so that signals can be defined as
+ * constants, e.g. in a signal table generated at build time, with the
+ * INFRARED_SIGNAL_PARSED_INIT() and INFRARED_SIGNAL_RAW_INIT() initializers.
+ * Such signals live in flash and borrow their timings: they must only be used
+ * through the functions taking a const InfraredSignal, and never be freed.
+ */
+#pragma once
+
+#include <stdatomic.h>
+
+#include "infrared_signal.h"
+
+/*
+ * Reference-counted, immutable buffer. Timings are never modified in place once
+ * set: an instance that needs different timings drops its reference and takes a
+ * new buffer, so copies of a signal can share their buffers and still behave as
+ * independent copies.
+ */
+typedef struct {
+    atomic_uint ref_count;
+    void* data; /**< Either right after this header, or a separate adopted allocation. */
+} InfraredSharedBuffer;
+
+typedef struct {
+    uint32_t* timings;
+    size_t timings_size;
+    bool start_from_mark;
+    InfraredMessage message; /**< The message the timings were encoded from. */
+} InfraredEncodedSignal;
+
+typedef struct {
+    InfraredRawStorage encoding; /**< Either InfraredRawStorageVarint or InfraredRawStorageDictionary. */
+    InfraredSharedBuffer* buffer;
+    uint8_t* data; /**< Contents of buffer. */
+    size_t data_size;
+    size_t symbol_count; /**< Dictionary only: number of durations at the start of data. */
+} InfraredPackedTimings;
+
+struct InfraredSignal {
+    bool is_raw;
+    bool promotes_raw;
+    InfraredRawStorage raw_storage;
+    union {
+        InfraredMessage message;
+        InfraredRawSignal raw;
+    } payload;
+    /** Holder of payload.raw.timings, or NULL if they are borrowed. */
+    InfraredSharedBuffer* timings_buffer;
+    /**
+     * Raw timings in packed form, if data is not NULL. In this case, payload.raw.timings
+     * is either NULL or an expanded copy held by timings_buffer, made by
+     * infrared_signal_get_raw_signal().
+     */
+    InfraredPackedTimings packed;
+    InfraredEncodedSignal encoded;
+};
+
+/**
+ * @brief Initializer for a constant parsed signal.
+ *
+ * @param message_protocol InfraredProtocol of the message.
+ * @param message_address address of the message.
+ * @param message_command command of the message.
+ */
+#define INFRARED_SIGNAL_PARSED_INIT(message_protocol, message_address, message_command) \
+    {                                                                                  \
+        .is_raw = false,                                                               \
+        .payload = {                                                                   \
+            .message =                                                                 \
+                {                                                                      \
+                    .protocol = (message_protocol),                                    \
+                    .address = (message_address),                                      \
+                    .command = (message_command),                                      \
+                    .repeat = false,                                                   \
+                },                                                                     \
+        },                                                                             \
+    }
+
+/**
+ * @brief Initializer for a constant raw signal.
+ *
+ * @param raw_timings constant array of timings, borrowed by the signal.
+ * @param raw_frequency carrier frequency of the signal.
+ * @param raw_duty_cycle duty cycle of the signal.
+ */
+#define INFRARED_SIGNAL_RAW_INIT(raw_timings, raw_frequency, raw_duty_cycle) \
+    {                                                                       \
+        .is_raw = true,                                                     \
+        .payload = {                                                        \
+            .raw =                                                          \
+                {                                                           \
+                    .timings_size = sizeof(raw_timings) / sizeof(uint32_t), \
+                    .timings = (uint32_t*)(raw_timings),                    \
+                    .frequency = (raw_frequency),                           \
+                    .duty_cycle = (raw_duty_cycle),                         \
+                },                                                          \
+        },                                                                  \
+    }
@@ -0,0 +1,431 @@
+#include "infrared_tx_worker.h"
+
+#include <furi.h>
+#include <infrared_worker.h>
+
+#define TAG "InfraredTxWorker"
+
+#define INFRARED_TX_WORKER_STACK_SIZE (2048UL)
+
+#define INFRARED_TX_WORKER_SLOT_BITS (8U)
+#define INFRARED_TX_WORKER_SLOT_MASK ((1UL << INFRARED_TX_WORKER_SLOT_BITS) - 1)
+#define INFRARED_TX_WORKER_GENERATION_MAX (0xFFFFFFUL)
+
+typedef enum {
+    InfraredTxWorkerFlagRequest = (1 << 0),
+    InfraredTxWorkerFlagExit = (1 << 1),
+    InfraredTxWorkerFlagAll = InfraredTxWorkerFlagRequest | InfraredTxWorkerFlagExit,
+    // Only waited for while listening, after a transmission.
+    InfraredTxWorkerFlagHeard = (1 << 2),
+} InfraredTxWorkerFlag;
+
+typedef struct {
+    const InfraredSignal* signal;
+    const InfraredSignalBurstItem* burst; /**< Signals sent in one burst instead, if not NULL. */
+    size_t burst_size;
+    InfraredTxWorkerCallback callback;
+    void* context;
+    uint32_t generation;
+    uint32_t submit_tick;
+    InfraredTxPriority priority;
+    size_t retries;
+    bool is_repeatable;
+    InfraredTxStatus status;
+} InfraredTxWorkerSlot;
+
+typedef struct {
+    uint8_t slots[INFRARED_TX_WORKER_QUEUE_SIZE];
+    size_t head;
+    size_t count;
+} InfraredTxWorkerFifo;
+
+struct InfraredTxWorker {
+    FuriThread* thread;
+    FuriMutex* mutex;
+    InfraredTxWorkerSlot slots[INFRARED_TX_WORKER_QUEUE_SIZE];
+    InfraredTxWorkerFifo queues[InfraredTxPriorityCount];
+    InfraredTxWorkerStats stats;
+    EventTrace* trace;
+    size_t trace_producer;
+    // Set by infrared_tx_worker_stop(): nothing more is taken from the queues.
+    bool is_stopping;
+
+    // Receiver used for verification, NULL if disabled, and the signal being listened for.
+    InfraredWorker* rx_worker;
+    uint32_t listen_ms;
+    const InfraredSignal* expected;
+};
+
+static inline InfraredTxHandle infrared_tx_worker_make_handle(size_t slot, uint32_t generation) {
+    return (generation << INFRARED_TX_WORKER_SLOT_BITS) | slot;
+}
+
+static inline bool infrared_tx_worker_slot_is_free(const InfraredTxWorkerSlot* slot) {
+    return slot->status == InfraredTxStatusDone || slot->status == InfraredTxStatusUnconfirmed ||
+           slot->status == InfraredTxStatusCancelled;
+}
+
+// Both functions below must be called with the mutex held.
+static bool infrared_tx_worker_pop(InfraredTxWorker* worker, size_t* slot) {
+    for(size_t i = InfraredTxPriorityCount; i-- > 0;) {
+        InfraredTxWorkerFifo* fifo = &worker->queues[i];
+        if(fifo->count == 0) continue;
+
+        *slot = fifo->slots[fifo->head];
+        fifo->head = (fifo->head + 1) % INFRARED_TX_WORKER_QUEUE_SIZE;
+        fifo->count--;
+        worker->stats.queue_depth--;
+        return true;
+    }
+
+    return false;
+}
+
+static void infrared_tx_worker_push(InfraredTxWorker* worker, InfraredTxPriority priority, size_t slot) {
+    InfraredTxWorkerFifo* fifo = &worker->queues[priority];
+    fifo->slots[(fifo->head + fifo->count) % INFRARED_TX_WORKER_QUEUE_SIZE] = slot;
+    fifo->count++;
+
+    worker->stats.queue_depth++;
+    worker->stats.max_queue_depth = MAX(worker->stats.max_queue_depth, worker->stats.queue_depth);
+}
+
+// Called from the receiver thread whenever a signal is heard.
+static void infrared_tx_worker_rx_callback(void* context, InfraredWorkerSignal* received_signal) {
+    InfraredTxWorker* worker = context;
+
+    const uint32_t* timings;
+    size_t timings_size;
+    infrared_worker_get_raw_signal(received_signal, &timings, &timings_size);
+    const InfraredMessage* message = infrared_worker_signal_is_decoded(received_signal) ?
+                                         infrared_worker_get_decoded_signal(received_signal) :
+                                         NULL;
+
+    furi_check(furi_mutex_acquire(worker->mutex, FuriWaitForever) == FuriStatusOk);
+    const bool is_expected =
+        worker->expected &&
+        infrared_signal_matches(worker->expected, message, timings, timings_size);
+    furi_mutex_release(worker->mutex);
+
+    if(is_expected) {
+        furi_thread_flags_set(furi_thread_get_id(worker->thread), InfraredTxWorkerFlagHeard);
+    }
+}
+
+// Listen for a signal that was just sent, returning whether it was heard back in time.
+static bool infrared_tx_worker_listen(InfraredTxWorker* worker, const InfraredSignal* signal) {
+    furi_check(furi_mutex_acquire(worker->mutex, FuriWaitForever) == FuriStatusOk);
+    worker->expected = signal;
+    furi_mutex_release(worker->mutex);
+
+    furi_thread_flags_clear(InfraredTxWorkerFlagHeard);
+    infrared_worker_rx_start(worker->rx_worker);
+    const uint32_t flags = furi_thread_flags_wait(
+        InfraredTxWorkerFlagHeard, FuriFlagWaitAny, furi_ms_to_ticks(worker->listen_ms));
+    infrared_worker_rx_stop(worker->rx_worker);
+
+    furi_check(furi_mutex_acquire(worker->mutex, FuriWaitForever) == FuriStatusOk);
+    worker->expected = NULL;
+    furi_mutex_release(worker->mutex);
+
+    return !(flags & FuriFlagError) && (flags & InfraredTxWorkerFlagHeard);
+}
+
+// Send a signal, then again, if it is repeatable, until it is heard back or the retries run out.
+static InfraredTxStatus
+    infrared_tx_worker_send(InfraredTxWorker* worker, InfraredTxWorkerSlot* slot) {
+    if(slot->burst) {
+        infrared_signal_transmit_burst(slot->burst, slot->burst_size);
+        return InfraredTxStatusDone;
+    }
+
+    infrared_signal_transmit(slot->signal);
+    if(!worker->rx_worker || slot->retries == 0) return InfraredTxStatusDone;
+
+    // Listening starts once the transmission has ended: only a repeat of the signal can be heard.
+    size_t retries = slot->is_repeatable ? slot->retries : 0;
+    bool is_heard;
+    while(!(is_heard = infrared_tx_worker_listen(worker, slot->signal)) && retries > 0) {
+        infrared_signal_transmit(slot->signal);
+        --retries;
+    }
+    retries = slot->is_repeatable ? slot->retries - retries : 0;
+
+    furi_check(furi_mutex_acquire(worker->mutex, FuriWaitForever) == FuriStatusOk);
+    worker->stats.resent += retries;
+    if(is_heard) {
+        worker->stats.confirmed++;
+    } else {
+        worker->stats.unconfirmed++;
+    }
+    furi_mutex_release(worker->mutex);
+
+    if(!is_heard) {
+        FURI_LOG_W(TAG, "Signal not heard back after %zu retries", retries);
+    }
+
+    return is_heard ? InfraredTxStatusDone : InfraredTxStatusUnconfirmed;
+}
+
+static int32_t infrared_tx_worker_thread(void* context) {
+    InfraredTxWorker* worker = context;
+
+    for(;;) {
+        const uint32_t flags =
+            furi_thread_flags_wait(InfraredTxWorkerFlagAll, FuriFlagWaitAny, FuriWaitForever);
+        if(flags & FuriFlagError) continue;
+        if(flags & InfraredTxWorkerFlagExit) break;
+
+        for(;;) {
+            size_t index = 0;
+
+            furi_check(furi_mutex_acquire(worker->mutex, FuriWaitForever) == FuriStatusOk);
+            const bool has_request =
+                !worker->is_stopping && infrared_tx_worker_pop(worker, &index);
+            InfraredTxWorkerSlot* slot = &worker->slots[index];
+
+            InfraredTxPriority priority = InfraredTxPriorityScheduled;
+            size_t queue_depth = 0;
+            if(has_request) {
+                const uint32_t wait_ms = furi_get_tick() - slot->submit_tick;
+                worker->stats.last_wait_ms = wait_ms;
+                worker->stats.max_wait_ms = MAX(worker->stats.max_wait_ms, wait_ms);
+                worker->stats.total_wait_ms += wait_ms;
+                slot->status = InfraredTxStatusSending;
+                priority = slot->priority;
+                queue_depth = worker->stats.queue_depth;
+            }
+            furi_mutex_release(worker->mutex);
+
+            if(!has_request) break;
+
+            event_trace_record(
+                worker->trace,
+                worker->trace_producer,
+                EventTraceTypeTxStart,
+                priority,
+                queue_depth);
+            const uint32_t start_cycles = event_trace_get_cycles();
+
+            const InfraredTxStatus status = infrared_tx_worker_send(worker, slot);
+
+            event_trace_record(
+                worker->trace,
+                worker->trace_producer,
+                EventTraceTypeTxEnd,
+                priority,
+                event_trace_cycles_to_us(event_trace_get_cycles() - start_cycles));
+
+            // Copy what the callback needs: the slot may be reused once it is done.
+            const InfraredTxWorkerCallback callback = slot->callback;
+            void* callback_context = slot->context;
+
+            furi_check(furi_mutex_acquire(worker->mutex, FuriWaitForever) == FuriStatusOk);
+            const InfraredTxHandle handle = infrared_tx_worker_make_handle(index, slot->generation);
+            slot->status = status;
+            worker->stats.sent++;
+            furi_mutex_release(worker->mutex);
+
+            if(callback) {
+                callback(handle, status, callback_context);
+            }
+        }
+    }
+
+    return 0;
+}
+
+InfraredTxWorker* infrared_tx_worker_alloc(void) {
+    InfraredTxWorker* worker = malloc(sizeof(InfraredTxWorker));
+
+    worker->thread = furi_thread_alloc_ex(
+        TAG, INFRARED_TX_WORKER_STACK_SIZE, infrared_tx_worker_thread, worker);
+    worker->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+
+    for(size_t i = 0; i < INFRARED_TX_WORKER_QUEUE_SIZE; ++i) {
+        worker->slots[i].signal = NULL;
+        worker->slots[i].burst = NULL;
+        worker->slots[i].burst_size = 0;
+        worker->slots[i].callback = NULL;
+        worker->slots[i].context = NULL;
+        worker->slots[i].generation = 0;
+        worker->slots[i].submit_tick = 0;
+        worker->slots[i].priority = InfraredTxPriorityScheduled;
+        worker->slots[i].retries = 0;
+        worker->slots[i].is_repeatable = false;
+        worker->slots[i].status = InfraredTxStatusDone;
+    }
+
+    memset(worker->queues, 0, sizeof(worker->queues));
+    memset(&worker->stats, 0, sizeof(worker->stats));
+    worker->trace = NULL;
+    worker->trace_producer = 0;
+    worker->is_stopping = false;
+    worker->rx_worker = NULL;
+    worker->listen_ms = 0;
+    worker->expected = NULL;
+
+    return worker;
+}
+
+void infrared_tx_worker_free(InfraredTxWorker* worker) {
+    if(worker->rx_worker) {
+        infrared_worker_free(worker->rx_worker);
+    }
+    furi_thread_free(worker->thread);
+    furi_mutex_free(worker->mutex);
+    free(worker);
+}
+
+void infrared_tx_worker_set_trace(InfraredTxWorker* worker, EventTrace* trace, size_t producer) {
+    worker->trace = trace;
+    worker->trace_producer = producer;
+}
+
+void infrared_tx_worker_set_verification(InfraredTxWorker* worker, uint32_t listen_ms) {
+    furi_assert(listen_ms > 0);
+
+    if(!worker->rx_worker) {
+        worker->rx_worker = infrared_worker_alloc();
+        infrared_worker_rx_enable_signal_decoding(worker->rx_worker, true);
+        infrared_worker_rx_set_received_signal_callback(
+            worker->rx_worker, infrared_tx_worker_rx_callback, worker);
+    }
+    worker->listen_ms = listen_ms;
+}
+
+void infrared_tx_worker_start(InfraredTxWorker* worker) {
+    worker->is_stopping = false;
+    furi_thread_start(worker->thread);
+}
+
+void infrared_tx_worker_stop(InfraredTxWorker* worker) {
+    // Let the request being sent finish, but not the ones queued behind it.
+    furi_check(furi_mutex_acquire(worker->mutex, FuriWaitForever) == FuriStatusOk);
+    worker->is_stopping = true;
+    furi_mutex_release(worker->mutex);
+
+    furi_thread_flags_set(furi_thread_get_id(worker->thread), InfraredTxWorkerFlagExit);
+    furi_thread_join(worker->thread);
+
+    furi_check(furi_mutex_acquire(worker->mutex, FuriWaitForever) == FuriStatusOk);
+    size_t index;
+    while(infrared_tx_worker_pop(worker, &index)) {
+        worker->slots[index].status = InfraredTxStatusCancelled;
+    }
+    furi_mutex_release(worker->mutex);
+}
+
+// Queue a request for a signal or a burst of signals.
+static InfraredTxHandle infrared_tx_worker_enqueue(
+    InfraredTxWorker* worker,
+    const InfraredSignal* signal,
+    const InfraredSignalBurstItem* burst,
+    size_t burst_size,
+    InfraredTxPriority priority,
+    size_t retries,
+    bool is_repeatable,
+    InfraredTxWorkerCallback callback,
+    void* context) {
+    furi_assert(priority < InfraredTxPriorityCount);
+
+    InfraredTxHandle handle = INFRARED_TX_HANDLE_INVALID;
+
+    furi_check(furi_mutex_acquire(worker->mutex, FuriWaitForever) == FuriStatusOk);
+
+    for(size_t i = 0; i < INFRARED_TX_WORKER_QUEUE_SIZE; ++i) {
+        InfraredTxWorkerSlot* slot = &worker->slots[i];
+        if(!infrared_tx_worker_slot_is_free(slot)) continue;
+
+        // Generation 0 is never used, so that no valid handle equals INFRARED_TX_HANDLE_INVALID.
+        slot->generation = slot->generation % INFRARED_TX_WORKER_GENERATION_MAX + 1;
+        slot->signal = signal;
+        slot->burst = burst;
+        slot->burst_size = burst_size;
+        slot->callback = callback;
+        slot->context = context;
+        slot->submit_tick = furi_get_tick();
+        slot->priority = priority;
+        slot->retries = retries;
+        slot->is_repeatable = is_repeatable;
+        slot->status = InfraredTxStatusPending;
+
+        infrared_tx_worker_push(worker, priority, i);
+        worker->stats.submitted++;
+
+        handle = infrared_tx_worker_make_handle(i, slot->generation);
+        break;
+    }
+
+    if(handle == INFRARED_TX_HANDLE_INVALID) {
+        worker->stats.rejected++;
+    }
+
+    furi_mutex_release(worker->mutex);
+
+    if(handle != INFRARED_TX_HANDLE_INVALID) {
+        furi_thread_flags_set(furi_thread_get_id(worker->thread), InfraredTxWorkerFlagRequest);
+    } else {
+        FURI_LOG_W(TAG, "Queue full, request rejected");
+    }
+
+    return handle;
+}
+
+InfraredTxHandle infrared_tx_worker_submit(
+    InfraredTxWorker* worker,
+    const InfraredSignal* signal,
+    InfraredTxPriority priority,
+    InfraredTxWorkerCallback callback,
+    void* context) {
+    return infrared_tx_worker_submit_verified(
+        worker, signal, priority, 0, false, callback, context);
+}
+
+InfraredTxHandle infrared_tx_worker_submit_verified(
+    InfraredTxWorker* worker,
+    const InfraredSignal* signal,
+    InfraredTxPriority priority,
+    size_t retries,
+    bool is_repeatable,
+    InfraredTxWorkerCallback callback,
+    void* context) {
+    furi_assert(signal);
+    return infrared_tx_worker_enqueue(
+        worker, signal, NULL, 0, priority, retries, is_repeatable, callback, context);
+}
+
+InfraredTxHandle infrared_tx_worker_submit_burst(
+    InfraredTxWorker* worker,
+    const InfraredSignalBurstItem* items,
+    size_t item_count,
+    InfraredTxPriority priority,
+    InfraredTxWorkerCallback callback,
+    void* context) {
+    furi_assert(items);
+    furi_assert(item_count > 0);
+    return infrared_tx_worker_enqueue(
+        worker, NULL, items, item_count, priority, 0, false, callback, context);
+}
+
+InfraredTxStatus infrared_tx_worker_get_status(InfraredTxWorker* worker, InfraredTxHandle handle) {
+    const size_t index = handle & INFRARED_TX_WORKER_SLOT_MASK;
+    const uint32_t generation = handle >> INFRARED_TX_WORKER_SLOT_BITS;
+
+    furi_check(index < INFRARED_TX_WORKER_QUEUE_SIZE);
+    furi_check(generation != 0);
+
+    furi_check(furi_mutex_acquire(worker->mutex, FuriWaitForever) == FuriStatusOk);
+    const InfraredTxWorkerSlot* slot = &worker->slots[index];
+    const InfraredTxStatus status =
+        slot->generation == generation ? slot->status : InfraredTxStatusUnknown;
+    furi_mutex_release(worker->mutex);
+
+    return status;
+}
+
+void infrared_tx_worker_get_stats(InfraredTxWorker* worker, InfraredTxWorkerStats* stats) {
+    furi_check(furi_mutex_acquire(worker->mutex, FuriWaitForever) == FuriStatusOk);
+    *stats = worker->stats;
+    furi_mutex_release(worker->mutex);
+}
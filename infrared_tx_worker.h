@@ -0,0 +1,239 @@
+/**
+ * @file infrared_tx_worker.h
+ * @brief Infrared transmit worker.
+ *
+ * The worker owns the infrared transmitter: it runs in its own thread and
+ * transmits signals submitted from any thread, in priority order. Submitting a
+ * request never blocks; it returns a handle that can be used to query the
+ * request status, and an optional callback is called once it is sent.
+ *
+ * Requests can also be verified: after each transmission the worker listens
+ * through the infrared receiver for the signal to be heard back, repeated by the
+ * device or by a repeater. The receiver is off while transmitting, so the light
+ * of the transmission itself is never heard: only a signal starting after it
+ * ended counts. Signals that may safely be sent twice are sent again until they
+ * are heard back or the request runs out of retries; the others, such as a
+ * power toggle that a second frame would undo, are only listened for.
+ */
+#pragma once
+
+#include "event_trace.h"
+#include "infrared_signal.h"
+
+#define INFRARED_TX_WORKER_QUEUE_SIZE (16U)
+
+#define INFRARED_TX_HANDLE_INVALID (0UL)
+
+/**
+ * @brief Transmit request priority.
+ *
+ * Requests of higher priority are always sent before those of lower priority,
+ * requests of the same priority are sent in submission order.
+ */
+typedef enum {
+    InfraredTxPriorityScheduled, /**< Request made by a schedule or a timer. */
+    InfraredTxPriorityUser, /**< Request made on user input. */
+    InfraredTxPriorityCount,
+} InfraredTxPriority;
+
+/**
+ * @brief Transmit request status.
+ */
+typedef enum {
+    InfraredTxStatusPending, /**< The request is waiting in the queue. */
+    InfraredTxStatusSending, /**< The signal is being transmitted. */
+    InfraredTxStatusDone, /**< The signal has been transmitted, and heard back if verified. */
+    InfraredTxStatusUnconfirmed, /**< The signal has been transmitted, but was never heard back. */
+    InfraredTxStatusCancelled, /**< The request was dropped before being sent. */
+    InfraredTxStatusUnknown, /**< The request is no longer known: its slot has been reused. */
+} InfraredTxStatus;
+
+/**
+ * @brief Handle identifying a transmit request.
+ */
+typedef uint32_t InfraredTxHandle;
+
+/**
+ * @brief Transmit worker statistics.
+ *
+ * Wait times are measured from submission to the start of transmission.
+ */
+typedef struct {
+    size_t queue_depth; /**< Number of requests currently waiting. */
+    size_t max_queue_depth; /**< Highest number of requests ever waiting at once. */
+    uint32_t submitted; /**< Number of requests accepted. */
+    uint32_t rejected; /**< Number of requests refused because the queue was full. */
+    uint32_t sent; /**< Number of requests transmitted. */
+    uint32_t last_wait_ms; /**< Wait time of the last request transmitted. */
+    uint32_t max_wait_ms; /**< Longest wait time of any request transmitted. */
+    uint64_t total_wait_ms; /**< Sum of the wait times of all requests transmitted. */
+    uint32_t confirmed; /**< Number of verified requests heard back. */
+    uint32_t resent; /**< Number of times a verified request was sent again. */
+    uint32_t unconfirmed; /**< Number of verified requests never heard back. */
+} InfraredTxWorkerStats;
+
+/**
+ * @brief Transmit completion callback type.
+ *
+ * Called from the worker thread once the signal has been transmitted.
+ *
+ * @param[in] handle handle of the request that completed.
+ * @param[in] status InfraredTxStatusDone, or InfraredTxStatusUnconfirmed if the request was verified and not heard back.
+ * @param[in] context pointer to the user-defined context.
+ */
+typedef void (
+    *InfraredTxWorkerCallback)(InfraredTxHandle handle, InfraredTxStatus status, void* context);
+
+/**
+ * @brief InfraredTxWorker opaque type declaration.
+ */
+typedef struct InfraredTxWorker InfraredTxWorker;
+
+/**
+ * @brief Create a new InfraredTxWorker instance.
+ *
+ * @returns pointer to the instance created.
+ */
+InfraredTxWorker* infrared_tx_worker_alloc(void);
+
+/**
+ * @brief Delete an InfraredTxWorker instance. The worker must be stopped.
+ *
+ * @param[in,out] worker pointer to the instance to be deleted.
+ */
+void infrared_tx_worker_free(InfraredTxWorker* worker);
+
+/**
+ * @brief Record the start and end of every transmission into an event trace.
+ *
+ * Must be called before the worker is started. The worker thread is then the
+ * only one to use the given producer.
+ *
+ * @param[in,out] worker pointer to the instance to be set up.
+ * @param[in] trace pointer to the trace to record into, NULL to stop recording.
+ * @param[in] producer index of the producer reserved for the worker.
+ */
+void infrared_tx_worker_set_trace(InfraredTxWorker* worker, EventTrace* trace, size_t producer);
+
+/**
+ * @brief Enable the verification of requests submitted with retries.
+ *
+ * Must be called before the worker is started. The worker then owns the
+ * infrared receiver as well.
+ *
+ * @param[in,out] worker pointer to the instance to be set up.
+ * @param[in] listen_ms time to wait for a signal to be heard back after sending it.
+ */
+void infrared_tx_worker_set_verification(InfraredTxWorker* worker, uint32_t listen_ms);
+
+/**
+ * @brief Start the worker thread.
+ *
+ * @param[in,out] worker pointer to the instance to be started.
+ */
+void infrared_tx_worker_start(InfraredTxWorker* worker);
+
+/**
+ * @brief Stop the worker thread.
+ *
+ * The transmission in progress, if any, is completed. Requests still in the queue
+ * are cancelled and their callbacks are not called.
+ *
+ * @param[in,out] worker pointer to the instance to be stopped.
+ */
+void infrared_tx_worker_stop(InfraredTxWorker* worker);
+
+/**
+ * @brief Submit a signal for transmission, without blocking.
+ *
+ * The signal is not copied and must stay valid until the request completes.
+ *
+ * @param[in,out] worker pointer to the instance to submit to.
+ * @param[in] signal pointer to the signal to be transmitted.
+ * @param[in] priority priority of the request.
+ * @param[in] callback pointer to the function called once the signal is sent, may be NULL.
+ * @param[in] context pointer to the user-defined context passed to the callback.
+ * @returns handle of the request, or INFRARED_TX_HANDLE_INVALID if the queue is full.
+ */
+InfraredTxHandle infrared_tx_worker_submit(
+    InfraredTxWorker* worker,
+    const InfraredSignal* signal,
+    InfraredTxPriority priority,
+    InfraredTxWorkerCallback callback,
+    void* context);
+
+/**
+ * @brief Submit a signal for transmission and verification, without blocking.
+ *
+ * Same as infrared_tx_worker_submit(), except that if verification is enabled
+ * and retries is not 0, the worker listens for the signal to be heard back after
+ * sending it. If the signal is repeatable, it is sent again, up to retries times,
+ * until it is. The callback is called once it is heard, or once the worker gave
+ * up listening.
+ *
+ * A signal that is not repeatable is never sent again, as a device that did get
+ * it but was not heard would take the second frame as another press.
+ *
+ * @param[in,out] worker pointer to the instance to submit to.
+ * @param[in] signal pointer to the signal to be transmitted.
+ * @param[in] priority priority of the request.
+ * @param[in] retries maximum number of times the signal is sent again, 0 not to verify it.
+ * @param[in] is_repeatable whether sending the signal twice does the same as sending it once.
+ * @param[in] callback pointer to the function called once the request completes, may be NULL.
+ * @param[in] context pointer to the user-defined context passed to the callback.
+ * @returns handle of the request, or INFRARED_TX_HANDLE_INVALID if the queue is full.
+ */
+InfraredTxHandle infrared_tx_worker_submit_verified(
+    InfraredTxWorker* worker,
+    const InfraredSignal* signal,
+    InfraredTxPriority priority,
+    size_t retries,
+    bool is_repeatable,
+    InfraredTxWorkerCallback callback,
+    void* context);
+
+/**
+ * @brief Submit several signals for transmission in a single burst, without blocking.
+ *
+ * The signals are sent back to back in one hardware session, with exact gaps,
+ * as infrared_signal_transmit_burst() does. Bursts are not verified. The items
+ * are not copied and must stay valid, along with the signals they point to,
+ * until the request completes.
+ *
+ * @param[in,out] worker pointer to the instance to submit to.
+ * @param[in] items pointer to the array of signals and gaps.
+ * @param[in] item_count number of elements in the items array, at least 1.
+ * @param[in] priority priority of the request.
+ * @param[in] callback pointer to the function called once the signals are sent, may be NULL.
+ * @param[in] context pointer to the user-defined context passed to the callback.
+ * @returns handle of the request, or INFRARED_TX_HANDLE_INVALID if the queue is full.
+ */
+InfraredTxHandle infrared_tx_worker_submit_burst(
+    InfraredTxWorker* worker,
+    const InfraredSignalBurstItem* items,
+    size_t item_count,
+    InfraredTxPriority priority,
+    InfraredTxWorkerCallback callback,
+    void* context);
+
+/**
+ * @brief Get the status of a transmit request.
+ *
+ * Requests are forgotten once their slot is reused; the outcome of a request
+ * whose slot has been reused can no longer be told, and it is reported as
+ * InfraredTxStatusUnknown. Use the completion callback to learn the outcome of
+ * every request.
+ *
+ * @param[in] worker pointer to the instance to be queried.
+ * @param[in] handle handle returned by infrared_tx_worker_submit().
+ * @returns status of the request.
+ */
+InfraredTxStatus infrared_tx_worker_get_status(InfraredTxWorker* worker, InfraredTxHandle handle);
+
+/**
+ * @brief Get a snapshot of the worker statistics.
+ *
+ * @param[in] worker pointer to the instance to be queried.
+ * @param[out] stats pointer to the structure to be filled.
+ */
+void infrared_tx_worker_get_stats(InfraredTxWorker* worker, InfraredTxWorkerStats* stats);
@@ -0,0 +1,290 @@
+#!/usr/bin/env python3
+"""Compile .ir signal files into a C header holding a constant signal table.
+
+The header defines, for a prefix such as ac_ir:
+- an enum with one value per signal, AcIrSignal<Name>, and AcIrSignalCount,
+- ac_ir_signal_names[], the names of the signals as written in the files,
+- ac_ir_signals[], the signals themselves as constant InfraredSignal instances,
+- ac_ir_signal_get(), returning a read-only view of a signal.
+
+Signals are checked the way infrared_signal_read() checks them, so that a bad
+file fails the build rather than the app. Names must be unique across files.
+
+Usage: ir_compile.py [--build-stamp stamp] --prefix ac_ir --output ac_ir_signals.h
+                     Ac.ir [more.ir ...]
+
+The header is only written if its contents change, so the script can be run on
+every build; --build-stamp is ignored, it lets a build tool that only tracks its
+command line run it every time.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+FILE_TYPE = "IR signals file"
+FILE_VERSION = 1
+
+# Address and command lengths in bits, as in the firmware protocol table.
+PROTOCOLS = {
+    "NEC": (8, 8),
+    "NECext": (16, 16),
+    "NEC42": (13, 8),
+    "NEC42ext": (26, 16),
+    "Samsung32": (8, 8),
+    "RC6": (8, 8),
+    "RC5": (5, 6),
+    "RC5X": (5, 7),
+    "SIRC": (5, 7),
+    "SIRC15": (8, 7),
+    "SIRC20": (13, 7),
+    "Kaseikyo": (26, 10),
+    "RCA": (4, 8),
+    "Pioneer": (8, 8),
+}
+
+# Same bounds as infrared_signal.c.
+MAX_TIMINGS_AMOUNT = 1024
+MIN_FREQUENCY = 10000
+MAX_FREQUENCY = 56000
+
+
+class CompileError(Exception):
+    pass
+
+
+class Signal:
+    def __init__(self, path, line, name):
+        self.path = path
+        self.line = line
+        self.name = name
+        self.fields = {}
+
+    def error(self, message):
+        return CompileError(f"{self.path}:{self.line}: {self.name}: {message}")
+
+    def get(self, key):
+        if key not in self.fields:
+            raise self.error(f"missing key '{key}'")
+        return self.fields[key]
+
+
+def parse_hex(signal, key):
+    # Four little-endian bytes, as written by flipper_format_write_hex().
+    try:
+        data = bytes.fromhex(signal.get(key))
+    except ValueError:
+        raise signal.error(f"'{key}' is not hexadecimal")
+    if len(data) != 4:
+        raise signal.error(f"'{key}' must be 4 bytes")
+    return int.from_bytes(data, "little")
+
+
+def parse_file(path):
+    with open(path, encoding="utf-8") as file:
+        lines = file.read().splitlines()
+
+    header = {}
+    signals = []
+    signal = None
+    for number, line in enumerate(lines, 1):
+        line = line.strip()
+        if not line or line.startswith("#"):
+            continue
+        key, separator, value = line.partition(":")
+        if not separator:
+            raise CompileError(f"{path}:{number}: expected 'key: value'")
+        key, value = key.strip(), value.strip()
+
+        if key == "name":
+            signal = Signal(path, number, value)
+            signals.append(signal)
+        elif signal is None:
+            header[key] = value
+        elif key in signal.fields:
+            raise signal.error(f"duplicate key '{key}'")
+        else:
+            signal.fields[key] = value
+
+    if header.get("Filetype") != FILE_TYPE or header.get("Version") != str(FILE_VERSION):
+        raise CompileError(f"{path}: not an '{FILE_TYPE}' version {FILE_VERSION}")
+
+    return signals
+
+
+def check_parsed(signal):
+    protocol = signal.get("protocol")
+    if protocol not in PROTOCOLS:
+        raise signal.error(f"unknown protocol '{protocol}'")
+    address = parse_hex(signal, "address")
+    command = parse_hex(signal, "command")
+
+    address_length, command_length = PROTOCOLS[protocol]
+    if address >> address_length:
+        raise signal.error(f"address 0x{address:X} is out of range for {protocol}")
+    if command >> command_length:
+        raise signal.error(f"command 0x{command:X} is out of range for {protocol}")
+
+    signal.protocol = protocol
+    signal.address = address
+    signal.command = command
+
+
+def check_raw(signal):
+    try:
+        signal.frequency = int(signal.get("frequency"))
+        signal.duty_cycle = float(signal.get("duty_cycle"))
+        signal.timings = [int(timing) for timing in signal.get("data").split()]
+    except ValueError:
+        raise signal.error("malformed raw signal")
+
+    if not MIN_FREQUENCY <= signal.frequency <= MAX_FREQUENCY:
+        raise signal.error(f"frequency {signal.frequency} is out of range")
+    if not 0.0 < signal.duty_cycle <= 1.0:
+        raise signal.error(f"duty cycle {signal.duty_cycle} is out of range")
+    if not 0 < len(signal.timings) <= MAX_TIMINGS_AMOUNT:
+        raise signal.error(f"{len(signal.timings)} timings, expected 1 to {MAX_TIMINGS_AMOUNT}")
+    if any(timing <= 0 or timing >= 1 << 32 for timing in signal.timings):
+        raise signal.error("timing out of range")
+
+
+def camel_case(text):
+    words = re.findall(r"[A-Za-z0-9]+", text)
+    return "".join(word[0].upper() + word[1:] for word in words)
+
+
+def check(signals):
+    identifiers = {}
+    for signal in signals:
+        kind = signal.get("type")
+        if kind == "parsed":
+            check_parsed(signal)
+        elif kind == "raw":
+            check_raw(signal)
+        else:
+            raise signal.error(f"unknown type '{kind}'")
+        signal.is_raw = kind == "raw"
+
+        signal.identifier = camel_case(signal.name)
+        if not signal.identifier or signal.identifier[0].isdigit():
+            raise signal.error("name does not make a C identifier")
+        if signal.identifier in identifiers:
+            other = identifiers[signal.identifier]
+            raise signal.error(f"same identifier as '{other.name}' at {other.path}:{other.line}")
+        identifiers[signal.identifier] = signal
+
+
+def c_string(text):
+    return '"' + text.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def generate(prefix, paths, signals):
+    type_name = camel_case(prefix) + "Signal"
+    sources = ", ".join(os.path.basename(path) for path in paths)
+    out = []
+
+    out.append("/**")
+    out.append(f" * @file {prefix}_signals.h")
+    out.append(f" * @brief Signals of {sources}, as a constant table.")
+    out.append(" *")
+    out.append(" * Generated at build time by tools/ir_compile.py, do not edit.")
+    out.append(" */")
+    out.append("#pragma once")
+    out.append("")
+    out.append('#include "infrared_signal_i.h"')
+    out.append("")
+
+    out.append("typedef enum {")
+    for signal in signals:
+        out.append(f"    {type_name}{signal.identifier},")
+    out.append(f"    {type_name}Count,")
+    out.append(f"}} {type_name};")
+    out.append("")
+
+    out.append(f"static const char* const {prefix}_signal_names[{type_name}Count] = {{")
+    for signal in signals:
+        out.append(f"    [{type_name}{signal.identifier}] = {c_string(signal.name)},")
+    out.append("};")
+    out.append("")
+
+    for signal in signals:
+        if not signal.is_raw:
+            continue
+        out.append(f"static const uint32_t {prefix}_signal_timings_{signal.identifier}[] = {{")
+        for start in range(0, len(signal.timings), 8):
+            row = ", ".join(str(timing) for timing in signal.timings[start : start + 8])
+            out.append(f"    {row},")
+        out.append("};")
+        out.append("")
+
+    out.append(f"static const InfraredSignal {prefix}_signals[{type_name}Count] = {{")
+    for signal in signals:
+        if signal.is_raw:
+            init = (
+                f"INFRARED_SIGNAL_RAW_INIT({prefix}_signal_timings_{signal.identifier}, "
+                f"{signal.frequency}, {signal.duty_cycle!r}f)"
+            )
+        else:
+            init = (
+                f"INFRARED_SIGNAL_PARSED_INIT(InfraredProtocol{signal.protocol}, "
+                f"0x{signal.address:08X}, 0x{signal.command:08X})"
+            )
+        out.append(f"    [{type_name}{signal.identifier}] = {init},")
+    out.append("};")
+    out.append("")
+
+    out.append("/**")
+    out.append(" * @brief Get a read-only view of a signal, without allocating anything.")
+    out.append(" *")
+    out.append(" * @param[in] signal signal to get.")
+    out.append(" * @returns pointer to the signal, valid for the lifetime of the app.")
+    out.append(" */")
+    out.append(
+        f"static inline const InfraredSignal* {prefix}_signal_get({type_name} signal) {{"
+    )
+    out.append(f"    return &{prefix}_signals[signal];")
+    out.append("}")
+
+    return "\n".join(out) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compile .ir files into a constant signal table.")
+    parser.add_argument("--prefix", required=True, help="prefix of the generated names, e.g. ac_ir")
+    parser.add_argument("--output", required=True, help="header file to write")
+    parser.add_argument("--build-stamp", help="ignored, makes the command line differ between builds")
+    parser.add_argument("inputs", nargs="+", help=".ir files to compile")
+    args = parser.parse_args()
+
+    if not re.fullmatch(r"[a-z][a-z0-9_]*", args.prefix):
+        parser.error("the prefix must be a lowercase C identifier")
+
+    try:
+        signals = []
+        for path in args.inputs:
+            signals.extend(parse_file(path))
+        if not signals:
+            raise CompileError("no signals found")
+        check(signals)
+    except (CompileError, OSError) as error:
+        print(f"ir_compile: {error}", file=sys.stderr)
+        return 1
+
+    header = generate(args.prefix, args.inputs, signals)
+
+    # Leave the file alone if it is unchanged, so that nothing gets rebuilt.
+    try:
+        with open(args.output, encoding="utf-8") as file:
+            if file.read() == header:
+                return 0
+    except OSError:
+        pass
+
+    with open(args.output, "w", encoding="utf-8") as file:
+        file.write(header)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())